@@ -21,6 +21,8 @@ class BaseHardwareInterface(object):
     LAP_SOURCE_API = 4
     LAP_SOURCE_LABEL_STRS = ["realtime", "manual", "recalc", "automatic", "API"]
 
+    PROVISIONAL_STATUS_LABEL_STRS = ["none", "pending", "confirmed", "retracted"]
+
     RACE_STATUS_READY = 0
     RACE_STATUS_STAGING = 3
     RACE_STATUS_RACING = 1
@@ -36,6 +38,7 @@ class BaseHardwareInterface(object):
         self.pass_record_callback = None # Function added in server.py
         self.new_enter_or_exit_at_callback = None # Function added in server.py
         self.node_crossing_callback = None # Function added in server.py
+        self.provisional_pass_callback = None # Function added in server.py
         self.nodes = []
         self.marshal_type = None
         self.ready_failure_msg = None
@@ -129,7 +132,7 @@ class BaseHardwareInterface(object):
                 item = upd_list[0]
                 node = item[0]
                 if node.node_lap_id != -1 and callable(self.pass_record_callback):    # (node, lap_time_absolute)
-                    self.pass_record_callback(node, item[2], BaseHardwareInterface.LAP_SOURCE_REALTIME, peak=node.pass_peak_rssi)  #pylint: disable=not-callable
+                    self.pass_record_callback(node, item[2], BaseHardwareInterface.LAP_SOURCE_REALTIME, peak=node.pass_peak_rssi, node_lap_id=item[1])  #pylint: disable=not-callable
                 node.node_lap_id = item[1]  # new_lap_id
 
             else:  # list contains multiple items; sort so processed in order by lap time
@@ -137,7 +140,7 @@ class BaseHardwareInterface(object):
                 for item in upd_list:
                     node = item[0]
                     if node.node_lap_id != -1 and callable(self.pass_record_callback):    # (node, lap_time_absolute)
-                        self.pass_record_callback(node, item[2], BaseHardwareInterface.LAP_SOURCE_REALTIME, peak=node.pass_peak_rssi)  #pylint: disable=not-callable
+                        self.pass_record_callback(node, item[2], BaseHardwareInterface.LAP_SOURCE_REALTIME, peak=node.pass_peak_rssi, node_lap_id=item[1])  #pylint: disable=not-callable
                     node.node_lap_id = item[1]  # new_lap_id
 
     #
@@ -15,6 +15,7 @@ class Node:
         self.firmware_version_str = None
         self.firmware_proctype_str = None
         self.firmware_timestamp_str = None
+        self.descriptor_loaded_flag = False  # True if values were fetched via READ_NODE_DESCRIPTOR
         self.frequency = 0
         self.current_rssi = 0
         self.node_peak_rssi = 0
@@ -35,6 +36,36 @@ class Node:
         self.exit_at_timestamp = 0
         self.debug_pass_count = 0
         self.bad_rssi_count = 0
+        self.lap_stats_delta_capable = False  # True if transport supports READ_LAP_STATS_DELTA
+        self.lap_stats_data = None            # values from last full lap-stats read (updated via deltas)
+        self.lap_stats_generation = None      # generation counter from last READ_LAP_STATS_DELTA response
+        self.time_sync_next_time = 0          # time for next time-sync exchange
+        self.time_sync_recv_ms = 0            # server time when last time-sync response received
+        self.time_sync_offset_ms = 0          # node-estimated offset (server minus node time)
+        self.time_sync_skew_ppm = 0           # node-estimated skew of server vs node clock
+        self.time_sync_bound_ms = 0xFFFF      # node-estimated error bound (0xFFFF if not synced)
+        self.lap_sync_bound_ms = 0xFFFF       # error bound for last synchronized lap time
+        self.race_epoch_id = 0                # ID of race epoch set on node (0 if none)
+        self.race_epoch_time = 0              # monotonic time of race epoch set on node
+        self.provisional_revision = None      # revision of last provisional pass read from node
+        self.provisional_status = 0           # status of provisional pass (PROVISIONAL_... value)
+        self.provisional_lap_id = -1          # lap ID that provisional pass will have when confirmed
+        self.provisional_peak_rssi = 0
+        self.provisional_timestamp = 0        # monotonic time of provisional pass
+        self.calibration_end_time = 0         # time when node calibration capture should be done (0 if none)
+        self.calibration_give_up_time = 0     # time after which unfinished calibration is abandoned
+        self.calibration_apply_flag = False   # node applies suggested EnterAt/ExitAt when capture done
+        self.calibration_result = None        # values read from last finished calibration capture
+        self.noise_floor = 0                  # node's noise-floor estimate (0 if not yet known)
+        self.noise_floor_next_time = 0        # time for next read of noise floor (None if not floating)
+        self.threshold_float_max = 0          # max drift of EnterAt/ExitAt with noise floor (0 = fixed)
+        self.effective_enter_at_level = 0     # EnterAt level in use by node
+        self.effective_exit_at_level = 0      # ExitAt level in use by node
+        self.trace_mode = 0                   # RSSI trace streaming mode (RSSI_TRACE_... value)
+        self.trace_next_seq = 0               # sequence number expected for next trace sample
+        self.trace_sample_count = 0           # trace samples received since streaming started
+        self.trace_dropped_count = 0          # trace samples lost (node queue full or packet lost)
+        self.trace_logger = None              # file that trace samples are written to
 
         self.enter_at_level = 0
         self.exit_at_level = 0
@@ -42,6 +73,9 @@ class Node:
         self.start_thresh_lower_flag = False  # True while EnterAt/ExitAt lowered at start of race
         self.start_thresh_lower_time = 0      # time when EnterAt/ExitAt should be restored
 
+        self.bcast_frequency = None           # frequency sent via broadcast (not yet confirmed)
+        self.bcast_frequency_time = 0         # time when broadcast frequency was sent
+
         self.cap_enter_at_flag = False
         self.cap_enter_at_total = 0
         self.cap_enter_at_count = 0
@@ -112,6 +146,9 @@ class Node:
             'pass_nadir_rssi': self.pass_nadir_rssi
         }
 
+    def get_bcast_table_index(self):
+        return -1  # entry in WRITE_BCAST_... tables (-1 if broadcasts not supported)
+
     def is_valid_rssi(self, value):
         return value > 0 and value < self.max_rssi_value
 
@@ -14,6 +14,7 @@ TEST_RX_REGISTER = 0x04     # Check if register on RX module matches set frequen
 READ_LAP_STATS = 0x05
 READ_LAP_PASS_STATS = 0x0D
 READ_LAP_EXTREMUMS = 0x0E
+READ_LAP_STATS_DELTA = 0x0F  # read lap-stats fields changed since previous read
 READ_RHFEAT_FLAGS = 0x11     # read feature flags value
 # READ_FILTER_RATIO = 0x20    # node API_level>=10 uses 16-bit value
 READ_REVISION_CODE = 0x22    # read NODE_API_LEVEL and verification value
@@ -22,6 +23,8 @@ READ_NODE_RSSI_NADIR = 0x24  # read 'nodeRssiNadir' value
 READ_ENTER_AT_LEVEL = 0x31
 READ_EXIT_AT_LEVEL = 0x32
 READ_TIME_MILLIS = 0x33      # read current 'millis()' time value
+READ_RECOMPUTED_LAPS = 0x34  # read passes found by replaying heat history (see WRITE_RECOMPUTE_LAPS)
+READ_CROSSING_DETECTOR = 0x35  # read detector engine, limits and matched-filter template points
 READ_MULTINODE_COUNT = 0x39  # read # of nodes handled by processor
 READ_CURNODE_INDEX = 0x3A    # read index of current node for processor
 READ_NODE_SLOTIDX = 0x3C     # read node slot index (for multi-node setup)
@@ -29,11 +32,37 @@ READ_FW_VERSION = 0x3D       # read firmware version string
 READ_FW_BUILDDATE = 0x3E     # read firmware build date string
 READ_FW_BUILDTIME = 0x3F     # read firmware build time string
 READ_FW_PROCTYPE = 0x40      # read node processor type
+READ_NODE_DESCRIPTOR = 0x41  # read API level, features, firmware info and settings for all nodes
+READ_NODE_SETTINGS = 0x42    # read frequency, EnterAt and ExitAt values in one response
+READ_TIME_SYNC = 0x43        # read response for time-sync exchange (and current estimate)
+READ_LAP_SYNC_TIME = 0x44    # read last lap timestamp in synchronized server time (with micros)
+READ_LAP_EPOCH_OFFSET = 0x45  # read last lap time relative to race epoch (ms and micros)
+READ_PROVISIONAL_PASS = 0x4A  # read status and time of pass raised at peak detection (before exit)
+READ_CALIBRATION = 0x4B      # read RSSI distribution and suggested EnterAt/ExitAt from calibration capture
+READ_NOISE_FLOOR = 0x4C      # read noise-floor estimate and EnterAt/ExitAt levels in use
+READ_RSSI_WINDOWS = 0x4D     # read max and min RSSI over recent sliding windows (e.g. 1, 10, 60 s)
+READ_RSSI_PYRAMID = 0x4E     # read entries of RSSI summary tier selected by WRITE_RSSI_PYRAMID_QUERY
+READ_RSSI_TRACE = 0x4F       # read next packet of delta/run-length encoded trace samples
+READ_PASS_ENVELOPE = 0x50    # read RSSI envelope of pass selected by WRITE_PASS_ENVELOPE_QUERY
 
 WRITE_FREQUENCY = 0x51       # Sets frequency (2 byte)
+WRITE_BCAST_FREQUENCY = 0x52   # broadcast table of frequencies (I2C general call)
+WRITE_TIME_SYNC = 0x5A       # start time-sync exchange (server send time, previous receive time)
+WRITE_RACE_EPOCH = 0x5B      # race start time (server ms), server send time and epoch ID
+WRITE_PROVISIONAL_DROP = 0x5C  # RSSI drop below pass peak that raises provisional pass (0 = off)
+WRITE_CALIBRATE = 0x5D       # start calibration capture (seconds, CALIBRATE_FLAG_... values)
+WRITE_THRESHOLD_FLOAT = 0x5E  # max drift of EnterAt/ExitAt with noise floor (0 = fixed levels)
+WRITE_RSSI_PYRAMID_QUERY = 0x5F  # select tier and start offset for READ_RSSI_PYRAMID
+WRITE_RSSI_TRACE_MODE = 0x60  # start or stop trace streaming (RSSI_TRACE_... value)
+WRITE_PASS_ENVELOPE_QUERY = 0x61  # select lap number and start point for READ_PASS_ENVELOPE
+WRITE_RECOMPUTE_LAPS = 0x62  # set EnterAt/ExitAt and start pass for READ_RECOMPUTED_LAPS
+WRITE_HISTORY_PROMINENCE = 0x63  # RSSI reversal that declares a history peak/nadir (1 = every reversal)
+WRITE_CROSSING_DETECTOR = 0x64  # select crossing detector (DETECTOR_... value), flags and limits
+WRITE_DETECTOR_TEMPLATE = 0x65  # write matched-filter template points and start point for READ_CROSSING_DETECTOR
 # WRITE_FILTER_RATIO = 0x70   # node API_level>=10 uses 16-bit value
 WRITE_ENTER_AT_LEVEL = 0x71
 WRITE_EXIT_AT_LEVEL = 0x72
+WRITE_BCAST_ENTER_EXIT = 0x73  # broadcast table of EnterAt/ExitAt values (I2C general call)
 WRITE_CURNODE_INDEX = 0x7A  # write index of current node for processor
 SEND_STATUS_MESSAGE = 0x75  # send status message from server to node
 FORCE_END_CROSSING = 0x78   # kill current crossing flag regardless of RSSI value
@@ -42,6 +71,120 @@ JUMP_TO_BOOTLOADER = 0x7E   # jump to bootloader for flash update
 LAPSTATS_FLAG_CROSSING = 0x01  # crossing is in progress
 LAPSTATS_FLAG_PEAK = 0x02      # reported extremum is peak
 
+# bits in READ_LAP_STATS_DELTA mask, with offset and size of each field in the
+#  (READ_LAP_PASS_STATS + READ_LAP_EXTREMUMS) layout; fields are sent in this order
+LAPDELTA_LAP = 0x01       # lap number and ms since lap
+LAPDELTA_RSSI = 0x02      # current RSSI
+LAPDELTA_PEAKS = 0x04     # node peak and last-pass peak RSSI
+LAPDELTA_NADIRS = 0x08    # last-pass nadir and node nadir RSSI
+LAPDELTA_FLAGS = 0x10     # LAPSTATS_FLAG_... value
+LAPDELTA_EXTREMUM = 0x20  # pending extremum
+LAPDELTA_LOOPTIME = 0x40  # loop time
+LAPDELTA_FIELDS = ((LAPDELTA_LAP, 0, 3), (LAPDELTA_RSSI, 3, 1), (LAPDELTA_PEAKS, 4, 2), \
+                   (LAPDELTA_NADIRS, 9, 2), (LAPDELTA_FLAGS, 8, 1), (LAPDELTA_EXTREMUM, 11, 5), \
+                   (LAPDELTA_LOOPTIME, 6, 2))
+LAPSTATS_DELTA_MIN_API_LEVEL = 39
+
+# time sync:  server sends its time, node replies with its receive/send times;
+#  node estimates offset and skew and reports lap times in server time
+TIME_SYNC_MIN_API_LEVEL = 40
+TIME_SYNC_INTERVAL_SECS = 1.0
+TIME_SYNC_RESPONSE_SIZE = 17
+TIME_SYNC_BOUND_UNKNOWN = 0xFFFF
+LAP_SYNC_MICROS_MIN_API_LEVEL = 41  # READ_LAP_SYNC_TIME includes sub-millisecond part
+
+# race epoch:  server sends race start time, node reports laps as offsets from it
+RACE_EPOCH_MIN_API_LEVEL = 42
+RACE_EPOCH_ID_NONE = 0
+RACE_EPOCH_OFFSET_NONE = 0x7FFFFFFF
+
+# provisional pass:  node reports pass as soon as RSSI falls well below the pass
+#  peak, then confirms it (with final timestamp) when the crossing ends
+PROVISIONAL_PASS_MIN_API_LEVEL = 51
+PROVISIONAL_NONE = 0
+PROVISIONAL_PENDING = 1
+PROVISIONAL_CONFIRMED = 2
+PROVISIONAL_RETRACTED = 3
+
+# node calibration:  node captures RSSI distribution and fly-by peaks at full
+#  sample rate, then suggests (and optionally applies) EnterAt/ExitAt levels
+CALIBRATION_MIN_API_LEVEL = 52
+CALIBRATION_RESPONSE_SIZE = 15
+CALIBRATE_FLAG_APPLY = 0x01
+CALIBRATION_IDLE = 0
+CALIBRATION_CAPTURING = 1
+CALIBRATION_DONE = 2
+CALIBRATION_NO_PASSES = 3
+CALIBRATION_RETRY_SECS = 1.0     # wait before reading again if capture not finished
+CALIBRATION_TIMEOUT_SECS = 10.0  # give up this long after capture should have finished
+
+# noise floor:  node tracks noise floor and (if enabled) moves EnterAt/ExitAt
+#  with it, by up to the max drift set by the server
+NOISE_FLOOR_MIN_API_LEVEL = 53
+NOISE_FLOOR_READ_INTERVAL_SECS = 2.0
+
+# RSSI windows:  node reports max and min RSSI over sliding windows of recent samples
+RSSI_WINDOWS_MIN_API_LEVEL = 54
+RSSI_WINDOWS_MAX_COUNT = 3   # windows in response (count byte, then 3 bytes per window)
+
+# RSSI pyramid:  node keeps max/min/mean RSSI summaries at several resolutions
+#  (tiers of 1 ms, 10 ms, 100 ms and 1 s entries); server selects tier and start
+#  offset, then reads a block of entries (newest first)
+RSSI_PYRAMID_MIN_API_LEVEL = 55
+RSSI_PYRAMID_TIER_COUNT = 4
+RSSI_PYRAMID_READ_ENTRIES_STM32 = 16  # entries per response (fewer on Arduino nodes, for I2C)
+RSSI_PYRAMID_READ_ENTRIES_ARDUINO = 7
+
+# RSSI trace:  node queues every filtered (or raw) sample and the server reads
+#  them in packets of delta/run-length encoded data; samples are written to
+#  'trace_N.csv' (enabled via set_rssi_trace_mode or RH_TRACE_NODE_N=filtered|raw)
+RSSI_TRACE_MIN_API_LEVEL = 56
+RSSI_TRACE_OFF = 0
+RSSI_TRACE_FILTERED = 1
+RSSI_TRACE_RAW = 2
+RSSI_TRACE_HEADER_SIZE = 7
+RSSI_TRACE_PACKET_SIZE_STM32 = 64
+RSSI_TRACE_PACKET_SIZE_ARDUINO = 31  # fits 32-byte I2C transfer
+RSSI_TRACE_MAX_READS = 16            # packets read per node per update
+RSSI_TRACE_SAMPLE_SECS = 0.001       # time between samples
+TRACE_CODE_RUN = 0x80
+TRACE_CODE_ABS = 0xC0
+TRACE_DELTA_BIAS = 64
+
+# pass envelopes:  node keeps a downsampled RSSI envelope (approach through exit)
+#  for each of its most recent passes, retrievable by node lap ID
+PASS_ENVELOPE_MIN_API_LEVEL = 57
+PASS_ENVELOPE_HEADER_SIZE = 7
+PASS_ENVELOPE_READ_POINTS_STM32 = 64  # points per response (fewer on Arduino nodes, for I2C)
+PASS_ENVELOPE_READ_POINTS_ARDUINO = 24
+PASS_ENVELOPE_MAX_KEPT = 8            # most passes kept by any node
+
+# heat history:  STM32 nodes keep the peaks and nadirs of the filtered RSSI since
+#  the race epoch, and can replay them through the crossing logic with other levels
+RECOMPUTE_LAPS_MIN_API_LEVEL = 58
+RECOMPUTE_HEADER_SIZE = 9
+RECOMPUTE_READ_PASSES = 16
+RECOMPUTE_PASS_SIZE = 5
+RECOMPUTE_FLAG_TRUNCATED = 0x01  # oldest history was dropped (node buffer full)
+
+# history prominence:  node only reports peaks/nadirs that RSSI has since moved
+#  away from by this much, so noise wiggles are not sent as history
+HISTORY_PROMINENCE_MIN_API_LEVEL = 59
+
+# crossing detectors:  node decides crossings with EnterAt/ExitAt levels, or by
+#  correlating the RSSI with a pass-shape template (matched filter) that may be
+#  written or learned from detected passes
+CROSSING_DETECTOR_MIN_API_LEVEL = 60
+DETECTOR_THRESHOLD = 0
+DETECTOR_MATCHED = 1
+DETECTOR_FLAG_LEARN = 0x01
+DETECTOR_HEADER_SIZE = 8
+DETECTOR_WRITE_POINTS = 8
+DETECTOR_READ_POINTS = 16
+DETECTOR_TEMPLATE_DEFAULT = 0xFF  # template start point that restores default template
+DETECTOR_DEFAULT_MIN_CORR = 80    # percent
+DETECTOR_DEFAULT_MIN_RISE = 30
+
 # upper-byte values for SEND_STATUS_MESSAGE payload (lower byte is data)
 STATMSG_SDBUTTON_STATE = 0x01    # shutdown button state (1=pressed, 0=released)
 STATMSG_SHUTDOWN_STARTED = 0x02  # system shutdown started
@@ -49,6 +192,18 @@ STATMSG_SERVER_IDLE = 0x03       # server-idle tick message
 
 FW_TEXT_BLOCK_SIZE = 16     # length of data returned by 'READ_FW_...' fns
 
+# READ_NODE_DESCRIPTOR response:  header (revision code, feature flags, node count,
+#  firmware strings) followed by an entry for each node
+NODE_DESCRIPTOR_HEADER_SIZE = 5 + 4 * FW_TEXT_BLOCK_SIZE
+NODE_DESCRIPTOR_ENTRY_SIZE = 7
+NODE_DESCRIPTOR_MIN_API_LEVEL = 37
+
+# payload for WRITE_BCAST_... commands is a mask byte (bit set for each entry present)
+#  followed by a table entry for each node (I2C nodes use entry (address-8)/2)
+BCAST_TABLE_SIZE = 8
+BCAST_MIN_API_LEVEL = 38
+RX_FREQ_SETTLE_SECS = 0.03  # delay after writing freq before reading RX register
+
 # prefix strings for finding text values in firmware '.bin' files
 FW_VERSION_PREFIXSTR = "FIRMWARE_VERSION: "
 FW_BUILDDATE_PREFIXSTR = "FIRMWARE_BUILDDATE: "
@@ -59,6 +214,13 @@ FW_PROCTYPE_PREFIXSTR = "FIRMWARE_PROCTYPE: "
 RHFEAT_STM32_MODE = 0x0004      # STM 32-bit processor running multiple nodes
 RHFEAT_JUMPTO_BOOTLDR = 0x0008  # JUMP_TO_BOOTLOADER command supported
 RHFEAT_IAP_FIRMWARE = 0x0010    # in-application programming of firmware supported
+RHFEAT_CALIBRATION = 0x0020     # WRITE_CALIBRATE capture supported
+RHFEAT_RSSI_WINDOWS = 0x0040    # READ_RSSI_WINDOWS supported
+RHFEAT_RSSI_PYRAMID = 0x0080    # READ_RSSI_PYRAMID supported
+RHFEAT_RSSI_TRACE = 0x0100      # RSSI trace streaming supported
+RHFEAT_PASS_ENVELOPE = 0x0200   # READ_PASS_ENVELOPE supported
+RHFEAT_HEAT_HISTORY = 0x0400    # WRITE_RECOMPUTE_LAPS supported
+RHFEAT_MATCH_DETECTOR = 0x0800  # matched-filter crossing detector supported
 
 UPDATE_SLEEP = float(os.environ.get('RH_UPDATE_INTERVAL', '0.1')) # Main update loop delay
 MAX_RETRY_COUNT = 4 # Limit of I/O retries
@@ -120,6 +282,85 @@ def unpack_rssi(node, data):
     else:
         return unpack_16(data) / 2
 
+def decode_rssi_trace(data, length):
+    '''Returns list of RSSI values decoded from READ_RSSI_TRACE packet data.'''
+    values = []
+    if length <= 0:
+        return values
+    values.append(data[0])
+    i = 1
+    while i < length:
+        code = data[i]
+        if code < TRACE_CODE_RUN:  # delta from previous value
+            values.append((values[-1] + code - TRACE_DELTA_BIAS) & 0xFF)
+        elif code < TRACE_CODE_ABS:  # previous value repeated
+            values.extend([values[-1]] * ((code & 0x3F) + 1))
+        else:  # absolute value
+            i += 1
+            values.append(data[i])
+        i += 1
+    return values
+
+def server_time_ms():
+    '''Returns server time value used for node time sync (32-bit ms).'''
+    return int(monotonic() * 1000) & 0xFFFFFFFF
+
+def server_time_ms_to_monotonic(time_ms):
+    '''Converts (past) server time value from 'server_time_ms()' to monotonic seconds.'''
+    now_ms = int(monotonic() * 1000)
+    return (now_ms - ((now_ms - time_ms) & 0xFFFFFFFF)) / 1000.0
+
+def lap_stats_delta_size(mask):
+    '''Returns size of fields following READ_LAP_STATS_DELTA header with given mask.'''
+    return sum(size for bit, _offset, size in LAPDELTA_FIELDS if mask & bit)
+
+def unpack_text_block(data):
+    return bytearray(data[:FW_TEXT_BLOCK_SIZE]).decode("utf-8").rstrip('\0')
+
+
+class NodeDescriptor:
+    '''Values returned by the READ_NODE_DESCRIPTOR command.'''
+    def __init__(self, data):
+        self.rev_val = unpack_16(data)
+        self.api_level = self.rev_val & 0xFF
+        self.rhfeature_flags = unpack_16(data[2:])
+        self.node_count = unpack_8(data[4:])
+        offset = 5
+        self.firmware_version_str = unpack_text_block(data[offset:])
+        offset += FW_TEXT_BLOCK_SIZE
+        self.firmware_proctype_str = unpack_text_block(data[offset:])
+        offset += FW_TEXT_BLOCK_SIZE
+        self.firmware_timestamp_str = unpack_text_block(data[offset:])
+        offset += FW_TEXT_BLOCK_SIZE
+        self.firmware_timestamp_str += " " + unpack_text_block(data[offset:])
+        offset += FW_TEXT_BLOCK_SIZE
+        self.entries = []
+        for _ in range(self.node_count):
+            self.entries.append({
+                'slot_index': unpack_8(data[offset:]),
+                'frequency': unpack_16(data[offset+1:]),
+                'enter_at_level': unpack_8(data[offset+3:]),
+                'exit_at_level': unpack_8(data[offset+4:]),
+                'node_peak_rssi': unpack_8(data[offset+5:]),
+                'node_nadir_rssi': unpack_8(data[offset+6:])
+            })
+            offset += NODE_DESCRIPTOR_ENTRY_SIZE
+
+    def apply_to_node(self, node, entry_index):
+        entry = self.entries[entry_index]
+        node.api_level = self.api_level
+        node.rhfeature_flags = self.rhfeature_flags
+        node.firmware_version_str = self.firmware_version_str
+        node.firmware_proctype_str = self.firmware_proctype_str
+        node.firmware_timestamp_str = self.firmware_timestamp_str
+        node.multi_node_slot_index = entry['slot_index']
+        node.frequency = entry['frequency']
+        node.enter_at_level = entry['enter_at_level']
+        node.exit_at_level = entry['exit_at_level']
+        node.node_peak_rssi = entry['node_peak_rssi']
+        node.node_nadir_rssi = entry['node_nadir_rssi']
+        node.descriptor_loaded_flag = True
+
 
 class RHInterface(BaseHardwareInterface):
     def __init__(self, *args, **kwargs):
@@ -132,6 +373,7 @@ class RHInterface(BaseHardwareInterface):
         self.update_thread = None      # Thread for running the main update loop
         self.fwupd_serial_obj = None   # serial object for in-app update of node firmware
         self.info_node_obj = None      # node object containing info (like node version, etc)
+        self.race_epoch_id = RACE_EPOCH_ID_NONE  # ID sent with last WRITE_RACE_EPOCH
 
         self.intf_read_block_count = 0  # number of blocks read by all nodes
         self.intf_read_error_count = 0  # number of read errors for all nodes
@@ -146,16 +388,18 @@ class RHInterface(BaseHardwareInterface):
         self.data_loggers = {}
         if len(self.nodes) > 0:
             for node in self.nodes:
-                node.frequency = self.get_value_16(node, READ_FREQUENCY)
+                if not node.descriptor_loaded_flag:  # values not already fetched via READ_NODE_DESCRIPTOR
+                    node.frequency = self.get_value_16(node, READ_FREQUENCY)
                 if not node.frequency:
                     raise RuntimeError('Unable to read frequency value from node {0}'.format(node.index+1))
                 node.init()
                 if node.api_level >= 10:
-                    node.node_peak_rssi = self.get_value_rssi(node, READ_NODE_RSSI_PEAK)
-                    if node.api_level >= 13:
-                        node.node_nadir_rssi = self.get_value_rssi(node, READ_NODE_RSSI_NADIR)
-                    node.enter_at_level = self.get_value_rssi(node, READ_ENTER_AT_LEVEL)
-                    node.exit_at_level = self.get_value_rssi(node, READ_EXIT_AT_LEVEL)
+                    if not node.descriptor_loaded_flag:
+                        node.node_peak_rssi = self.get_value_rssi(node, READ_NODE_RSSI_PEAK)
+                        if node.api_level >= 13:
+                            node.node_nadir_rssi = self.get_value_rssi(node, READ_NODE_RSSI_NADIR)
+                        node.enter_at_level = self.get_value_rssi(node, READ_ENTER_AT_LEVEL)
+                        node.exit_at_level = self.get_value_rssi(node, READ_EXIT_AT_LEVEL)
                     if node.multi_node_index < 0:  # (multi-nodes will always have default values)
                         logger.debug("Node {}: Freq={}, EnterAt={}, ExitAt={}".format(\
                                      node.index+1, node.frequency, node.enter_at_level, node.exit_at_level))
@@ -167,17 +411,24 @@ class RHInterface(BaseHardwareInterface):
                 else:
                     logger.warning("Node {} has obsolete API_level ({})".format(node.index+1, node.api_level))
                 if node.api_level >= 32:
-                    flags_val = self.get_value_16(node, READ_RHFEAT_FLAGS)
+                    flags_val = node.rhfeature_flags if node.descriptor_loaded_flag else \
+                                self.get_value_16(node, READ_RHFEAT_FLAGS)
                     if flags_val:
                         node.rhfeature_flags = flags_val
                         # if first node that supports in-app fw update then save port name
                         if (not self.fwupd_serial_obj) and hasattr(node, 'serial') and node.serial and \
                                 (node.rhfeature_flags & (RHFEAT_STM32_MODE|RHFEAT_IAP_FIRMWARE)) != 0:
                             self.set_fwupd_serial_obj(node.serial)
+
+                trace_env = os.environ.get("RH_TRACE_NODE_{0}".format(node.index+1))
+                if trace_env:
+                    self.set_rssi_trace_mode(node.index, RSSI_TRACE_RAW if trace_env.lower() == 'raw' \
+                                             else RSSI_TRACE_FILTERED)
         else:
             node = self.info_node_obj  # handle S32_BPill board with no receiver modules attached
             if node and node.api_level >= 32:
-                flags_val = self.get_value_16(node, READ_RHFEAT_FLAGS)
+                flags_val = node.rhfeature_flags if node.descriptor_loaded_flag else \
+                            self.get_value_16(node, READ_RHFEAT_FLAGS)
                 if flags_val:
                     node.rhfeature_flags = flags_val
                     # if node supports in-app fw update then save port name
@@ -225,12 +476,30 @@ class RHInterface(BaseHardwareInterface):
         cross_list = []  # list of nodes with crossing-flag changes
         startThreshLowerNode = None
         for node in self.nodes:
+            # one time-sync exchange per node processor
+            if node.api_level >= TIME_SYNC_MIN_API_LEVEL and node.multi_node_index <= 0 and \
+                                monotonic() >= node.time_sync_next_time:
+                self.sync_node_time(node)
+            if node.calibration_end_time and monotonic() >= node.calibration_end_time:
+                self.finish_node_calibration(node)
+            if node.api_level >= NOISE_FLOOR_MIN_API_LEVEL and node.noise_floor_next_time is not None and \
+                                monotonic() >= node.noise_floor_next_time:
+                self.read_noise_floor(node)
+            if node.trace_mode != RSSI_TRACE_OFF:
+                self.read_rssi_trace(node)
             if node.frequency:
                 if node.api_valid_flag or node.api_level >= 5:
                     if node.api_level >= 32:
-                        data = node.read_block(self, READ_LAP_PASS_STATS, 8)
-                        if data != None:
-                            data.extend(node.read_block(self, READ_LAP_EXTREMUMS, 8))
+                        data = None
+                        if node.lap_stats_data is not None:  # only changes needed after full read
+                            data = self.read_lap_stats_delta(node)
+                        if data is None:
+                            data = node.read_block(self, READ_LAP_PASS_STATS, 8)
+                            if data != None:
+                                data.extend(node.read_block(self, READ_LAP_EXTREMUMS, 8))
+                                if node.lap_stats_delta_capable and node.api_level >= LAPSTATS_DELTA_MIN_API_LEVEL:
+                                    node.lap_stats_data = bytearray(data)
+                                    node.lap_stats_generation = None
                     elif node.api_level >= 21:
                         data = node.read_block(self, READ_LAP_STATS, 16)
                     elif node.api_level >= 18:
@@ -368,8 +637,19 @@ class RHInterface(BaseHardwareInterface):
                             node.pass_peak_rssi = unpack_rssi(node, data[11:])
                             node.loop_time = unpack_32(data[13:])
 
+                        if lap_id != node.node_lap_id and node.api_level >= TIME_SYNC_MIN_API_LEVEL:
+                            sync_lap_time = self.read_lap_epoch_time(node, lap_id)
+                            if sync_lap_time is None:
+                                sync_lap_time = self.read_lap_sync_time(node, lap_id)
+                            if sync_lap_time is not None:
+                                readtime = sync_lap_time + ms_val / 1000.0  # read time implied by synchronized lap time
+
                         self.process_lap_stats(node, readtime, lap_id, ms_val, cross_flag, pn_history, cross_list, upd_list)
 
+                        if node.api_level >= PROVISIONAL_PASS_MIN_API_LEVEL and \
+                                    (cross_flag or node.provisional_status == PROVISIONAL_PENDING):
+                            self.read_provisional_pass(node)
+
                     else:
                         node.bad_rssi_count += 1
                         # log the first ten, but then only 1 per 100 after that
@@ -403,6 +683,123 @@ class RHInterface(BaseHardwareInterface):
             startThreshLowerNode.start_thresh_lower_time = 0
 
 
+    def sync_node_time(self, node):
+        '''
+        Performs time-sync exchange with node processor; the server receive time
+        for the response is sent with the next request so the node can complete
+        its offset/skew estimate, which applies to every node on the processor.
+        '''
+        node.time_sync_next_time = monotonic() + TIME_SYNC_INTERVAL_SECS
+        node.write_block(self, WRITE_TIME_SYNC, pack_32(server_time_ms()) + pack_32(node.time_sync_recv_ms))
+        data = node.read_block(self, READ_TIME_SYNC, TIME_SYNC_RESPONSE_SIZE, 0)
+        node.time_sync_recv_ms = server_time_ms() if data != None else 0
+        if data != None:
+            offset = unpack_32(data[8:])
+            node.time_sync_offset_ms = offset - 0x100000000 if offset & 0x80000000 else offset
+            skew = unpack_16(data[12:])
+            node.time_sync_skew_ppm = skew - 0x10000 if skew & 0x8000 else skew
+            node.time_sync_bound_ms = unpack_16(data[14:])
+            if node.multi_curnode_index_holder:  # other nodes on multi-node processor share its clock
+                for other in self.nodes:
+                    if other is not node and \
+                            other.multi_curnode_index_holder is node.multi_curnode_index_holder:
+                        other.time_sync_offset_ms = node.time_sync_offset_ms
+                        other.time_sync_skew_ppm = node.time_sync_skew_ppm
+                        other.time_sync_bound_ms = node.time_sync_bound_ms
+
+    def read_lap_sync_time(self, node, lap_id):
+        '''Returns monotonic time of node's last lap (via synchronized node time), or None.'''
+        if node.time_sync_bound_ms == TIME_SYNC_BOUND_UNKNOWN:
+            return None
+        micros_flag = node.api_level >= LAP_SYNC_MICROS_MIN_API_LEVEL
+        data = node.read_block(self, READ_LAP_SYNC_TIME, 9 if micros_flag else 7)
+        if data == None or data[0] != lap_id:
+            return None
+        node.lap_sync_bound_ms = unpack_16(data[5:])
+        if node.lap_sync_bound_ms == TIME_SYNC_BOUND_UNKNOWN:
+            return None
+        lap_time = server_time_ms_to_monotonic(unpack_32(data[1:]))
+        if micros_flag:  # lap was this many microseconds before the reported ms value
+            lap_time -= unpack_16(data[7:]) / 1000000.0
+        return lap_time
+
+    def set_race_epoch(self, start_time_monotonic):
+        '''
+        Sends race start time to node processors so they report lap times as
+        offsets from it; the lap time is then the race start plus that offset.
+        '''
+        self.race_epoch_id = self.race_epoch_id % 0xFF + 1  # skip RACE_EPOCH_ID_NONE
+        start_ms = int(start_time_monotonic * 1000) & 0xFFFFFFFF
+        sent_map = {}  # one write per processor (multi-node processors share index holder)
+        for node in self.nodes:
+            node.race_epoch_id = RACE_EPOCH_ID_NONE
+            if node.api_level >= RACE_EPOCH_MIN_API_LEVEL:
+                key = id(node.multi_curnode_index_holder) if node.multi_curnode_index_holder \
+                                                          else id(node)
+                if key not in sent_map:
+                    sent_map[key] = node.write_block(self, WRITE_RACE_EPOCH, pack_32(start_ms) + \
+                                            pack_32(server_time_ms()) + pack_8(self.race_epoch_id))
+                if sent_map[key]:
+                    node.race_epoch_id = self.race_epoch_id
+                    node.race_epoch_time = start_time_monotonic
+
+    def read_lap_epoch_time(self, node, lap_id):
+        '''Returns monotonic time of node's last lap (via race epoch offset), or None.'''
+        if node.race_epoch_id == RACE_EPOCH_ID_NONE or node.api_level < RACE_EPOCH_MIN_API_LEVEL:
+            return None
+        data = node.read_block(self, READ_LAP_EPOCH_OFFSET, 8)
+        if data == None or data[0] != lap_id or data[1] != node.race_epoch_id:
+            return None
+        offset_ms = unpack_32(data[2:])
+        if offset_ms == RACE_EPOCH_OFFSET_NONE:
+            return None
+        if offset_ms & 0x80000000:  # lap before race start
+            offset_ms -= 0x100000000
+        return node.race_epoch_time + offset_ms / 1000.0 + unpack_16(data[6:]) / 1000000.0
+
+    def read_provisional_pass(self, node):
+        '''
+        Reads node's provisional pass and, if it was raised, amended, confirmed or
+        retracted since the previous read, invokes the provisional-pass callback.
+        '''
+        data = node.read_block(self, READ_PROVISIONAL_PASS, 6)
+        if data == None or data[2] == node.provisional_revision:
+            return
+        node.provisional_revision = data[2]
+        node.provisional_lap_id = data[0]
+        node.provisional_status = data[1]
+        node.provisional_peak_rssi = unpack_rssi(node, data[3:])
+        readtime = node.io_response - (node.io_response - node.io_request) / 2
+        node.provisional_timestamp = readtime - unpack_16(data[4:]) / 1000.0
+        if node.provisional_status != PROVISIONAL_NONE and callable(self.provisional_pass_callback):
+            gevent.spawn(self.provisional_pass_callback, node)
+
+    def read_lap_stats_delta(self, node):
+        '''
+        Reads lap-stats fields changed since the previous read and merges them into
+        the node's saved values; returns data in READ_LAP_PASS_STATS + READ_LAP_EXTREMUMS
+        layout, or None if a full read is needed.
+        '''
+        data = node.read_lap_stats_delta(self)
+        if data is None:
+            node.lap_stats_data = None
+            return None
+        generation = data[0]
+        mask = data[1]
+        if node.lap_stats_generation is not None and generation != ((node.lap_stats_generation + 1) & 0xFF):
+            node.lap_stats_data = None  # response lost, so saved values may be stale; do full read now
+            return None
+        stats = node.lap_stats_data
+        pos = 2
+        for bit, offset, size in LAPDELTA_FIELDS:
+            if mask & bit:
+                stats[offset:offset+size] = data[pos:pos+size]
+                pos += size
+        result = bytearray(stats)
+        stats[11:16] = bytes(5)  # extremum is only reported once
+        node.lap_stats_generation = generation
+        return result
+
     #
     # Internal helper functions for setting single values
     #
@@ -524,12 +921,87 @@ class RHInterface(BaseHardwareInterface):
     # External functions for setting data
     #
 
+    def get_bcast_node_groups(self, node_list):
+        '''Returns dict of broadcast-capable nodes (from given list) grouped by I2C bus.'''
+        bus_groups = {}
+        for node in node_list:
+            if node.api_level >= BCAST_MIN_API_LEVEL and node.get_bcast_table_index() >= 0:
+                bus_groups.setdefault(node.i2c_helper, []).append(node)
+        return bus_groups
+
+    def broadcast_frequencies(self, node_freqs):
+        '''
+        Sends frequencies to I2C nodes via one general-call frame per bus;
+        'node_freqs' is a list of (node_index, frequency) tuples.  The values
+        are confirmed afterwards via 'set_frequency()' for each node.
+        '''
+        freq_map = {self.nodes[idx]: freq for idx, freq in node_freqs}
+        for i2c_helper, bus_nodes in self.get_bcast_node_groups(freq_map.keys()).items():
+            table = [0] * BCAST_TABLE_SIZE
+            mask = 0
+            for node in bus_nodes:
+                freq = freq_map[node] if freq_map[node] else 1111  # power down if disabled
+                table[node.get_bcast_table_index()] = freq
+                mask |= (1 << node.get_bcast_table_index())
+            data = pack_8(mask)
+            for freq in table:
+                data.extend(pack_16(freq))
+            if bus_nodes[0].write_bcast_block(self, WRITE_BCAST_FREQUENCY, data):
+                time_now = monotonic()
+                for node in bus_nodes:
+                    node.bcast_frequency = freq_map[node]
+                    node.bcast_frequency_time = time_now
+
+    def transmit_enter_exit_levels(self, node_levels):
+        '''
+        Sends EnterAt/ExitAt values via one general-call frame per I2C bus, then
+        confirms them with one settings read per node; 'node_levels' is a list
+        of (node, enter_at, exit_at) tuples.  Values for other nodes (or nodes
+        that did not confirm) are sent individually.
+        '''
+        level_map = {node: (enter_at, exit_at) for node, enter_at, exit_at in node_levels}
+        for i2c_helper, bus_nodes in self.get_bcast_node_groups(level_map.keys()).items():
+            table = [0] * BCAST_TABLE_SIZE
+            mask = 0
+            for node in bus_nodes:
+                enter_at, exit_at = level_map[node]
+                table[node.get_bcast_table_index()] = (enter_at << 8) | exit_at
+                mask |= (1 << node.get_bcast_table_index())
+            data = pack_8(mask)
+            for levels in table:
+                data.extend(pack_16(levels))
+            if bus_nodes[0].write_bcast_block(self, WRITE_BCAST_ENTER_EXIT, data):
+                for node in bus_nodes:
+                    data = node.read_block(self, READ_NODE_SETTINGS, 4)
+                    if data != None and (unpack_8(data[2:]), unpack_8(data[3:])) == level_map[node]:
+                        del level_map[node]
+        for node, (enter_at, exit_at) in level_map.items():
+            self.transmit_enter_at_level(node, enter_at)
+            self.transmit_exit_at_level(node, exit_at)
+
     def set_frequency(self, node_index, frequency, *_args):
         node = self.nodes[node_index]
         node.debug_pass_count = 0  # reset debug pass count on frequency change
 
         success = False
         retry_count = 0
+        if node.bcast_frequency is not None:  # frequency already sent via broadcast
+            bcast_time = node.bcast_frequency_time
+            if node.bcast_frequency == frequency:
+                data = node.read_block(self, READ_NODE_SETTINGS, 4)
+                if data != None and unpack_16(data) == (frequency if frequency else 1111):
+                    node.frequency = frequency
+                    if frequency and node.api_level >= 36:
+                        settle_secs = bcast_time + RX_FREQ_SETTLE_SECS - monotonic()
+                        if settle_secs > 0:
+                            gevent.sleep(settle_secs)
+                        success = bool(self.get_value_8(node, TEST_RX_REGISTER))
+                    else:
+                        success = True
+            node.bcast_frequency = None
+            if success:
+                return success
+
         while success is False and retry_count <= MAX_FREQUENCY_RETRY_COUNT:
             if frequency:
                 node.frequency = self.set_and_validate_value_16(node,
@@ -546,7 +1018,7 @@ class RHInterface(BaseHardwareInterface):
             # run register test to see if RX has stored frequency value
             if frequency and node and node.api_level >= 36:
                 gevent.sleep(
-                    0.03)  # IMPORTANT: Delay time for RX5808 VCOs and circuitry to settle after writing freq and before reading register 0x01 (20ms is optimal, 30ms is safer, can be longer but not shorter). Erroneous results will occur if delay is too short
+                    RX_FREQ_SETTLE_SECS)  # IMPORTANT: Delay time for RX5808 VCOs and circuitry to settle after writing freq and before reading register 0x01 (20ms is optimal, 30ms is safer, can be longer but not shorter). Erroneous results will occur if delay is too short
                 test_result = self.get_value_8(node, TEST_RX_REGISTER)
                 if test_result:
                     success = True
@@ -585,6 +1057,400 @@ class RHInterface(BaseHardwareInterface):
             if self.transmit_exit_at_level(node, level):
                 node.exit_at_level = level
 
+    def start_node_calibration(self, node_index, seconds, apply_flag=True):
+        '''
+        Starts capture of RSSI statistics on the node at its full sample rate; when
+        the capture is finished the suggested EnterAt/ExitAt levels are read (and
+        applied if 'apply_flag'). Returns True if the capture was started.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < CALIBRATION_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_CALIBRATION):
+            return False
+        seconds = max(1, min(int(seconds), 0xFF))
+        if not node.write_block(self, WRITE_CALIBRATE, \
+                        pack_8(seconds) + pack_8(CALIBRATE_FLAG_APPLY if apply_flag else 0)):
+            return False
+        node.calibration_result = None
+        node.calibration_apply_flag = apply_flag
+        node.calibration_end_time = monotonic() + seconds
+        node.calibration_give_up_time = node.calibration_end_time + CALIBRATION_TIMEOUT_SECS
+        self.log('Started {0}s calibration capture on node {1}'.format(seconds, node.index+1))
+        return True
+
+    def read_node_calibration(self, node):
+        '''Returns dict of values from node's calibration capture, or None.'''
+        data = node.read_block(self, READ_CALIBRATION, CALIBRATION_RESPONSE_SIZE)
+        if data == None:
+            return None
+        return {
+            'status': data[0],
+            'sample_count': unpack_32(data[1:]),
+            'noise_p10': unpack_rssi(node, data[5:]),
+            'noise_p50': unpack_rssi(node, data[6:]),
+            'noise_floor': unpack_rssi(node, data[7:]),
+            'peak_p25': unpack_rssi(node, data[8:]),
+            'peak_p50': unpack_rssi(node, data[9:]),
+            'peak_max': unpack_rssi(node, data[10:]),
+            'pass_count': unpack_16(data[11:]),
+            'enter_at_level': unpack_rssi(node, data[13:]),
+            'exit_at_level': unpack_rssi(node, data[14:])
+        }
+
+    def finish_node_calibration(self, node):
+        result = self.read_node_calibration(node)
+        if result is None or result['status'] == CALIBRATION_CAPTURING:
+            if monotonic() < node.calibration_give_up_time:
+                node.calibration_end_time = monotonic() + CALIBRATION_RETRY_SECS
+                return
+            self.log('Calibration capture on node {0} did not finish'.format(node.index+1))
+            node.calibration_end_time = 0
+            return
+        node.calibration_end_time = 0
+        node.calibration_result = result
+        if result['status'] != CALIBRATION_DONE:
+            self.log('Calibration on node {0} found no fly-by peaks above noise floor ({1})'.\
+                     format(node.index+1, result['noise_floor']))
+            return
+        self.log('Calibration on node {0}: noise floor={1}, fly-by peak={2} (count={3}), EnterAt={4}, ExitAt={5}'.\
+                 format(node.index+1, result['noise_floor'], result['peak_p25'], result['pass_count'], \
+                        result['enter_at_level'], result['exit_at_level']))
+        if node.calibration_apply_flag:  # node has set the suggested levels
+            node.enter_at_level = result['enter_at_level']
+            node.exit_at_level = result['exit_at_level']
+            if callable(self.new_enter_or_exit_at_callback):
+                gevent.spawn(self.new_enter_or_exit_at_callback, node, True)
+                gevent.spawn(self.new_enter_or_exit_at_callback, node, False)
+
+    def read_noise_floor(self, node):
+        '''
+        Reads node's noise-floor estimate and the EnterAt/ExitAt levels it is using;
+        polling continues only while the levels float with the noise floor.
+        '''
+        node.noise_floor_next_time = monotonic() + NOISE_FLOOR_READ_INTERVAL_SECS
+        data = node.read_block(self, READ_NOISE_FLOOR, 5)
+        if data == None:
+            return
+        node.noise_floor = unpack_rssi(node, data[0:])
+        node.threshold_float_max = unpack_rssi(node, data[2:])
+        if node.threshold_float_max == 0:
+            node.noise_floor_next_time = None  # levels in use are the ones written
+        enter_at = unpack_rssi(node, data[3:])
+        exit_at = unpack_rssi(node, data[4:])
+        if node.threshold_float_max > 0 and (enter_at != node.effective_enter_at_level or \
+                                             exit_at != node.effective_exit_at_level):
+            self.log('Node {0} noise floor={1}; EnterAt/ExitAt in use: {2}/{3} (set {4}/{5})'.\
+                     format(node.index+1, node.noise_floor, enter_at, exit_at, \
+                            node.enter_at_level, node.exit_at_level))
+        node.effective_enter_at_level = enter_at
+        node.effective_exit_at_level = exit_at
+
+    def get_rssi_windows(self, node_index):
+        '''
+        Returns list of (window_secs, max_rssi, min_rssi) for the node's sliding
+        windows of recent RSSI, or None if not supported.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < RSSI_WINDOWS_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_RSSI_WINDOWS):
+            return None
+        data = node.read_block(self, READ_RSSI_WINDOWS, 1 + 3 * RSSI_WINDOWS_MAX_COUNT)
+        if data == None:
+            return None
+        count = min(data[0], RSSI_WINDOWS_MAX_COUNT)
+        return [(data[1+i*3], unpack_rssi(node, data[2+i*3:]), unpack_rssi(node, data[3+i*3:])) \
+                for i in range(count)]
+
+    def get_rssi_pyramid(self, node_index, tier, start_secs_ago=0, span_secs=None):
+        '''
+        Returns list of (time, max_rssi, min_rssi, mean_rssi) summary entries from
+        the given tier of the node's RSSI pyramid, oldest first, where 'time' is the
+        monotonic time at the end of the entry.  Entries cover 'span_secs' (or all
+        available) ending 'start_secs_ago' before now.  Returns None if not supported.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < RSSI_PYRAMID_MIN_API_LEVEL or tier < 0 or tier >= RSSI_PYRAMID_TIER_COUNT or \
+                        not (node.rhfeature_flags & RHFEAT_RSSI_PYRAMID):
+            return None
+        read_entries = RSSI_PYRAMID_READ_ENTRIES_STM32 if (node.rhfeature_flags & RHFEAT_STM32_MODE) \
+                                else RSSI_PYRAMID_READ_ENTRIES_ARDUINO
+        entries = []
+        offset = None
+        end_time = None
+        while True:
+            if offset is not None and offset > 0xFF:
+                break
+            if not node.write_block(self, WRITE_RSSI_PYRAMID_QUERY, pack_8(tier) + pack_8(offset or 0)):
+                return None
+            data = node.read_block(self, READ_RSSI_PYRAMID, 8 + 3 * read_entries)
+            if data == None or data[0] != tier or data[2] != (offset or 0):
+                return None  # failed, or query replaced by another before read
+            count = data[1]
+            num = min(data[3], read_entries)
+            entry_secs = unpack_16(data[4:]) / 1000.0
+            if entry_secs <= 0:
+                return None
+            readtime = node.io_response - (node.io_response - node.io_request) / 2
+            newest_time = readtime - unpack_16(data[6:]) / 1000.0
+            if offset is None:  # first read only gives entry length; find start of range
+                end_time = readtime - start_secs_ago
+                offset = max(int((newest_time - end_time) / entry_secs + 0.5), 0)
+                if offset < count:
+                    continue
+                break
+            for i in range(num):
+                etime = newest_time - (data[2] + i) * entry_secs
+                if etime > end_time + entry_secs / 2:
+                    continue
+                if span_secs is not None and etime <= end_time - span_secs:
+                    num = 0
+                    break
+                # ring may have advanced between reads; skip entries already collected
+                if entries and etime > entries[-1][0] - entry_secs / 2:
+                    continue
+                base = 8 + i * 3
+                entries.append((etime, unpack_rssi(node, data[base:]), unpack_rssi(node, data[base+1:]), \
+                                unpack_rssi(node, data[base+2:])))
+            if num < read_entries:
+                break
+            offset = data[2] + num
+        entries.reverse()
+        return entries
+
+    def set_rssi_trace_mode(self, node_index, mode):
+        '''
+        Starts streaming every filtered (RSSI_TRACE_FILTERED) or raw (RSSI_TRACE_RAW)
+        sample from the node to 'trace_N.csv', or stops it (RSSI_TRACE_OFF).
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < RSSI_TRACE_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_RSSI_TRACE) or \
+                        not node.write_block(self, WRITE_RSSI_TRACE_MODE, pack_8(mode)):
+            return False
+        node.trace_mode = mode
+        node.trace_next_seq = 0
+        node.trace_sample_count = 0
+        node.trace_dropped_count = 0
+        if mode != RSSI_TRACE_OFF:
+            if not node.trace_logger:
+                node.trace_logger = open("trace_{0}.csv".format(node.index+1), 'w')
+            logger.info("RSSI trace ({0}) enabled for node {1}".format( \
+                        'raw' if mode == RSSI_TRACE_RAW else 'filtered', node.index+1))
+        elif node.trace_logger:
+            node.trace_logger.close()
+            node.trace_logger = None
+        return True
+
+    def read_rssi_trace(self, node):
+        '''
+        Reads trace packets queued on the node and writes the decoded samples
+        (sequence number, time, RSSI) to the node's trace file.
+        '''
+        packet_size = RSSI_TRACE_PACKET_SIZE_STM32 if (node.rhfeature_flags & RHFEAT_STM32_MODE) \
+                                else RSSI_TRACE_PACKET_SIZE_ARDUINO
+        for _ in range(RSSI_TRACE_MAX_READS):
+            data = node.read_block(self, READ_RSSI_TRACE, packet_size)
+            if data == None:
+                return
+            seq = unpack_16(data)
+            count = data[2]
+            pending = unpack_16(data[4:])
+            if count > 0:
+                values = decode_rssi_trace(data[RSSI_TRACE_HEADER_SIZE:], \
+                                           min(data[3], packet_size - RSSI_TRACE_HEADER_SIZE))
+                if len(values) != count:
+                    logger.warning("Node {0}: bad RSSI trace packet (seq={1})".format(node.index+1, seq))
+                    values = []
+                missed = (seq - node.trace_next_seq) & 0xFFFF
+                if missed:
+                    node.trace_dropped_count += missed
+                    if node.trace_logger:
+                        node.trace_logger.write("# gap of {0} samples\n".format(missed))
+                readtime = node.io_response - (node.io_response - node.io_request) / 2
+                first_time = readtime - (pending + count) * RSSI_TRACE_SAMPLE_SECS
+                if node.trace_logger:
+                    for i, rssi in enumerate(values):
+                        node.trace_logger.write("{0},{1:.4f},{2}\n".format((seq + i) & 0xFFFF, \
+                                                first_time + (i + 1) * RSSI_TRACE_SAMPLE_SECS, rssi))
+                node.trace_sample_count += len(values)
+                node.trace_next_seq = (seq + count) & 0xFFFF
+            if pending == 0:
+                return
+
+    def get_pass_envelopes(self, node_index, lap_ids=None):
+        '''
+        Returns list of RSSI envelopes kept by the node for the given node lap IDs
+        (or for its most recent passes), each a dict with 'lap_id', 'start_offset_secs'
+        (start of first point relative to lap time), 'point_secs' and 'points' (max
+        RSSI over each point).  Laps no longer kept are omitted; returns None if
+        not supported.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < PASS_ENVELOPE_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_PASS_ENVELOPE):
+            return None
+        if lap_ids is None:
+            if node.node_lap_id < 0:
+                return []
+            lap_ids = [(node.node_lap_id - i) & 0xFF for i in range(PASS_ENVELOPE_MAX_KEPT - 1, -1, -1)]
+        read_points = PASS_ENVELOPE_READ_POINTS_STM32 if (node.rhfeature_flags & RHFEAT_STM32_MODE) \
+                                else PASS_ENVELOPE_READ_POINTS_ARDUINO
+        envelopes = []
+        for lap_id in lap_ids:
+            points = []
+            count = 1
+            while len(points) < count:
+                if not node.write_block(self, WRITE_PASS_ENVELOPE_QUERY, pack_8(lap_id & 0xFF) + pack_8(len(points))):
+                    return None
+                data = node.read_block(self, READ_PASS_ENVELOPE, PASS_ENVELOPE_HEADER_SIZE + read_points)
+                if data == None or data[0] != (lap_id & 0xFF) or data[6] != len(points):
+                    return None  # failed, or query replaced by another before read
+                count = data[1]
+                num = min(count - len(points), read_points)
+                points.extend(unpack_rssi(node, data[PASS_ENVELOPE_HEADER_SIZE+i:]) for i in range(num))
+            if count > 0:
+                start_offset = unpack_16(data[4:])
+                if start_offset & 0x8000:
+                    start_offset -= 0x10000
+                envelopes.append({
+                    'lap_id': lap_id,
+                    'start_offset_secs': start_offset / 1000.0,
+                    'point_secs': unpack_16(data[2:]) / 1000.0,
+                    'points': points
+                })
+        return envelopes
+
+    def recompute_laps(self, node_index, enter_at, exit_at):
+        '''
+        Has the node replay its heat history with the given EnterAt/ExitAt levels
+        and returns a dict with 'passes' (list of dicts with 'timestamp' (server
+        monotonic time) and 'peak_rssi'), 'history_start' (time of oldest retained
+        history) and 'truncated' (history before then was dropped); returns None
+        if not supported or failed.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < RECOMPUTE_LAPS_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_HEAT_HISTORY):
+            return None
+        passes = []
+        total = 1
+        while len(passes) < total:
+            if not node.write_block(self, WRITE_RECOMPUTE_LAPS, pack_8(enter_at) + pack_8(exit_at) + \
+                                    pack_8(len(passes))):
+                return None
+            data = node.read_block(self, READ_RECOMPUTED_LAPS, RECOMPUTE_HEADER_SIZE + \
+                                   RECOMPUTE_READ_PASSES * RECOMPUTE_PASS_SIZE)
+            if data == None or unpack_rssi(node, data) != enter_at or \
+                        unpack_rssi(node, data[1:]) != exit_at or data[3] != len(passes):
+                return None  # failed, or query replaced by another before read
+            readtime = node.io_response - (node.io_response - node.io_request) / 2
+            total = data[2]
+            num = min(total - len(passes), RECOMPUTE_READ_PASSES)
+            for i in range(num):
+                offset = RECOMPUTE_HEADER_SIZE + i * RECOMPUTE_PASS_SIZE
+                passes.append({
+                    'timestamp': readtime - unpack_32(data[offset:]) / 1000.0,
+                    'peak_rssi': unpack_rssi(node, data[offset+4:])
+                })
+            if num <= 0:
+                break
+        return {
+            'passes': passes,
+            'history_start': readtime - unpack_32(data[5:]) / 1000.0,
+            'truncated': (data[4] & RECOMPUTE_FLAG_TRUNCATED) != 0
+        }
+
+    def set_threshold_float(self, node_index, max_drift):
+        '''Lets node move EnterAt/ExitAt with its noise floor by up to 'max_drift' (0 = fixed).'''
+        node = self.nodes[node_index]
+        if node.api_level >= NOISE_FLOOR_MIN_API_LEVEL and \
+                        self.set_value_8(node, WRITE_THRESHOLD_FLOAT, max_drift):
+            node.threshold_float_max = max_drift
+            node.noise_floor_next_time = 0  # read levels in use on next update
+            return True
+        return False
+
+    def set_history_prominence(self, node_index, level):
+        '''Sets RSSI reversal that declares a history peak/nadir on node (1 = every reversal).'''
+        node = self.nodes[node_index]
+        if node.api_level >= HISTORY_PROMINENCE_MIN_API_LEVEL:
+            return self.set_value_8(node, WRITE_HISTORY_PROMINENCE, level)
+        return False
+
+    def set_crossing_detector(self, node_index, engine, learn=False, \
+                              min_corr=DETECTOR_DEFAULT_MIN_CORR, min_rise=DETECTOR_DEFAULT_MIN_RISE):
+        '''
+        Selects crossing detector on node (DETECTOR_... value), whether the
+        matched-filter template is learned from detected passes, and the min
+        correlation (percent) and RSSI rise for a matched-filter crossing.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < CROSSING_DETECTOR_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_MATCH_DETECTOR):
+            return False
+        return node.write_block(self, WRITE_CROSSING_DETECTOR, pack_8(engine) + \
+                                pack_8(DETECTOR_FLAG_LEARN if learn else 0) + \
+                                pack_8(min(max(int(min_corr), 0), 100)) + pack_8(min_rise))
+
+    def set_detector_template(self, node_index, points=None):
+        '''
+        Writes matched-filter template on node (values 0-100, peak at pass time);
+        restores the default template if 'points' is None.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < CROSSING_DETECTOR_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_MATCH_DETECTOR):
+            return False
+        if points is None:
+            return node.write_block(self, WRITE_DETECTOR_TEMPLATE, pack_8(DETECTOR_TEMPLATE_DEFAULT) + \
+                                    pack_8(0) + [0] * DETECTOR_WRITE_POINTS)
+        for offset in range(0, len(points), DETECTOR_WRITE_POINTS):
+            chunk = [min(max(int(v), 0), 100) for v in points[offset:offset+DETECTOR_WRITE_POINTS]]
+            data = pack_8(offset) + pack_8(len(chunk)) + chunk + [0] * (DETECTOR_WRITE_POINTS - len(chunk))
+            if not node.write_block(self, WRITE_DETECTOR_TEMPLATE, data):
+                return False
+        return True
+
+    def get_crossing_detector(self, node_index):
+        '''
+        Returns dict with node crossing detector 'engine' (DETECTOR_... value),
+        'learn', 'learn_count' (passes learned), 'score' (correlation percent of
+        newest window), 'min_corr', 'min_rise' and matched-filter 'template'
+        points; returns None if not supported or failed.
+        '''
+        node = self.nodes[node_index]
+        if node.api_level < CROSSING_DETECTOR_MIN_API_LEVEL or \
+                        not (node.rhfeature_flags & RHFEAT_MATCH_DETECTOR):
+            return None
+        template = []
+        taps = 1
+        while len(template) < taps:
+            if not node.write_block(self, WRITE_DETECTOR_TEMPLATE, pack_8(len(template)) + \
+                                    pack_8(0) + [0] * DETECTOR_WRITE_POINTS):
+                return None
+            data = node.read_block(self, READ_CROSSING_DETECTOR, DETECTOR_HEADER_SIZE + DETECTOR_READ_POINTS)
+            if data == None or data[7] != len(template):
+                return None  # failed, or start point replaced by another before read
+            taps = data[2]
+            num = min(taps - len(template), DETECTOR_READ_POINTS)
+            template.extend(data[DETECTOR_HEADER_SIZE:DETECTOR_HEADER_SIZE+num])
+            if num <= 0:
+                break
+        return {
+            'engine': data[0],
+            'learn': (data[1] & DETECTOR_FLAG_LEARN) != 0,
+            'learn_count': data[3],
+            'score': data[4],
+            'min_corr': data[5],
+            'min_rise': unpack_rssi(node, data[6:]),
+            'template': template
+        }
+
+    def set_provisional_drop(self, node_index, level):
+        node = self.nodes[node_index]
+        if node.api_level >= PROVISIONAL_PASS_MIN_API_LEVEL:
+            self.set_value_8(node, WRITE_PROVISIONAL_DROP, level)
+
     def force_end_crossing(self, node_index):
         node = self.nodes[node_index]
         if node.api_level >= 14:
@@ -8,6 +8,8 @@ from RHInterface import READ_ADDRESS, READ_REVISION_CODE, MAX_RETRY_COUNT, \
                         FW_TEXT_BLOCK_SIZE, validate_checksum, calculate_checksum, \
                         pack_16, unpack_16, READ_FW_PROCTYPE, SEND_STATUS_MESSAGE
 
+I2C_GENERAL_CALL_ADDR = 0x00  # address for broadcasts to all nodes
+
 logger = logging.getLogger(__name__)
 
 
@@ -93,6 +95,27 @@ class I2CNode(Node):
                 interface.inc_intf_write_error_count()
         return success
 
+    def get_bcast_table_index(self):
+        return (self.i2c_addr - 8) // 2
+
+    def write_bcast_block(self, interface, command, data):
+        '''
+        Write i2c data to all nodes on the bus (general call), given command, and data.
+        '''
+        interface.inc_intf_write_block_count()
+        data_with_checksum = data
+        data_with_checksum.append(calculate_checksum(data_with_checksum))
+        try:
+            def _write():
+                self.i2c_helper.i2c.write_i2c_block_data(I2C_GENERAL_CALL_ADDR, command, data_with_checksum)
+                return True
+            return bool(self.i2c_helper.with_i2c(_write))
+        except IOError as err:
+            interface.log('Broadcast Write Error: ' + str(err))
+            self.i2c_helper.i2c_end()
+            interface.inc_intf_write_error_count()
+        return False
+
     def jump_to_bootloader(self, interface):
         pass
 
@@ -11,7 +11,10 @@ from RHInterface import READ_REVISION_CODE, READ_MULTINODE_COUNT, MAX_RETRY_COUN
                         validate_checksum, calculate_checksum, pack_8, pack_16, unpack_8, unpack_16, \
                         WRITE_CURNODE_INDEX, READ_CURNODE_INDEX, READ_NODE_SLOTIDX, \
                         READ_FW_VERSION, READ_FW_BUILDDATE, READ_FW_BUILDTIME, FW_TEXT_BLOCK_SIZE, \
-                        JUMP_TO_BOOTLOADER, READ_FW_PROCTYPE, SEND_STATUS_MESSAGE
+                        JUMP_TO_BOOTLOADER, READ_FW_PROCTYPE, SEND_STATUS_MESSAGE, \
+                        READ_NODE_DESCRIPTOR, NODE_DESCRIPTOR_HEADER_SIZE, NODE_DESCRIPTOR_ENTRY_SIZE, \
+                        NODE_DESCRIPTOR_MIN_API_LEVEL, NodeDescriptor, READ_LAP_STATS_DELTA, \
+                        lap_stats_delta_size, READ_RHFEAT_FLAGS, RHFEAT_STM32_MODE
 
 BOOTLOADER_CHILL_TIME = 2 # Delay for USB to switch from bootloader to serial mode
 SERIAL_BAUD_RATES = [921600, 115200]
@@ -28,7 +31,8 @@ class SerialNode(Node):
         Node.__init__(self)
         self.index = index
         self.serial = node_serial_obj
-        
+        self.lap_stats_delta_capable = True  # variable-length responses supported
+
     def node_log(self, interface, message):
         if interface:
             interface.log(message)
@@ -186,6 +190,59 @@ class SerialNode(Node):
             self.node_log(interface, 'Error sending status message to serial node {}: {}'.format(self.index+1, ex))
         return False
 
+    def read_node_descriptor(self, interface, max_retries=2):
+        '''
+        Read node descriptor (single response with header and an entry for each node).
+        '''
+        with node_io_rlock_obj:  # only allow one greenlet at a time
+            retry_count = 0
+            while retry_count <= max_retries:
+                try:
+                    self.io_request = monotonic()
+                    self.serial.flushInput()
+                    self.serial.write(bytearray([READ_NODE_DESCRIPTOR]))
+                    data = bytearray(self.serial.read(NODE_DESCRIPTOR_HEADER_SIZE))
+                    if len(data) == NODE_DESCRIPTOR_HEADER_SIZE:
+                        # node count in header determines size of rest of response (plus checksum)
+                        data.extend(self.serial.read(unpack_8(data[4:]) * NODE_DESCRIPTOR_ENTRY_SIZE + 1))
+                        self.io_response = monotonic()
+                        if validate_checksum(data):
+                            return NodeDescriptor(data[:-1])
+                    self.node_log(interface, 'Retry (bad data) in read_node_descriptor:  port={0} retry={1}'.\
+                                  format(self.serial.port, retry_count))
+                except IOError as err:
+                    self.node_log(interface, 'Read Error: ' + str(err))
+                retry_count = retry_count + 1
+                gevent.sleep(0.025)
+            return None
+
+    def read_lap_stats_delta(self, interface):
+        '''
+        Read READ_LAP_STATS_DELTA response (size depends on mask in header); not retried
+        because the node only reports each change once (caller does a full read instead).
+        '''
+        with node_io_rlock_obj:  # only allow one greenlet at a time
+            self.inc_read_block_count(interface)
+            if self.multi_node_index >= 0:
+                if not self.check_set_multi_node_index(interface):
+                    return None
+            try:
+                self.io_request = monotonic()
+                self.serial.flushInput()
+                self.serial.write(bytearray([READ_LAP_STATS_DELTA]))
+                data = bytearray(self.serial.read(2))
+                if len(data) == 2:
+                    size = lap_stats_delta_size(data[1])
+                    data.extend(self.serial.read(size + 1))
+                    self.io_response = monotonic()
+                    if len(data) == size + 3 and validate_checksum(data):
+                        return data[:-1]
+                self.node_log(interface, 'Bad response in read_lap_stats_delta:  port={0}'.format(self.serial.port))
+            except IOError as err:
+                self.node_log(interface, 'Read Error: ' + str(err))
+            self.inc_read_error_count(interface)
+            return None
+
     def read_node_slot_index(self):
         # read node slot index (physical slot position of node on S32_BPill PCB)
         try:
@@ -270,12 +327,21 @@ def discover(idxOffset, config, isS32BPillFlag=False, *args, **kwargs):
                         node = SerialNode(index+idxOffset, node_serial_obj)
                         node_serial_obj.flushInput()  # clear any messages that came in during delay
                         multi_count = 1
+                        node_descriptor = None
                         try:               # handle serial multi-node processor
                             # read NODE_API_LEVEL and verification value:
                             data = node.read_block(None, READ_REVISION_CODE, 2, 2, False)
                             rev_val = unpack_16(data) if data != None else None
                             if rev_val and (rev_val >> 8) == 0x25:
-                                if (rev_val & 0xFF) >= 32:  # check node API level
+                                if (rev_val & 0xFF) >= NODE_DESCRIPTOR_MIN_API_LEVEL:
+                                    # fetch node count, firmware info and settings in one transaction
+                                    #  (not supported by Arduino nodes, which lack the RAM for it)
+                                    data = node.read_block(None, READ_RHFEAT_FLAGS, 2, 2, False)
+                                    if data != None and (unpack_16(data) & RHFEAT_STM32_MODE):
+                                        node_descriptor = node.read_node_descriptor(None)
+                                if node_descriptor:
+                                    multi_count = node_descriptor.node_count
+                                elif (rev_val & 0xFF) >= 32:  # check node API level
                                     data = node.read_block(None, READ_MULTINODE_COUNT, 1, 2, False)
                                     multi_count = unpack_8(data) if data != None else None
                                 if multi_count is None or multi_count < 0 or multi_count > 32:
@@ -300,7 +366,20 @@ def discover(idxOffset, config, isS32BPillFlag=False, *args, **kwargs):
                     fver_log_str = ''
                     ftyp_log_str = ''
                     ftim_log_str = ''
-                    if api_level >= 34:  # read firmware version and build timestamp strings
+                    if node_descriptor:
+                        if multi_count > 0:
+                            node_descriptor.apply_to_node(node, 0)
+                        else:
+                            node.rhfeature_flags = node_descriptor.rhfeature_flags
+                            node.firmware_version_str = node_descriptor.firmware_version_str
+                            node.firmware_proctype_str = node_descriptor.firmware_proctype_str
+                            node.firmware_timestamp_str = node_descriptor.firmware_timestamp_str
+                        node_version_str = node.firmware_version_str
+                        node_timestamp_str = node.firmware_timestamp_str
+                        fver_log_str = ", fw_version=" + node.firmware_version_str
+                        ftyp_log_str = ", fw_type=" + node.firmware_proctype_str
+                        ftim_log_str = ", fw_timestamp: " + node.firmware_timestamp_str
+                    elif api_level >= 34:  # read firmware version and build timestamp strings
                         node.read_firmware_version()
                         if node.firmware_version_str:
                             node_version_str = node.firmware_version_str
@@ -332,7 +411,8 @@ def discover(idxOffset, config, isS32BPillFlag=False, *args, **kwargs):
                         node.multi_node_index = 0
                         curnode_index_holder = [-1]  # tracker for index of current node for processor
                         node.multi_curnode_index_holder = curnode_index_holder
-                        node.read_node_slot_index()
+                        if not node_descriptor:
+                            node.read_node_slot_index()
                         logger.debug("Serial (multi) node {} (slot={}) added for port '{}'".format(\
                                      index+idxOffset+1, node.multi_node_slot_index+1, node.serial.name))
                         nodes.append(node)
@@ -345,7 +425,10 @@ def discover(idxOffset, config, isS32BPillFlag=False, *args, **kwargs):
                             node.api_level = api_level
                             node.firmware_version_str = node_version_str
                             node.firmware_timestamp_str = node_timestamp_str
-                            node.read_node_slot_index()
+                            if node_descriptor:
+                                node_descriptor.apply_to_node(node, nIdx)
+                            else:
+                                node.read_node_slot_index()
                             logger.debug("Serial (multi) node {} (slot={}) added for port '{}'".format(\
                                          index+idxOffset+1, node.multi_node_slot_index+1, node.serial.name))
                             nodes.append(node)
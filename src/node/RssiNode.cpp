@@ -4,14 +4,31 @@
 #define TSPI 10 //uS
 
 RssiNode RssiNode::rssiNodeArray[MULTI_RHNODE_MAX];
+#ifndef __TEST_ALL_FEATURES__  // these tests build in features that the boards do not have
+static_assert(sizeof(RssiNode::rssiNodeArray) <= NODE_STATE_RAM_MAX, "node state does not fit in RAM for this board");
+#endif
 uint8_t RssiNode::multiRssiNodeCount = 1;
+SampleScheduler<MULTI_RHNODE_MAX, SAMPLE_OVERSAMPLE_MAX> RssiNode::sampleScheduler;
 mtime_t RssiNode::lastRX5808BusTimeMs = 0;
+#if RSSI_WINDOWS_FLAG
+const uint8_t RssiNode::rssiWindowSecs[RSSI_WINDOW_COUNT] = RSSI_WINDOW_SECS_LIST;
+
+static uint16_t rssiWindowBlockSamples[RSSI_WINDOW_COUNT];  // samples in each block of window
+#endif
 
 RssiNode::RssiNode()
 {
     filter = &defaultFilter;
     history = { {0, 0, 0}, false, &defaultPeakSendBuffer,
                 {MAX_RSSI, 0, 0}, false, &defaultNadirSendBuffer, 0 };
+    updateThresholds();
+#if RSSI_WINDOWS_FLAG
+    for (uint8_t i = 0; i < RSSI_WINDOW_COUNT; ++i)
+    {
+        rssiWindowBlockSamples[i] = (uint16_t)((uint32_t)rssiWindowSecs[i] *
+                (1000000UL / SAMPLE_PERIOD_MICROS) / RSSI_WINDOW_BLOCKS);
+    }
+#endif
 }
 
 void RssiNode::initRx5808Pins(int nIdx)
@@ -23,6 +40,9 @@ void RssiNode::initRx5808Pins(int nIdx)
     rx5808ClkPin = RX5808_CLK_PIN;    //CLK (CH3) output line to (all) RX5808 modules
     rx5808SelPin = rx5808SelPinForNodeIndex(nIdx);  //SEL (CH2) output line to RX5808 module
     rssiInputPin = rssiInputPinForNodeIndex(nIdx);  //RSSI input from RX5808
+#if RSSI_MUX_FLAG
+    rssiMuxChannel = nIdx;            //multiplexer channel for RSSI input
+#endif
 #else
     rx5808DataPin = RX5808_DATA_PIN;  //DATA (CH1) output line to RX5808 module
     rx5808SelPin = RX5808_SEL_PIN;    //SEL (CH2) output line to RX5808 module
@@ -51,6 +71,9 @@ void RssiNode::copyNodeData(RssiNode *srcPtr)
     rx5808ClkPin = srcPtr->rx5808ClkPin;
     rx5808SelPin = srcPtr->rx5808SelPin;
     rssiInputPin = srcPtr->rssiInputPin;
+#if RSSI_MUX_FLAG
+    rssiMuxChannel = srcPtr->rssiMuxChannel;
+#endif
     rxPoweredDown = srcPtr->rxPoweredDown;
     recentSetFreqFlag = srcPtr->recentSetFreqFlag;
     lastSetFreqTimeMs = srcPtr->lastSetFreqTimeMs;
@@ -64,10 +87,12 @@ void RssiNode::setRxModuleToFreq(uint16_t vtxFreq)
     if(timeVal < RX5808_MIN_BUSTIME)
         delay(RX5808_MIN_BUSTIME - timeVal);  // wait until after-bus-delay time is fulfilled
 
+    rxTuningFlag = true;  // suspend sampling while module is written
     if (settings.vtxFreq == 1111) // frequency value to power down rx module
     {
         powerDownRxModule();
         rxPoweredDown = true;
+        rxTuningFlag = false;
         return;
     }
     if (rxPoweredDown)
@@ -115,8 +140,9 @@ void RssiNode::setRxModuleToFreq(uint16_t vtxFreq)
     digitalWrite(rx5808ClkPin, LOW);
     digitalWrite(rx5808DataPin, LOW);
 
-    recentSetFreqFlag = true;  // indicate need to wait RX5808_MIN_TUNETIME before reading RSSI
     lastRX5808BusTimeMs = lastSetFreqTimeMs = millis();  // mark time of last tune of RX5808 to freq
+    recentSetFreqFlag = true;  // indicate need to wait RX5808_MIN_TUNETIME before reading RSSI
+    rxTuningFlag = false;
 }
 
 // Test register on RX5808 module matches provided frequency
@@ -179,8 +205,20 @@ rssi_t RssiNode::rssiRead()
         recentSetFreqFlag = false;  // don't need to check again until next freq change
     }
 
+    return rssiReadRaw();
+}
+
+// Read the RSSI value without waiting for tune
+rssi_t RssiNode::rssiReadRaw()
+{
+#if RSSI_MUX_FLAG
+    if (rssiMuxSelect())
+        delayMicroseconds(RSSI_MUX_SETTLE_MICROS);
+    int raw = rssiMuxAdcRead();
+#else
     // reads 5V value as 0-1023, RX5808 is 3.3V powered so RSSI pin will never output the full range
     int raw = analogRead(rssiInputPin);
+#endif
     // clamp upper range to fit scaling
     if (raw > 0x01FF)
         raw = 0x01FF;
@@ -309,6 +347,7 @@ void RssiNode::rssiSetSendBuffers(SendBuffer<Extremum> *peak, SendBuffer<Extremu
 void RssiNode::rssiInit()
 {
     state.lastloopMicros = micros();
+    sampleResyncFlag = true;
 }
 
 bool RssiNode::rssiStateValid()
@@ -319,6 +358,40 @@ bool RssiNode::rssiStateValid()
 void RssiNode::rssiStateReset()
 {
     state.crossing = false;
+#if PEAK_REFINE_FLAG
+    peakWindow.clear();
+#endif
+#if ZERO_PHASE_REFINE_FLAG
+    zeroPhaseWindow.clear();
+#endif
+    if (provisionalPass.status == PROVISIONAL_PENDING)
+    {  // pass in progress is discarded
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            provisionalPass.status = PROVISIONAL_RETRACTED;
+            provisionalPass.revision = provisionalPass.revision + 1;
+        }
+    }
+    thresholdDetector.reset();
+#if MATCH_DETECTOR_FLAG
+    matchedDetector.reset();
+#endif
+    noiseFloor.clear();
+#if RSSI_WINDOWS_FLAG
+    for (uint8_t i = 0; i < RSSI_WINDOW_COUNT; ++i)
+        rssiWindows[i].clear();
+#endif
+#if RSSI_PYRAMID_FLAG
+    rssiPyramid.clear();
+#endif
+#if PASS_ENVELOPE_FLAG
+    passEnvelopes.cancel();  // envelopes of finished passes are kept
+#endif
+#if HEAT_HISTORY_FLAG
+    heatHistory.clear();
+#endif
+    floorRefValid = false;
+    updateThresholds();
     invalidatePeak(state.passPeak);
     state.passRssiNadir = MAX_RSSI;
     state.nodeRssiPeak = 0;
@@ -329,6 +402,7 @@ void RssiNode::rssiStateReset()
     invalidateNadir(history.nadir);
     history.hasPendingNadir = false;
     history.nadirSend->clear();
+    history.seekingPeak = true;
 }
 
 void RssiNode::bufferHistoricPeak(bool force)
@@ -371,6 +445,48 @@ void RssiNode::bufferHistoricNadir(bool force)
     }
 }
 
+void RssiNode::updateHistoricPeakDuration()
+{
+    history.peak.duration = constrain(state.rssiTimestamp - history.peak.firstTime, 0, MAX_DURATION);
+    if (history.peak.duration == MAX_DURATION)
+    {
+        bufferHistoricPeak(true);
+        initExtremum(&(history.peak));
+    }
+}
+
+void RssiNode::updateHistoricNadirDuration()
+{
+    history.nadir.duration = constrain(state.rssiTimestamp - history.nadir.firstTime, 0, MAX_DURATION);
+    if (history.nadir.duration == MAX_DURATION)
+    {
+        bufferHistoricNadir(true);
+        initExtremum(&(history.nadir));
+    }
+}
+
+void RssiNode::declareHistoricPeak()
+{
+    // copy the values to be sent in the next loop
+    history.hasPendingPeak = true;
+    history.seekingPeak = false;
+
+    // must buffer latest nadir to prevent losing it (overwriting any unsent nadir)
+    bufferHistoricNadir(true);
+    initExtremum(&(history.nadir));
+}
+
+void RssiNode::declareHistoricNadir()
+{
+    // copy the values to be sent in the next loop
+    history.hasPendingNadir = true;
+    history.seekingPeak = true;
+
+    // must buffer latest peak to prevent losing it (overwriting any unsent peak)
+    bufferHistoricPeak(true);
+    initExtremum(&(history.peak));
+}
+
 void RssiNode::initExtremum(Extremum *e)
 {
     e->rssi = state.rssi;
@@ -378,9 +494,111 @@ void RssiNode::initExtremum(Extremum *e)
     e->duration = 0;
 }
 
-bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
+// Read RSSI into sample FIFO (called from sampling interrupt); no samples
+//  are taken while the RX5808 is being tuned.  If the node is read more than
+//  once per sample period, the readings are averaged into one sample so the
+//  filters always see SAMPLE_PERIOD_MICROS between samples
+void RssiNode::rssiAcquire(utime_t timeMicros, uint8_t oversampleCount)
 {
-    filter->addRawValue(millis, rssiVal);
+    if (rxTuningFlag)
+    {
+        restartSampling();
+        return;
+    }
+    if (recentSetFreqFlag)
+    {
+        if (millis() - lastSetFreqTimeMs < RX5808_MIN_TUNETIME)
+        {
+            restartSampling();
+            return;
+        }
+        recentSetFreqFlag = false;
+    }
+    if (acquireCount == 0)
+        acquireStartMicros = timeMicros;
+    acquireSum += rssiReadRaw();
+    if (++acquireCount < oversampleCount)
+        return;
+    rssi_t rssiVal = (rssi_t)((acquireSum + acquireCount / 2) / acquireCount);
+    utime_t sampleMicros = acquireStartMicros + (timeMicros - acquireStartMicros) / 2;
+    acquireSum = 0;
+    acquireCount = 0;
+    if (sampleFifo.push(sampleMicros, rssiVal, sampleResyncFlag ? SAMPLE_FLAG_RESYNC : 0))
+        sampleResyncFlag = false;
+}
+
+// Marks next sample as following a pause (called from sampling interrupt, or
+//  while node is out of the sampling rotation)
+void RssiNode::restartSampling()
+{
+    sampleResyncFlag = true;
+    acquireSum = 0;
+    acquireCount = 0;
+}
+
+// Process samples queued by 'rssiAcquire()'; returns number of samples processed
+uint8_t RssiNode::rssiProcessSamples()
+{
+    RssiSample sample;
+    uint8_t count = 0;
+    while (sampleFifo.pop(sample))
+    {
+        if (!(sample.flags & SAMPLE_FLAG_RESYNC))
+            fillSampleGap(sample.timeMicros, sample.rssi);
+#if ZERO_PHASE_REFINE_FLAG
+        else
+            zeroPhaseWindow.clear();  // raw samples no longer evenly spaced
+#endif
+        rssiProcessValue(sample.timeMicros, sample.rssi);
+        lastSampleMicros = sample.timeMicros;
+        lastSampleRssi = sample.rssi;
+        ++count;
+    }
+    return count;
+}
+
+// Accounts for samples missing before the given sample (interrupt delayed or
+//  FIFO overflowed); short gaps are filled by linear interpolation so the
+//  filters see evenly spaced values
+void RssiNode::fillSampleGap(utime_t timeMicros, rssi_t rssiVal)
+{
+    utime_t gapMicros = timeMicros - lastSampleMicros;
+    if (gapMicros < SAMPLE_PERIOD_MICROS * 3 / 2)
+        return;
+    utime_t missed = (gapMicros + SAMPLE_PERIOD_MICROS / 2) / SAMPLE_PERIOD_MICROS - 1;
+    gapStats.missedCount += missed;
+    if (gapStats.gapCount < 0xFFFF)
+        ++gapStats.gapCount;
+    if (missed > gapStats.maxGapSamples)
+        gapStats.maxGapSamples = (missed < 0xFFFF) ? (uint16_t)missed : 0xFFFF;
+    if (missed <= SAMPLE_GAP_FILL_MAX)
+    {
+        for (utime_t i = 1; i <= missed; ++i)
+        {
+            rssiProcessValue(lastSampleMicros + gapMicros * i / (missed + 1),
+                    lastSampleRssi + (int)(rssiVal - lastSampleRssi) * (int)i / (int)(missed + 1));
+        }
+    }
+#if ZERO_PHASE_REFINE_FLAG
+    else
+        zeroPhaseWindow.clear();
+#endif
+}
+
+bool RssiNode::rssiProcessValue(utime_t timeMicros, rssi_t rssiVal)
+{
+    filter->addRawValue(timeMicros, rssiVal);
+#if RSSI_TRACE_FLAG
+    if (traceMode == RSSI_TRACE_RAW)
+        addTraceSample(rssiVal);
+#endif
+#if ZERO_PHASE_REFINE_FLAG
+    // stop keeping raw samples once they are well past the pass peak
+    if (state.crossing && (int32_t)(timeMicros - (state.passPeak.firstTime + state.passPeak.duration)) >
+            (int32_t)(ZERO_PHASE_HALF_WIDTH + 1) * SAMPLE_PERIOD_MICROS)
+        zeroPhaseWindow.freeze();
+    zeroPhaseWindow.add(timeMicros, rssiVal);
+#endif
 
     if (filter->isFilled() && state.activatedFlag)
     {  //don't start operations until after first WRITE_FREQUENCY command is received
@@ -388,64 +606,45 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
         state.lastRssi = state.rssi;
         state.rssi = filter->getFilteredValue();
         state.rssiTimestamp = filter->getFilterTimestamp();
+#if PEAK_REFINE_FLAG
+        peakWindow.add(state.rssiTimestamp, state.rssi);
+#endif
 
         /*** update history ***/
 
+        // A peak (or nadir) is declared only when RSSI has fallen (or risen) at least
+        //  'historyProminence' from it, so smaller wiggles are merged into the
+        //  extremum in progress; equal values extend its plateau
         const int rssiChange = state.rssi - state.lastRssi;
-        if (rssiChange > 0)
-        {  // RSSI is rising
-            // must buffer latest peak to prevent losing it (overwriting any unsent peak)
-            bufferHistoricPeak(true);
-
-            initExtremum(&(history.peak));
-
-            // if RSSI was falling or unchanged, but it's rising now, we found a nadir
-            // copy the values to be sent in the next loop
-            if (history.rssiChange <= 0)
-            {  // was falling or unchanged
-                // declare a new nadir
-                history.hasPendingNadir = true;
+        const int prominence = (settings.historyProminence > 0) ? settings.historyProminence : 1;
+        if (history.seekingPeak)
+        {
+            if (state.rssi > history.peak.rssi)
+            {  // new high for peak in progress
+                initExtremum(&(history.peak));
             }
-
-        }
-        else if (rssiChange < 0)
-        {  // RSSI is falling
-            // must buffer latest nadir to prevent losing it (overwriting any unsent nadir)
-            bufferHistoricNadir(true);
-
-            // whenever history is falling, record the time and value as a nadir
-            initExtremum(&(history.nadir));
-
-            // if RSSI was rising or unchanged, but it's falling now, we found a peak
-            // copy the values to be sent in the next loop
-            if (history.rssiChange >= 0)
-            {  // was rising or unchanged
-                // declare a new peak
-                history.hasPendingPeak = true;
+            else if (state.rssi == history.peak.rssi)
+            {  // at peak value again
+                updateHistoricPeakDuration();
+            }
+            else if ((int)history.peak.rssi - (int)state.rssi >= prominence)
+            {  // fallen far enough, so we found a peak
+                declareHistoricPeak();
             }
-
         }
         else
-        {  // RSSI is equal
-            if (state.rssi == history.peak.rssi)
-            {  // is peak
-                history.peak.duration = constrain(state.rssiTimestamp - history.peak.firstTime, 0,
-                        MAX_DURATION);
-                if (history.peak.duration == MAX_DURATION)
-                {
-                    bufferHistoricPeak(true);
-                    initExtremum(&(history.peak));
-                }
+        {
+            if (state.rssi < history.nadir.rssi)
+            {  // new low for nadir in progress
+                initExtremum(&(history.nadir));
             }
             else if (state.rssi == history.nadir.rssi)
-            {  // is nadir
-                history.nadir.duration = constrain(state.rssiTimestamp - history.nadir.firstTime, 0,
-                        MAX_DURATION);
-                if (history.nadir.duration == MAX_DURATION)
-                {
-                    bufferHistoricNadir(true);
-                    initExtremum(&(history.nadir));
-                }
+            {  // at nadir value again
+                updateHistoricNadirDuration();
+            }
+            else if ((int)state.rssi - (int)history.nadir.rssi >= prominence)
+            {  // risen far enough, so we found a nadir
+                declareHistoricNadir();
             }
         }
 
@@ -468,18 +667,62 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
             state.nodeRssiNadir = state.rssi;
         }
 
+        if (noiseFloor.add(state.rssi, state.crossing, NOISE_FLOOR_BLOCK_SAMPLES))
+            updateThresholds();
+#if RSSI_WINDOWS_FLAG
+        for (uint8_t i = 0; i < RSSI_WINDOW_COUNT; ++i)
+            rssiWindows[i].add(state.rssi, rssiWindowBlockSamples[i]);
+#endif
+#if RSSI_PYRAMID_FLAG
+        rssiPyramid.add(state.rssi, timeMicros, RSSI_PYRAMID_ENTRY_MICROS / SAMPLE_PERIOD_MICROS);
+#endif
+#if RSSI_TRACE_FLAG
+        if (traceMode == RSSI_TRACE_FILTERED)
+            addTraceSample(state.rssi);
+#endif
+#if PASS_ENVELOPE_FLAG
+        passEnvelopes.add(state.rssi, state.rssiTimestamp, state.crossing ||
+                (int)state.rssi >= (int)state.enterAtEffective - PASS_ENVELOPE_MARGIN);
+#endif
+#if HEAT_HISTORY_FLAG
+        heatHistory.add(state.rssi, state.rssiTimestamp, HEAT_HISTORY_HYSTERESIS);
+#endif
+
+#if CALIBRATION_FLAG
+        if (calibration.addSample(state.rssi) && calibrationApplyFlag &&
+                calibration.getStatus() == CALIBRATION_DONE)
+        {
+            setEnterAtLevel(calibration.getResult().enterAtLevel);
+            setExitAtLevel(calibration.getResult().exitAtLevel);
+        }
+#endif
+
         /*** crossing transition ***/
 
-        if ((!state.crossing) && state.rssi >= settings.enterAtLevel)
+#if MATCH_DETECTOR_FLAG
+        if (detector != &matchedDetector && detectorLearnFlag)
+            matchedDetector.update(state.rssi, state.rssiTimestamp, false);  // keep window for learning
+#endif
+        const uint8_t transition = detector->update(state.rssi, state.rssiTimestamp, state.crossing);
+        if (transition == DETECT_PASS_START)
         {
             state.crossing = true;  // quad is going through the gate (lap pass starting)
+#if PEAK_REFINE_FLAG
+            peakWindow.startPass();
+#endif
+            if (!history.seekingPeak)
+                declareHistoricNadir();  // low before pass is kept even if within prominence
         }
-        else if (state.crossing && state.rssi < settings.exitAtLevel)
+        else if (transition == DETECT_PASS_END)
         {
             // quad has left the gate
             rssiEndCrossing();
         }
 
+#if ADAPTIVE_SAMPLING_FLAG
+        updateSampleBurst();
+#endif
+
         /*** pass processing **/
 
         if (state.crossing)
@@ -489,6 +732,10 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
             {
                 // this is first time this peak RSSI value was seen, so save value and timestamp
                 initExtremum(&(state.passPeak));
+#if ZERO_PHASE_REFINE_FLAG
+                if (zeroPhaseWindow.isFrozen())
+                    zeroPhaseWindow.clear();  // raw samples before new peak were not kept
+#endif
             }
             else if (state.rssi == state.passPeak.rssi)
             {
@@ -497,6 +744,12 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
                 state.passPeak.duration = constrain(state.rssiTimestamp - state.passPeak.firstTime,
                         0, MAX_DURATION);
             }
+            else if (settings.provisionalDrop > 0 &&
+                     (int)state.passPeak.rssi - (int)state.rssi >= (int)settings.provisionalDrop)
+            {
+                // RSSI has fallen well below the peak, so report the pass before it ends
+                updateProvisionalPass();
+            }
         }
         else
         {
@@ -506,10 +759,9 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
         }
     }
 
-    // Calculate the time it takes to run the main loop
-    utime_t loopMicros = micros();
-    state.loopTimeMicros = loopMicros - state.lastloopMicros;
-    state.lastloopMicros = loopMicros;
+    // Calculate the time between samples
+    state.loopTimeMicros = timeMicros - state.lastloopMicros;
+    state.lastloopMicros = timeMicros;
 
     return state.crossing;
 }
@@ -517,69 +769,315 @@ bool RssiNode::rssiProcessValue(mtime_t millis, rssi_t rssiVal)
 // Function called when crossing ends (by RSSI or I2C command)
 void RssiNode::rssiEndCrossing()
 {
+    // lap timestamp is between first and last peak RSSI, unless it can be
+    //  refined using the samples around the peak
+    utime_t passMicros = state.passPeak.firstTime + state.passPeak.duration / 2;
+    utime_t refinedMicros = passMicros;
+    rssi_t detectedPeak;
+    uint8_t fitQuality;
+    uint8_t refineMethod;
+    if (detector->getPass(refinedMicros, detectedPeak, fitQuality))
+    {  // detector found pass time itself (fit quality is its match score)
+        refineMethod = PEAK_REFINE_MATCHED;
+        if (detectedPeak > state.passPeak.rssi)
+            state.passPeak.rssi = detectedPeak;
+    }
+    else
+    {
+#if PEAK_REFINE_FLAG
+        fitQuality = peakWindow.refine(PEAK_REFINE_SPAN, refinedMicros);
+        refineMethod = (fitQuality >= PEAK_REFINE_MIN_QUALITY) ? PEAK_REFINE_CENTROID : PEAK_REFINE_NONE;
+#else
+        fitQuality = PEAK_FIT_QUALITY_NONE;
+        refineMethod = PEAK_REFINE_NONE;
+#endif
+    }
+#if PEAK_REFINE_FLAG
+    peakWindow.endPass();
+#endif
+#if ZERO_PHASE_REFINE_FLAG
+    if (refineMethod != PEAK_REFINE_MATCHED &&
+            zeroPhaseWindow.refinePeak(passMicros, SAMPLE_PERIOD_MICROS, ZERO_PHASE_ALPHA_SHIFT,
+                                       refinedMicros))
+        refineMethod = PEAK_REFINE_ZERO_PHASE;
+    zeroPhaseWindow.unfreeze();
+#endif
+    int32_t refineMicros = 0;
+    if (refineMethod != PEAK_REFINE_NONE)
+    {
+        refineMicros = constrain((int32_t)(refinedMicros - passMicros), -0x7FFF, 0x7FFF);
+        passMicros = (refineMethod == PEAK_REFINE_MATCHED) ? refinedMicros : passMicros + refineMicros;
+    }
+#if MATCH_DETECTOR_FLAG
+    if (detectorLearnFlag)
+        matchedDetector.learn();
+#endif
+
     // save values for lap pass
     ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
         lastPass.rssiPeak = state.passPeak.rssi;
-        // lap timestamp is between first and last peak RSSI
-        lastPass.timestamp = state.passPeak.firstTime + state.passPeak.duration / 2;
+        lastPass.timestamp = passMicros;
+        lastPass.fitQuality = fitQuality;
+        lastPass.refineMethod = refineMethod;
+        lastPass.refineMicros = (int16_t)refineMicros;
         lastPass.rssiNadir = state.passRssiNadir;
         lastPass.lap = lastPass.lap + 1;
+        if (provisionalPass.status == PROVISIONAL_PENDING)
+        {
+            provisionalPass.status = PROVISIONAL_CONFIRMED;
+            provisionalPass.timestamp = passMicros;
+            provisionalPass.revision = provisionalPass.revision + 1;
+        }
     }
 
+#if PASS_ENVELOPE_FLAG
+    passEnvelopes.finish(lastPass.lap, passMicros, SAMPLE_PERIOD_MICROS);
+#endif
+    if (history.seekingPeak)
+        declareHistoricPeak();  // pass peak is kept even if within prominence
+
     // reset lap-pass variables
     state.crossing = false;
     state.passPeak.rssi = 0;
     state.passRssiNadir = MAX_RSSI;
+
+#if ADAPTIVE_SAMPLING_FLAG
+    burstRisingFlag = false;
+    setSampleBurst(false);
+#endif
 }
 
+void RssiNode::setEnterAtLevel(rssi_t val)
+{
+    settings.enterAtLevel = val;
+    floorRefValid = false;  // level is relative to current noise floor
+    updateThresholds();
+}
 
-#if STM32_MODE_FLAG
+void RssiNode::setExitAtLevel(rssi_t val)
+{
+    settings.exitAtLevel = val;
+    floorRefValid = false;
+    updateThresholds();
+}
 
-int RssiNode::rx5808SelPinForNodeIndex(int nIdx)
+void RssiNode::setThresholdFloatMax(rssi_t val)
+{
+    settings.thresholdFloatMax = val;
+    floorRefValid = false;
+    updateThresholds();
+}
+
+// Sets EnterAt/ExitAt levels in use; if thresholds float they move with the
+//  noise floor (relative to the floor when the levels were set), by at most
+//  'thresholdFloatMax'
+void RssiNode::updateThresholds()
 {
-    switch (nIdx)
+    int drift = 0;
+    if (settings.thresholdFloatMax > 0 && noiseFloor.isValid())
     {
-        case 1:
-            return RX5808_SEL1_PIN;
-        case 2:
-            return RX5808_SEL2_PIN;
-        case 3:
-            return RX5808_SEL3_PIN;
-        case 4:
-            return RX5808_SEL4_PIN;
-        case 5:
-            return RX5808_SEL5_PIN;
-        case 6:
-            return RX5808_SEL6_PIN;
-        case 7:
-            return RX5808_SEL7_PIN;
-        default:
-            return RX5808_SEL0_PIN;
+        if (!floorRefValid)
+        {
+            floorRefRssi = noiseFloor.getFloor();
+            floorRefValid = true;
+        }
+        drift = constrain((int)noiseFloor.getFloor() - (int)floorRefRssi,
+                          -(int)settings.thresholdFloatMax, (int)settings.thresholdFloatMax);
     }
+    state.enterAtEffective = constrain((int)settings.enterAtLevel + drift, 0, MAX_RSSI);
+    state.exitAtEffective = constrain((int)settings.exitAtLevel + drift, 0, MAX_RSSI);
+    thresholdDetector.setLevels(state.enterAtEffective, state.exitAtEffective);
 }
 
-int RssiNode::rssiInputPinForNodeIndex(int nIdx)
+// Selects crossing detector (DETECTOR_... value; unknown values select
+//  EnterAt/ExitAt thresholds) and whether the matched-filter template is
+//  learned from detected passes; a crossing in progress is ended by the new detector
+//  (thresholds are always used if the matched-filter detector is not built in)
+void RssiNode::setDetector(uint8_t engine, bool learnFlag)
 {
-    switch (nIdx)
+#if MATCH_DETECTOR_FLAG
+    detectorEngine = (engine == DETECTOR_MATCHED) ? DETECTOR_MATCHED : DETECTOR_THRESHOLD;
+    detector = (detectorEngine == DETECTOR_MATCHED) ? (CrossingDetector *)&matchedDetector :
+                                                      (CrossingDetector *)&thresholdDetector;
+    detectorLearnFlag = learnFlag;
+    matchedDetector.reset();
+#else
+    (void)engine;
+    (void)learnFlag;
+#endif
+}
+
+#if CALIBRATION_FLAG
+// Starts capture of filtered RSSI for given time (zero cancels); when finished,
+//  suggested EnterAt/ExitAt levels are set if 'applyFlag' is true
+void RssiNode::startCalibration(uint8_t seconds, bool applyFlag)
+{
+    calibrationApplyFlag = applyFlag;
+    calibration.start((uint32_t)seconds * (1000000UL / SAMPLE_PERIOD_MICROS), CALIBRATION_MIN_RISE,
+                      CALIBRATION_ENTER_PERCENT, CALIBRATION_EXIT_PERCENT);
+}
+#endif
+
+#if RSSI_TRACE_FLAG
+// Selects samples queued for trace streaming (RSSI_TRACE_... value); any queued
+//  samples are discarded and the sequence number restarts
+void RssiNode::setTraceMode(uint8_t mode)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
     {
-        case 1:
-            return RSSI_INPUT1_PIN;
-        case 2:
-            return RSSI_INPUT2_PIN;
-        case 3:
-            return RSSI_INPUT3_PIN;
-        case 4:
-            return RSSI_INPUT4_PIN;
-        case 5:
-            return RSSI_INPUT5_PIN;
-        case 6:
-            return RSSI_INPUT6_PIN;
-        case 7:
-            return RSSI_INPUT7_PIN;
-        default:
-            return RSSI_INPUT0_PIN;
+        rssiTrace.clear();
+        traceMode = (mode <= RSSI_TRACE_RAW) ? mode : RSSI_TRACE_OFF;
+    }
+}
+
+void RssiNode::addTraceSample(rssi_t rssi)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {  // trace may be read by I2C interrupt
+        rssiTrace.add(rssi);
     }
 }
+#endif
+
+// Raises provisional pass at the current pass peak, or amends it if a higher
+//  peak was found after it was raised (confirmed or retracted when crossing ends)
+void RssiNode::updateProvisionalPass()
+{
+    const utime_t peakMicros = state.passPeak.firstTime + state.passPeak.duration / 2;
+    if (provisionalPass.status == PROVISIONAL_PENDING && provisionalPass.timestamp == peakMicros)
+        return;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        provisionalPass.rssiPeak = state.passPeak.rssi;
+        provisionalPass.timestamp = peakMicros;
+        provisionalPass.lap = lastPass.lap + 1;
+        provisionalPass.status = PROVISIONAL_PENDING;
+        provisionalPass.revision = provisionalPass.revision + 1;
+    }
+}
+
+#if ADAPTIVE_SAMPLING_FLAG
+
+// Puts node in burst sampling while a crossing is in progress, RSSI is near
+//  EnterAt or RSSI is rising quickly; otherwise node is sampled at the base rate
+void RssiNode::updateSampleBurst()
+{
+    if (++burstSlopeCount >= SAMPLE_BURST_SLOPE_SAMPLES)
+    {
+        burstRisingFlag = (int)state.rssi - (int)burstSlopeRefRssi >= SAMPLE_BURST_SLOPE;
+        burstSlopeRefRssi = state.rssi;
+        burstSlopeCount = 0;
+    }
+    setSampleBurst(state.crossing || burstRisingFlag ||
+                   (int)state.rssi + SAMPLE_BURST_MARGIN >= (int)state.enterAtEffective);
+}
+
+void RssiNode::setSampleBurst(bool burstFlag)
+{
+    if (burstFlag != sampleBurstFlag)
+    {
+        sampleBurstFlag = burstFlag;
+        sampleScheduler.setSlotBurst(nodeIndex, burstFlag);
+    }
+}
+
+#endif
+
+
+#if STM32_MODE_FLAG
+
+static const int rx5808SelPinMap[] = RX5808_SEL_PIN_MAP;
+
+static_assert(sizeof(rx5808SelPinMap) / sizeof(rx5808SelPinMap[0]) >= MULTI_RHNODE_MAX,
+              "RX5808_SEL_PIN_MAP needs an entry for each node");
+#if RSSI_MUX_FLAG
+static_assert(MULTI_RHNODE_MAX <= (1 << RSSI_MUX_SELECT_BITS),
+              "RSSI multiplexer needs a channel for each node");
+#else
+static const int rssiInputPinMap[] = RSSI_INPUT_PIN_MAP;
+
+static_assert(sizeof(rssiInputPinMap) / sizeof(rssiInputPinMap[0]) >= MULTI_RHNODE_MAX,
+              "RSSI_INPUT_PIN_MAP needs an entry for each node");
+#endif
+
+int RssiNode::rx5808SelPinForNodeIndex(int nIdx)
+{
+    return (nIdx >= 0 && nIdx < MULTI_RHNODE_MAX) ? rx5808SelPinMap[nIdx] : rx5808SelPinMap[0];
+}
+
+int RssiNode::rssiInputPinForNodeIndex(int nIdx)
+{
+#if RSSI_MUX_FLAG
+    (void)nIdx;
+    return RSSI_MUX_INPUT_PIN;
+#else
+    return (nIdx >= 0 && nIdx < MULTI_RHNODE_MAX) ? rssiInputPinMap[nIdx] : rssiInputPinMap[0];
+#endif
+}
+
+#if RSSI_MUX_FLAG
+
+static const int rssiMuxSelectPinMap[RSSI_MUX_SELECT_BITS] = RSSI_MUX_SELECT_PIN_MAP;
+static volatile uint8_t rssiMuxCurrentChannel = 0xFF;
+
+// All nodes are read through the one mux input, so the ADC is set up for it
+//  once here and each reading is a single conversion; 'analogRead()' sets up
+//  and releases the ADC on every call, which at 16 nodes (with oversampling)
+//  would take up most of the sampling interrupt's slot time
+static ADC_HandleTypeDef rssiMuxAdc;
+
+void RssiNode::initRssiMux()
+{
+    for (uint8_t i = 0; i < RSSI_MUX_SELECT_BITS; ++i)
+        pinMode(rssiMuxSelectPinMap[i], OUTPUT);
+    rssiMuxCurrentChannel = 0xFF;
+
+    pinMode(RSSI_MUX_INPUT_PIN, INPUT_ANALOG);
+    __HAL_RCC_ADC1_CLK_ENABLE();  // F4 (the only board with the mux) has ADC1 only
+    rssiMuxAdc.Instance = ADC1;
+    rssiMuxAdc.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+    rssiMuxAdc.Init.Resolution = ADC_RESOLUTION_12B;
+    rssiMuxAdc.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    rssiMuxAdc.Init.ScanConvMode = DISABLE;
+    rssiMuxAdc.Init.ContinuousConvMode = DISABLE;
+    rssiMuxAdc.Init.DiscontinuousConvMode = DISABLE;
+    rssiMuxAdc.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+    rssiMuxAdc.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    rssiMuxAdc.Init.NbrOfConversion = 1;
+    rssiMuxAdc.Init.DMAContinuousRequests = DISABLE;
+    rssiMuxAdc.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+    HAL_ADC_Init(&rssiMuxAdc);
+
+    ADC_ChannelConfTypeDef channelConfig = {};
+    channelConfig.Channel = STM_PIN_CHANNEL(pinmap_function(
+                                analogInputToPinName(RSSI_MUX_INPUT_PIN), PinMap_ADC));
+    channelConfig.Rank = 1;
+    channelConfig.SamplingTime = ADC_SAMPLETIME_56CYCLES;
+    HAL_ADC_ConfigChannel(&rssiMuxAdc, &channelConfig);
+}
+
+// Reads the mux input (returns 0-1023, the same scale as 'analogRead()')
+int RssiNode::rssiMuxAdcRead()
+{
+    HAL_ADC_Start(&rssiMuxAdc);
+    HAL_ADC_PollForConversion(&rssiMuxAdc, 1);
+    return (int)(HAL_ADC_GetValue(&rssiMuxAdc) >> 2);
+}
+
+// Selects multiplexer channel for node; returns false if it was already selected
+//  (the sampling interrupt selects the next node's channel after each sample so
+//  the mux output has the whole slot time to settle)
+bool RssiNode::rssiMuxSelect()
+{
+    if (rssiMuxChannel == rssiMuxCurrentChannel)
+        return false;
+    for (uint8_t i = 0; i < RSSI_MUX_SELECT_BITS; ++i)
+        digitalWrite(rssiMuxSelectPinMap[i], (rssiMuxChannel & (1 << i)) ? HIGH : LOW);
+    rssiMuxCurrentChannel = rssiMuxChannel;
+    return true;
+}
+
+#endif  // RSSI_MUX_FLAG
 
 #endif
@@ -11,8 +11,38 @@
 #include "util/sendbuffer.h"
 #include "util/single-sendbuffer.h"
 #include "util/multi-sendbuffer.h"
-
-#define MAX_DURATION 0xFFFF
+#include "util/sample-scheduler.h"
+#include "util/sample-fifo.h"
+#include "util/peak-window.h"
+#include "util/zero-phase.h"
+#include "util/rssi-calibration.h"
+#include "util/noise-floor.h"
+#include "util/sliding-minmax.h"
+#include "util/rssi-pyramid.h"
+#include "util/rssi-trace.h"
+#include "util/pass-envelope.h"
+#include "util/heat-history.h"
+#include "util/crossing-detector.h"
+#include "util/matched-detector.h"
+
+#define PEAK_REFINE_NONE 0        // lap timestamp is midpoint of peak plateau
+#define PEAK_REFINE_CENTROID 1    // lap timestamp is centroid of filtered samples near peak
+#define PEAK_REFINE_ZERO_PHASE 2  // lap timestamp is peak of zero-phase filtered raw samples
+#define PEAK_REFINE_MATCHED 3     // lap timestamp is correlation maximum of matched-filter detector
+
+#define DETECTOR_THRESHOLD 0      // crossing detected by EnterAt/ExitAt levels
+#define DETECTOR_MATCHED 1        // crossing detected by correlation with pass-shape template
+
+#define PROVISIONAL_NONE 0       // no provisional pass raised yet
+#define PROVISIONAL_PENDING 1    // pass peak detected, crossing still in progress
+#define PROVISIONAL_CONFIRMED 2  // crossing ended and lap recorded (timestamp is final)
+#define PROVISIONAL_RETRACTED 3  // crossing discarded before it ended
+
+#define RSSI_TRACE_OFF 0          // no trace streaming
+#define RSSI_TRACE_FILTERED 1     // trace filtered RSSI samples
+#define RSSI_TRACE_RAW 2          // trace raw RSSI samples (before filter)
+
+#define MAX_DURATION ((utime_t)0xFFFF * 1000)  // micros (reported as 16-bit ms value)
 
 #define RX5808_MIN_TUNETIME 35  // after set freq need to wait this long before read RSSI
 #define RX5808_MIN_BUSTIME 30   // after set freq need to wait this long before setting again
@@ -42,6 +72,12 @@ struct Settings
     rssi_t volatile enterAtLevel = 96;
     // lap pass ends when RSSI goes below this level
     rssi_t volatile exitAtLevel = 80;
+    // provisional pass raised when RSSI falls this far below pass peak (0 = disabled)
+    rssi_t volatile provisionalDrop = PROVISIONAL_PASS_DROP;
+    // EnterAt/ExitAt in use follow noise-floor changes by up to this much (0 = fixed levels)
+    rssi_t volatile thresholdFloatMax = 0;
+    // history peak/nadir declared when RSSI reverses this far from it (1 = every direction change)
+    rssi_t volatile historyProminence = HISTORY_PROMINENCE;
 };
 
 struct State
@@ -49,7 +85,7 @@ struct State
     bool volatile crossing = false; // True when the quad is going through the gate
     rssi_t volatile rssi = 0; // Smoothed rssi value
     rssi_t lastRssi = 0;
-    mtime_t rssiTimestamp = 0; // timestamp of the smoothed value
+    utime_t rssiTimestamp = 0; // timestamp (micros) of the smoothed value
 
     Extremum passPeak = {0, 0, 0}; // peak seen during current pass - only valid if pass.rssi != 0
     rssi_t passRssiNadir = MAX_RSSI; // lowest smoothed rssi seen since end of last pass
@@ -57,6 +93,9 @@ struct State
     rssi_t volatile nodeRssiPeak = 0; // peak smoothed rssi seen since the node frequency was set
     rssi_t volatile nodeRssiNadir = MAX_RSSI; // lowest smoothed rssi seen since the node frequency was set
 
+    rssi_t volatile enterAtEffective = 0; // EnterAt level in use (differs from setting if thresholds float)
+    rssi_t volatile exitAtEffective = 0;  // ExitAt level in use
+
     bool volatile activatedFlag = false; // Set true after initial WRITE_FREQUENCY command received
 
     // variables to track the loop time
@@ -75,16 +114,36 @@ struct History
     SendBuffer<Extremum> *nadirSend;
 
     int8_t rssiChange; // >0 for raising, <0 for falling
+    bool seekingPeak = true; // peak in progress (else nadir)
+};
+
+struct SampleGapStats
+{
+    uint32_t missedCount = 0;     // samples missing from sample stream (since startup)
+    uint16_t gapCount = 0;        // number of gaps in sample stream
+    uint16_t maxGapSamples = 0;   // most samples missing in one gap
 };
 
 struct LastPass
 {
     rssi_t volatile rssiPeak = 0;
-    mtime_t volatile timestamp = 0;
+    utime_t volatile timestamp = 0;  // micros
+    uint8_t volatile fitQuality = PEAK_FIT_QUALITY_NONE;  // quality of timestamp refinement
+    uint8_t volatile refineMethod = PEAK_REFINE_NONE;
+    int16_t volatile refineMicros = 0;  // refined timestamp minus peak-plateau midpoint
     rssi_t volatile rssiNadir = MAX_RSSI;
     uint8_t volatile lap = 0;
 };
 
+struct ProvisionalPass
+{
+    utime_t volatile timestamp = 0;  // micros (midpoint of pass-peak plateau until confirmed)
+    rssi_t volatile rssiPeak = 0;
+    uint8_t volatile lap = 0;        // lap number that pass will have when confirmed
+    uint8_t volatile status = PROVISIONAL_NONE;
+    uint8_t volatile revision = 0;   // incremented whenever status or timestamp changes
+};
+
 
 class RssiNode
 {
@@ -95,6 +154,9 @@ class RssiNode
     uint16_t rx5808ClkPin = 0;   //CLK (CH3) output line to RX5808 module
     uint16_t rx5808SelPin = 0;   //SEL (CH2) output line to RX5808 module
     uint16_t rssiInputPin = 0;   //RSSI input from RX5808
+#if RSSI_MUX_FLAG
+    uint8_t rssiMuxChannel = 0;  //multiplexer channel for RSSI input
+#endif
 
     FILTER_IMPL defaultFilter;
     PEAK_SENDBUFFER_IMPL defaultPeakSendBuffer;
@@ -105,9 +167,62 @@ class RssiNode
     struct State state;
     struct History history;
     struct LastPass lastPass;
+    struct ProvisionalPass provisionalPass;
+#if CALIBRATION_FLAG
+    RssiCalibration<CALIBRATION_BIN_SHIFT> calibration;  //capture for suggesting EnterAt/ExitAt
+    bool calibrationApplyFlag = false;  //set EnterAt/ExitAt when calibration capture finishes
+#endif
+    NoiseFloorTracker<NOISE_FLOOR_BLOCKS> noiseFloor;
+    rssi_t floorRefRssi = 0;            //noise floor when EnterAt/ExitAt were set
+    bool floorRefValid = false;
+#if RSSI_WINDOWS_FLAG
+    SlidingMinMax<RSSI_WINDOW_BLOCKS> rssiWindows[RSSI_WINDOW_COUNT];  //recent max/min RSSI
+#endif
+#if RSSI_PYRAMID_FLAG
+    RssiPyramid<RSSI_PYRAMID_TIERS, RSSI_PYRAMID_SIZE, RSSI_PYRAMID_FACTOR> rssiPyramid;  //RSSI summary at several resolutions
+#endif
+#if RSSI_TRACE_FLAG
+    RssiTrace<RSSI_TRACE_SIZE> rssiTrace;  //samples queued for trace streaming
+    uint8_t volatile traceMode = RSSI_TRACE_OFF;
+#endif
+#if PASS_ENVELOPE_FLAG
+    PassEnvelopeStore<PASS_ENVELOPE_POINTS, PASS_ENVELOPE_PASSES> passEnvelopes;  //RSSI of recent passes
+#endif
+#if HEAT_HISTORY_FLAG
+    HeatHistory<HEAT_HISTORY_BYTES> heatHistory;  //peaks/nadirs of current heat (for recomputing laps)
+#endif
+#if PEAK_REFINE_FLAG
+    PeakWindow<PEAK_WINDOW_SIZE> peakWindow;  //recent filtered samples for refining lap timestamp
+#endif
+    ThresholdDetector thresholdDetector;
+#if MATCH_DETECTOR_FLAG
+    MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> matchedDetector;
+#endif
+    CrossingDetector *detector = &thresholdDetector;  //engine deciding crossing start and end
+    uint8_t detectorEngine = DETECTOR_THRESHOLD;
+    bool detectorLearnFlag = false;    //learn matched-filter template from detected passes
+#if ZERO_PHASE_REFINE_FLAG
+    ZeroPhaseWindow<ZERO_PHASE_WINDOW_SIZE, ZERO_PHASE_HALF_WIDTH> zeroPhaseWindow;  //recent raw samples
+#endif
+
+    SampleFifo<SAMPLE_FIFO_SIZE> sampleFifo;  //samples from sampling interrupt
+    bool sampleResyncFlag = true;      //sampling paused since last sample queued (interrupt only)
+    uint16_t acquireSum = 0;           //sum of readings for oversampled sample (interrupt only)
+    uint8_t acquireCount = 0;          //readings in 'acquireSum'
+    utime_t acquireStartMicros = 0;    //time of first reading in 'acquireSum'
+#if ADAPTIVE_SAMPLING_FLAG
+    bool sampleBurstFlag = true;       //node is in burst sampling (near a crossing)
+    bool burstRisingFlag = false;      //RSSI rose by SAMPLE_BURST_SLOPE over last slope interval
+    rssi_t burstSlopeRefRssi = 0;      //RSSI at start of slope interval
+    uint8_t burstSlopeCount = 0;       //samples in slope interval
+#endif
+    utime_t lastSampleMicros = 0;      //time of last sample processed from FIFO
+    rssi_t lastSampleRssi = 0;
+    struct SampleGapStats gapStats;
 
     bool rxPoweredDown = false;
-    bool recentSetFreqFlag = false;
+    bool volatile rxTuningFlag = false;  //true while RX5808 registers are being written
+    bool volatile recentSetFreqFlag = false;
     mtime_t lastSetFreqTimeMs = 0;
     static mtime_t lastRX5808BusTimeMs;
 
@@ -123,7 +238,21 @@ class RssiNode
 
     void bufferHistoricPeak(bool force);
     void bufferHistoricNadir(bool force);
+    void updateHistoricPeakDuration();
+    void updateHistoricNadirDuration();
+    void declareHistoricPeak();
+    void declareHistoricNadir();
     void initExtremum(Extremum *e);
+    void fillSampleGap(utime_t timeMicros, rssi_t rssiVal);
+    void updateProvisionalPass();
+    void updateThresholds();
+#if RSSI_TRACE_FLAG
+    void addTraceSample(rssi_t rssi);
+#endif
+#if ADAPTIVE_SAMPLING_FLAG
+    void updateSampleBurst();
+    void setSampleBurst(bool burstFlag);
+#endif
 
     static uint16_t freqMhzToRegVal(uint16_t freqInMhz);
 #if STM32_MODE_FLAG
@@ -132,23 +261,36 @@ class RssiNode
 #endif
 
 public:
+#if RSSI_WINDOWS_FLAG
+    static const uint8_t rssiWindowSecs[RSSI_WINDOW_COUNT];
+#endif
     static RssiNode rssiNodeArray[MULTI_RHNODE_MAX];
     static uint8_t multiRssiNodeCount;
+    static SampleScheduler<MULTI_RHNODE_MAX, SAMPLE_OVERSAMPLE_MAX> sampleScheduler;  //timing of samples for nodes
 
     RssiNode();
     void initRx5808Pins(int nIdx);
     void initRxModule();
     void copyNodeData(RssiNode *srcPtr);
     void setRxModuleToFreq(uint16_t vtxFreq);
+#if RSSI_MUX_FLAG
+    static void initRssiMux();
+    static int rssiMuxAdcRead();
+    bool rssiMuxSelect();
+#endif
     bool testRxModuleRegister();
 
     rssi_t rssiRead();
+    rssi_t rssiReadRaw();
+    void rssiAcquire(utime_t timeMicros, uint8_t oversampleCount = 1);
+    void restartSampling();
+    uint8_t rssiProcessSamples();
     void rssiSetFilter(Filter<rssi_t> *f);
     void rssiSetSendBuffers(SendBuffer<Extremum> *peak, SendBuffer<Extremum> *nadir);
     void rssiInit();
     bool rssiStateValid();
     void rssiStateReset();  //restarts rssi peak tracking for node
-    bool rssiProcessValue(mtime_t millis, rssi_t rssiVal);
+    bool rssiProcessValue(utime_t timeMicros, rssi_t rssiVal);
     void rssiEndCrossing();
 
     uint8_t getNodeIndex() { return nodeIndex; }
@@ -158,14 +300,56 @@ public:
     uint16_t getVtxFreq() { return settings.vtxFreq; }
     void setVtxFreq(uint16_t freqVal) { settings.vtxFreq = freqVal; }
     rssi_t getEnterAtLevel() { return settings.enterAtLevel; }
-    void setEnterAtLevel(rssi_t val) { settings.enterAtLevel = val; }
+    void setEnterAtLevel(rssi_t val);
     rssi_t getExitAtLevel() { return settings.exitAtLevel; }
-    void setExitAtLevel(rssi_t val) { settings.exitAtLevel = val; }
-    bool rssiProcess(mtime_t millis) { return rssiProcessValue(millis, rssiRead()); }
+    void setExitAtLevel(rssi_t val);
+    rssi_t getThresholdFloatMax() { return settings.thresholdFloatMax; }
+    void setThresholdFloatMax(rssi_t val);
+    rssi_t getProvisionalDrop() { return settings.provisionalDrop; }
+    void setProvisionalDrop(rssi_t val) { settings.provisionalDrop = val; }
+    rssi_t getHistoryProminence() { return settings.historyProminence; }
+    void setHistoryProminence(rssi_t val) { settings.historyProminence = val; }
+#if CALIBRATION_FLAG
+    void startCalibration(uint8_t seconds, bool applyFlag);
+#endif
+    uint8_t getDetectorEngine() { return detectorEngine; }
+    bool getDetectorLearnFlag() { return detectorLearnFlag; }
+    void setDetector(uint8_t engine, bool learnFlag);
+#if RSSI_TRACE_FLAG
+    uint8_t getTraceMode() { return traceMode; }
+    void setTraceMode(uint8_t mode);
+#endif
+    bool rssiProcess(utime_t timeMicros) { return rssiProcessValue(timeMicros, rssiRead()); }
 
     struct State & getState() { return state; }
     struct History & getHistory() { return history; }
     struct LastPass & getLastPass()  { return lastPass; }
+    struct ProvisionalPass & getProvisionalPass() { return provisionalPass; }
+#if CALIBRATION_FLAG
+    RssiCalibration<CALIBRATION_BIN_SHIFT> & getCalibration() { return calibration; }
+#endif
+    NoiseFloorTracker<NOISE_FLOOR_BLOCKS> & getNoiseFloor() { return noiseFloor; }
+#if RSSI_WINDOWS_FLAG
+    SlidingMinMax<RSSI_WINDOW_BLOCKS> & getRssiWindow(uint8_t idx) { return rssiWindows[idx]; }
+#endif
+#if RSSI_PYRAMID_FLAG
+    RssiPyramid<RSSI_PYRAMID_TIERS, RSSI_PYRAMID_SIZE, RSSI_PYRAMID_FACTOR> & getRssiPyramid() { return rssiPyramid; }
+#endif
+#if PASS_ENVELOPE_FLAG
+    PassEnvelopeStore<PASS_ENVELOPE_POINTS, PASS_ENVELOPE_PASSES> & getPassEnvelopes() { return passEnvelopes; }
+#endif
+#if RSSI_TRACE_FLAG
+    RssiTrace<RSSI_TRACE_SIZE> & getRssiTrace() { return rssiTrace; }
+#endif
+#if MATCH_DETECTOR_FLAG
+    MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> & getMatchedDetector() { return matchedDetector; }
+#endif
+#if HEAT_HISTORY_FLAG
+    HeatHistory<HEAT_HISTORY_BYTES> & getHeatHistory() { return heatHistory; }
+#endif
+    SampleFifo<SAMPLE_FIFO_SIZE> & getSampleFifo() { return sampleFifo; }
+    bool isRxPoweredDown() { return rxPoweredDown; }
+    struct SampleGapStats & getSampleGapStats() { return gapStats; }
 };
 
 
@@ -23,6 +23,82 @@ void handleStatusMessage(byte msgTypeVal, byte msgDataVal);
 
 uint8_t settingChangedFlags = 0;
 
+TimeSync timeSync;  // offset/skew between node and server clocks
+
+TaskScheduler<HOUSEKEEPING_TASK_MAX> housekeepingTasks;  // tasks run by main loop
+
+// race start time (set via WRITE_RACE_EPOCH) that lap times are reported relative to
+struct RaceEpoch
+{
+    uint8_t id = RACE_EPOCH_ID_NONE;
+    mtime_t nodeMs = 0;
+    utime_t nodeMicros = 0;
+};
+static RaceEpoch raceEpoch;
+
+// Sets race epoch from race start in server time; if clocks are not synchronized
+//  then start is taken relative to when the command was sent
+static void setRaceEpoch(uint32_t startServerMs, uint32_t sendServerMs, uint8_t epochId)
+{
+    utime_t nowMicros = micros();
+    mtime_t nowMs = millis();
+    raceEpoch.nodeMs = timeSync.isSynced() ? timeSync.toNodeTime(startServerMs) :
+                                              nowMs - (int32_t)(sendServerMs - startServerMs);
+    raceEpoch.nodeMicros = nowMicros - (utime_t)(nowMs - raceEpoch.nodeMs) * 1000;
+    raceEpoch.id = epochId;
+}
+
+// Returns micros from race epoch to given time; the 32-bit micros difference is
+//  extended using the millis difference so it stays valid when micros wraps
+static int64_t getRaceEpochOffsetMicros(utime_t timeMicros, utime_t nowMicros, mtime_t nowMs)
+{
+    mtime_t timeMs = nowMs - (nowMicros - timeMicros) / 1000;
+    int64_t approxMicros = (int64_t)(int32_t)(timeMs - raceEpoch.nodeMs) * 1000;
+    utime_t wrappedMicros = timeMicros - raceEpoch.nodeMicros;
+    int64_t wraps = (approxMicros - (int64_t)wrappedMicros + ((int64_t)1 << 31)) >> 32;
+    return (wraps << 32) + wrappedMicros;
+}
+
+#if RSSI_PYRAMID_FLAG
+// tier and start offset (entries before newest) for next READ_RSSI_PYRAMID
+struct PyramidQuery
+{
+    uint8_t tier = 0;
+    uint8_t offset = 0;
+};
+static PyramidQuery pyramidQuery;
+#endif
+
+#if PASS_ENVELOPE_FLAG
+// lap number and start point for next READ_PASS_ENVELOPE
+struct EnvelopeQuery
+{
+    uint8_t lap = 0;
+    uint8_t offset = 0;
+};
+static EnvelopeQuery envelopeQuery;
+#endif
+
+#if MATCH_DETECTOR_FLAG
+static uint8_t detectorTemplateOffset = 0;  // start point for next READ_CROSSING_DETECTOR
+#endif
+
+#if HEAT_HISTORY_FLAG
+// EnterAt/ExitAt and start pass for next READ_RECOMPUTED_LAPS, with the passes
+//  found by replaying the heat history once for those levels (pages are read
+//  from them, so the history is not replayed for each read)
+struct RecomputeQuery
+{
+    rssi_t enterAt = 0;
+    rssi_t exitAt = 0;
+    uint8_t offset = 0;
+    RssiNode *nodePtr = NULL;  // node whose history was replayed
+    uint8_t passCount = 0;
+    HistoryPass passes[HEAT_HISTORY_RESULT_PASSES];
+};
+static RecomputeQuery recomputeQuery;
+#endif
+
 RssiNode *cmdRssiNodePtr = &(RssiNode::rssiNodeArray[0]);  //current RssiNode for commands
 
 RssiNode *getCmdRssiNodePtr()
@@ -39,6 +115,10 @@ byte Message::getPayloadSize()
             size = 2;
             break;
 
+        case WRITE_BCAST_FREQUENCY:  // table of frequencies for all nodes
+            size = BCAST_PAYLOAD_SIZE;
+            break;
+
         case WRITE_ENTER_AT_LEVEL:  // lap pass begins when RSSI is at or above this level
             size = 1;
             break;
@@ -47,10 +127,62 @@ byte Message::getPayloadSize()
             size = 1;
             break;
 
+        case WRITE_BCAST_ENTER_EXIT:  // table of EnterAt/ExitAt values for all nodes
+            size = BCAST_PAYLOAD_SIZE;
+            break;
+
         case SEND_STATUS_MESSAGE:  // status message sent from server to node
             size = 2;
             break;
 
+        case WRITE_TIME_SYNC:  // server send time and previous response receive time
+            size = 8;
+            break;
+
+        case WRITE_RACE_EPOCH:  // race start time, server send time and epoch ID
+            size = 9;
+            break;
+
+        case WRITE_PROVISIONAL_DROP:  // RSSI drop below pass peak that raises provisional pass
+            size = 1;
+            break;
+
+        case WRITE_CALIBRATE:  // capture time (seconds) and flags
+            size = 2;
+            break;
+
+        case WRITE_THRESHOLD_FLOAT:  // max drift of EnterAt/ExitAt with noise floor
+            size = 1;
+            break;
+
+        case WRITE_RSSI_PYRAMID_QUERY:  // tier and start offset
+            size = 2;
+            break;
+
+        case WRITE_RSSI_TRACE_MODE:  // RSSI_TRACE_... value
+            size = 1;
+            break;
+
+        case WRITE_PASS_ENVELOPE_QUERY:  // lap number and start point
+            size = 2;
+            break;
+
+        case WRITE_RECOMPUTE_LAPS:  // EnterAt, ExitAt and start pass
+            size = 3;
+            break;
+
+        case WRITE_HISTORY_PROMINENCE:  // RSSI reversal that declares a history peak/nadir
+            size = 1;
+            break;
+
+        case WRITE_CROSSING_DETECTOR:  // engine, flags, min correlation (percent) and min rise
+            size = 4;
+            break;
+
+        case WRITE_DETECTOR_TEMPLATE:  // start point, point count and template points
+            size = 2 + DETECTOR_TEMPLATE_WRITE_POINTS;
+            break;
+
         case FORCE_END_CROSSING:  // kill current crossing flag regardless of RSSI value
             size = 1;
             break;
@@ -90,6 +222,56 @@ void resetPairedNode(int pinState)
 #endif
 }
 
+void setNodeFrequency(RssiNode *rssiNodePtr, uint16_t freqVal)
+{
+    if (freqVal >= MIN_FREQ && freqVal <= MAX_FREQ)
+    {
+        if (freqVal != rssiNodePtr->getVtxFreq())
+        {
+            rssiNodePtr->setVtxFreq(freqVal);
+            settingChangedFlags |= FREQ_CHANGED;
+#if STM32_MODE_FLAG
+            rssiNodePtr->rssiStateReset();  // restart rssi peak tracking for node
+#endif
+        }
+        settingChangedFlags |= FREQ_SET;
+#if STM32_MODE_FLAG  // need to wait here for completion to avoid data overruns
+        rssiNodePtr->setRxModuleToFreq(freqVal);
+        rssiNodePtr->setActivatedFlag(true);
+#endif
+    }
+}
+
+void setNodeEnterAtLevel(RssiNode *rssiNodePtr, rssi_t rssiVal)
+{
+    if (rssiVal != rssiNodePtr->getEnterAtLevel())
+    {
+        rssiNodePtr->setEnterAtLevel(rssiVal);
+        settingChangedFlags |= ENTERAT_CHANGED;
+    }
+}
+
+void setNodeExitAtLevel(RssiNode *rssiNodePtr, rssi_t rssiVal)
+{
+    if (rssiVal != rssiNodePtr->getExitAtLevel())
+    {
+        rssiNodePtr->setExitAtLevel(rssiVal);
+        settingChangedFlags |= EXITAT_CHANGED;
+    }
+}
+
+// Returns index of entry in WRITE_BCAST_... table for given node, or -1 if none
+int bcastTableIndexForNode(uint8_t nIdx)
+{
+#if STM32_MODE_FLAG
+    int tIdx = nIdx;
+#else
+    (void)nIdx;
+    int tIdx = ((int)i2cAddress - 8) / 2;
+#endif
+    return (tIdx >= 0 && tIdx < BCAST_TABLE_SIZE) ? tIdx : -1;
+}
+
 // Generic IO write command handler
 void Message::handleWriteCommand(bool serialFlag)
 {
@@ -97,6 +279,7 @@ void Message::handleWriteCommand(bool serialFlag)
     uint16_t u16val;
     rssi_t rssiVal;
     uint8_t nIdx;
+    int tIdx;
 
     buffer.flipForRead();
     bool actFlag = true;
@@ -104,40 +287,42 @@ void Message::handleWriteCommand(bool serialFlag)
     switch (command)
     {
         case WRITE_FREQUENCY:
-            u16val = buffer.read16();
-            if (u16val >= MIN_FREQ && u16val <= MAX_FREQ)
+            setNodeFrequency(cmdRssiNodePtr, buffer.read16());
+            break;
+
+        case WRITE_BCAST_FREQUENCY:  // pick out entries for nodes on this processor
+            u8val = buffer.read8();
+            for (nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
             {
-                if (u16val != cmdRssiNodePtr->getVtxFreq())
+                tIdx = bcastTableIndexForNode(nIdx);
+                if (tIdx >= 0 && (u8val & (1 << tIdx)))
                 {
-                    cmdRssiNodePtr->setVtxFreq(u16val);
-                    settingChangedFlags |= FREQ_CHANGED;
-#if STM32_MODE_FLAG
-                    cmdRssiNodePtr->rssiStateReset();  // restart rssi peak tracking for node
-#endif
+                    buffer.index = 1 + tIdx * 2;
+                    setNodeFrequency(&(RssiNode::rssiNodeArray[nIdx]), buffer.read16());
                 }
-                settingChangedFlags |= FREQ_SET;
-#if STM32_MODE_FLAG  // need to wait here for completion to avoid data overruns
-                cmdRssiNodePtr->setRxModuleToFreq(u16val);
-                cmdRssiNodePtr->setActivatedFlag(true);
-#endif
             }
             break;
 
         case WRITE_ENTER_AT_LEVEL:  // lap pass begins when RSSI is at or above this level
-            rssiVal = ioBufferReadRssi(buffer);
-            if (rssiVal != cmdRssiNodePtr->getEnterAtLevel())
-            {
-                cmdRssiNodePtr->setEnterAtLevel(rssiVal);
-                settingChangedFlags |= ENTERAT_CHANGED;
-            }
+            setNodeEnterAtLevel(cmdRssiNodePtr, ioBufferReadRssi(buffer));
             break;
 
         case WRITE_EXIT_AT_LEVEL:  // lap pass ends when RSSI goes below this level
-            rssiVal = ioBufferReadRssi(buffer);
-            if (rssiVal != cmdRssiNodePtr->getExitAtLevel())
+            setNodeExitAtLevel(cmdRssiNodePtr, ioBufferReadRssi(buffer));
+            break;
+
+        case WRITE_BCAST_ENTER_EXIT:  // pick out entries for nodes on this processor
+            u8val = buffer.read8();
+            for (nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
             {
-                cmdRssiNodePtr->setExitAtLevel(rssiVal);
-                settingChangedFlags |= EXITAT_CHANGED;
+                tIdx = bcastTableIndexForNode(nIdx);
+                if (tIdx >= 0 && (u8val & (1 << tIdx)))
+                {
+                    buffer.index = 1 + tIdx * 2;
+                    rssiVal = ioBufferReadRssi(buffer);
+                    setNodeEnterAtLevel(&(RssiNode::rssiNodeArray[nIdx]), rssiVal);
+                    setNodeExitAtLevel(&(RssiNode::rssiNodeArray[nIdx]), ioBufferReadRssi(buffer));
+                }
             }
             break;
 
@@ -147,6 +332,119 @@ void Message::handleWriteCommand(bool serialFlag)
                 cmdRssiNodePtr = &(RssiNode::rssiNodeArray[nIdx]);
             break;
 
+        case WRITE_TIME_SYNC:  // server send time and previous response receive time
+            {
+                uint32_t serverSendMs = buffer.read32();
+                timeSync.requestReceived(serverSendMs, buffer.read32(), millis());
+            }
+            break;
+
+        case WRITE_RACE_EPOCH:  // race start time, server send time and epoch ID
+            {
+                uint32_t startServerMs = buffer.read32();
+                uint32_t sendServerMs = buffer.read32();
+                setRaceEpoch(startServerMs, sendServerMs, buffer.read8());
+#if HEAT_HISTORY_FLAG
+                for (uint8_t i = 0; i < RssiNode::multiRssiNodeCount; ++i)
+                    RssiNode::rssiNodeArray[i].getHeatHistory().clear();  // heat starts
+#endif
+            }
+            break;
+
+        case WRITE_PROVISIONAL_DROP:  // RSSI drop below pass peak that raises provisional pass
+            cmdRssiNodePtr->setProvisionalDrop(ioBufferReadRssi(buffer));
+            break;
+
+#if CALIBRATION_FLAG
+        case WRITE_CALIBRATE:  // capture time (seconds, zero cancels) and flags
+            u8val = buffer.read8();
+            cmdRssiNodePtr->startCalibration(u8val, (buffer.read8() & CALIBRATE_FLAG_APPLY) != 0);
+            break;
+#endif
+
+        case WRITE_THRESHOLD_FLOAT:  // max drift of EnterAt/ExitAt with noise floor (0 = fixed levels)
+            cmdRssiNodePtr->setThresholdFloatMax(ioBufferReadRssi(buffer));
+            break;
+
+#if RSSI_PYRAMID_FLAG
+        case WRITE_RSSI_PYRAMID_QUERY:  // tier and start offset for READ_RSSI_PYRAMID
+            u8val = buffer.read8();
+            pyramidQuery.tier = (u8val < RSSI_PYRAMID_TIERS) ? u8val : (RSSI_PYRAMID_TIERS - 1);
+            pyramidQuery.offset = buffer.read8();
+            break;
+#endif
+
+#if RSSI_TRACE_FLAG
+        case WRITE_RSSI_TRACE_MODE:  // start or stop trace streaming (RSSI_TRACE_... value)
+            cmdRssiNodePtr->setTraceMode(buffer.read8());
+            break;
+#endif
+
+#if PASS_ENVELOPE_FLAG
+        case WRITE_PASS_ENVELOPE_QUERY:  // lap number and start point for READ_PASS_ENVELOPE
+            envelopeQuery.lap = buffer.read8();
+            envelopeQuery.offset = buffer.read8();
+            break;
+#endif
+
+        case WRITE_HISTORY_PROMINENCE:  // RSSI reversal that declares a history peak/nadir (1 = every reversal)
+            cmdRssiNodePtr->setHistoryProminence(ioBufferReadRssi(buffer));
+            break;
+
+#if MATCH_DETECTOR_FLAG
+        case WRITE_CROSSING_DETECTOR:  // DETECTOR_... value, DETECTOR_FLAG_... value, min correlation
+                                       //  (percent) and min RSSI rise for matched-filter detector
+            {
+                const uint8_t engine = buffer.read8();
+                const uint8_t flags = buffer.read8();
+                const uint16_t minCorrQ8 = (uint16_t)min(buffer.read8(), (uint8_t)100) * 256 / 100;
+                cmdRssiNodePtr->getMatchedDetector().setLimits((minCorrQ8 < 0xFF) ? minCorrQ8 : 0xFF,
+                                                               ioBufferReadRssi(buffer));
+                cmdRssiNodePtr->setDetector(engine, (flags & DETECTOR_FLAG_LEARN) != 0);
+            }
+            break;
+
+        case WRITE_DETECTOR_TEMPLATE:  // start point (DETECTOR_TEMPLATE_DEFAULT restores default
+                                       //  template), count and values (0-100) of points to write
+            {
+                MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> &matchedDetector =
+                        cmdRssiNodePtr->getMatchedDetector();
+                const uint8_t offset = buffer.read8();
+                const uint8_t count = buffer.read8();
+                for (uint8_t i = 0; i < DETECTOR_TEMPLATE_WRITE_POINTS; ++i)
+                {
+                    const uint8_t val = buffer.read8();
+                    if (i < count && offset + i < MATCH_DETECTOR_TAPS)
+                        matchedDetector.setTemplatePoint(offset + i, val);
+                }
+                if (offset == DETECTOR_TEMPLATE_DEFAULT)
+                    matchedDetector.setDefaultTemplate();
+                detectorTemplateOffset = (offset < MATCH_DETECTOR_TAPS) ? offset : 0;
+            }
+            break;
+#endif
+
+#if HEAT_HISTORY_FLAG
+        case WRITE_RECOMPUTE_LAPS:  // EnterAt, ExitAt and start pass for READ_RECOMPUTED_LAPS
+            {
+                const rssi_t enterAt = ioBufferReadRssi(buffer);
+                const rssi_t exitAt = ioBufferReadRssi(buffer);
+                recomputeQuery.offset = buffer.read8();
+                if (recomputeQuery.offset == 0 || recomputeQuery.nodePtr != cmdRssiNodePtr ||
+                        enterAt != recomputeQuery.enterAt || exitAt != recomputeQuery.exitAt)
+                {  // new request (later pages use the same result)
+                    recomputeQuery.enterAt = enterAt;
+                    recomputeQuery.exitAt = exitAt;
+                    recomputeQuery.nodePtr = cmdRssiNodePtr;
+                    const uint16_t total = cmdRssiNodePtr->getHeatHistory().replay(enterAt, exitAt, 0,
+                            recomputeQuery.passes, HEAT_HISTORY_RESULT_PASSES);
+                    recomputeQuery.passCount = (total < HEAT_HISTORY_RESULT_PASSES) ?
+                                               (uint8_t)total : HEAT_HISTORY_RESULT_PASSES;
+                }
+            }
+            break;
+#endif
+
         case SEND_STATUS_MESSAGE:  // status message sent from server to node
             u16val = buffer.read16();  // upper byte is message type, lower byte is data
             handleStatusMessage((byte)(u16val >> 8), (byte)(u16val & 0x00FF));
@@ -183,11 +481,12 @@ void Message::handleWriteCommand(bool serialFlag)
     command = 0;  // Clear previous command
 }
 
-void ioBufferWriteExtremum(Buffer& buf, const Extremum& e, mtime_t now)
+// times are sent as ms values
+void ioBufferWriteExtremum(Buffer& buf, const Extremum& e, utime_t nowMicros)
 {
     ioBufferWriteRssi(buf, e.rssi);
-    buf.write16(uint16_t(now - e.firstTime));
-    buf.write16(e.duration);
+    buf.write16(uint16_t((nowMicros - e.firstTime) / 1000));
+    buf.write16(uint16_t(e.duration / 1000));
 }
 
 // Generic IO read command handler
@@ -216,20 +515,25 @@ void Message::handleReadCommand(bool serialFlag)
 
         case READ_LAP_STATS:  // deprecated; use READ_LAP_PASS_STATS and READ_LAP_EXTREMUMS
             {
-                mtime_t timeNowVal = millis();
-                handleReadLapPassStats(timeNowVal);
-                handleReadLapExtremums(timeNowVal);
+                utime_t timeNowMicros = micros();
+                handleReadLapPassStats(timeNowMicros);
+                handleReadLapExtremums(timeNowMicros);
                 settingChangedFlags |= LAPSTATS_READ;
             }
             break;
 
         case READ_LAP_PASS_STATS:
-            handleReadLapPassStats(millis());
+            handleReadLapPassStats(micros());
             settingChangedFlags |= LAPSTATS_READ;
             break;
 
         case READ_LAP_EXTREMUMS:
-            handleReadLapExtremums(millis());
+            handleReadLapExtremums(micros());
+            break;
+
+        case READ_LAP_STATS_DELTA:  // only fields changed since previous lap-stats read
+            handleReadLapStatsDelta(micros());
+            settingChangedFlags |= LAPSTATS_READ;
             break;
 
         case READ_ENTER_AT_LEVEL:  // lap pass begins when RSSI is at or above this level
@@ -240,8 +544,361 @@ void Message::handleReadCommand(bool serialFlag)
             ioBufferWriteRssi(buffer, cmdRssiNodePtr->getExitAtLevel());
             break;
 
+        case READ_NODE_SETTINGS:  // frequency, EnterAt and ExitAt (confirms WRITE_BCAST_... values)
+            buffer.write16(cmdRssiNodePtr->getVtxFreq());
+            ioBufferWriteRssi(buffer, cmdRssiNodePtr->getEnterAtLevel());
+            ioBufferWriteRssi(buffer, cmdRssiNodePtr->getExitAtLevel());
+            break;
+
+        case READ_TIME_SYNC:  // node receive and send times for exchange, then current estimate
+            {
+                mtime_t timeNowVal = millis();
+                buffer.write32(timeSync.getRequestRecvTime());
+                buffer.write32(timeNowVal);
+                buffer.write32(uint32_t(timeSync.getOffset()));
+                buffer.write16(uint16_t(int16_t(timeSync.getSkewPpm())));
+                buffer.write16(timeSync.getBoundMs(timeNowVal));
+                buffer.write8(timeSync.getSampleCount());
+                timeSync.responseSent(timeNowVal);
+            }
+            break;
+
+        case READ_LAP_SYNC_TIME:  // last lap timestamp in server time, with error bound
+            {   // lap was 'lapMicrosBefore' micros before node time 'lapMs'
+                utime_t sinceLapMicros = micros() - cmdRssiNodePtr->getLastPass().timestamp;
+                mtime_t lapMs = millis() - sinceLapMicros / 1000;
+                buffer.write8(cmdRssiNodePtr->getLastPass().lap);
+                buffer.write32(timeSync.toServerTime(lapMs));
+                buffer.write16(timeSync.getBoundMs(lapMs));
+                buffer.write16(uint16_t(sinceLapMicros % 1000));  // lapMicrosBefore
+            }
+            break;
+
+        case READ_LAP_EPOCH_OFFSET:  // last lap time relative to race epoch, as ms and micros
+            {
+                buffer.write8(cmdRssiNodePtr->getLastPass().lap);
+                buffer.write8(raceEpoch.id);
+                if (raceEpoch.id != RACE_EPOCH_ID_NONE)
+                {
+                    utime_t nowMicros = micros();
+                    int64_t offsetMicros = getRaceEpochOffsetMicros(
+                            cmdRssiNodePtr->getLastPass().timestamp, nowMicros, millis());
+                    int64_t offsetMs = (offsetMicros >= 0) ? offsetMicros / 1000 :
+                                                             -((999 - offsetMicros) / 1000);
+                    buffer.write32(uint32_t(int32_t(offsetMs)));
+                    buffer.write16(uint16_t(offsetMicros - offsetMs * 1000));
+                }
+                else
+                {
+                    buffer.write32(RACE_EPOCH_OFFSET_NONE);
+                    buffer.write16(0);
+                }
+            }
+            break;
+
+        case READ_SAMPLE_STATS:  // sample timing, FIFO, gap and load-shed stats for node (max values cleared after read)
+            {
+                SampleGapStats &gapStats = cmdRssiNodePtr->getSampleGapStats();
+                SampleSlotStats stats;
+                uint8_t fifoHighWater;
+                uint16_t fifoOverflows;
+                SampleFifo<SAMPLE_FIFO_SIZE> &fifo = cmdRssiNodePtr->getSampleFifo();
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    stats = RssiNode::sampleScheduler.readStats(cmdRssiNodePtr->getNodeIndex());
+                    fifoHighWater = fifo.getHighWater();
+                    fifoOverflows = fifo.getOverflowCount();
+                    fifo.clearHighWater();
+                }
+                buffer.write16(stats.jitterMax);
+                buffer.write16(stats.jitterAvg);
+                buffer.write16(stats.processMax);
+                buffer.write16(stats.overBudgetCount);
+                buffer.write8(fifoHighWater);
+                buffer.write16(fifoOverflows);
+                buffer.write32(gapStats.missedCount);
+                buffer.write16(gapStats.gapCount);
+                buffer.write16(gapStats.maxGapSamples);
+                buffer.write16(housekeepingTasks.getShedCount());
+                gapStats.maxGapSamples = 0;
+            }
+            break;
+
+        case READ_LAP_PEAK_FIT:  // lap number, centroid fit quality, refinement offset (micros), method
+            {
+                uint8_t lap, fitQuality, refineMethod;
+                int16_t refineMicros;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    struct LastPass &lastPass = cmdRssiNodePtr->getLastPass();
+                    lap = lastPass.lap;
+                    fitQuality = lastPass.fitQuality;
+                    refineMicros = lastPass.refineMicros;
+                    refineMethod = lastPass.refineMethod;
+                }
+                buffer.write8(lap);
+                buffer.write8(fitQuality);
+                buffer.write16((uint16_t)refineMicros);
+                buffer.write8(refineMethod);
+            }
+            break;
+
+        case READ_PROVISIONAL_PASS:  // lap number, status, revision, peak RSSI, ms since pass
+            {
+                uint8_t lap, status, revision;
+                rssi_t rssiPeak;
+                utime_t timestamp;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    struct ProvisionalPass &provisionalPass = cmdRssiNodePtr->getProvisionalPass();
+                    lap = provisionalPass.lap;
+                    status = provisionalPass.status;
+                    revision = provisionalPass.revision;
+                    rssiPeak = provisionalPass.rssiPeak;
+                    timestamp = provisionalPass.timestamp;
+                }
+                const utime_t sinceMs = (micros() - timestamp) / 1000;
+                buffer.write8(lap);
+                buffer.write8(status);
+                buffer.write8(revision);
+                ioBufferWriteRssi(buffer, rssiPeak);
+                buffer.write16((sinceMs < 0xFFFF) ? (uint16_t)sinceMs : 0xFFFF);
+            }
+            break;
+
+#if CALIBRATION_FLAG
+        case READ_CALIBRATION:  // status, samples captured, RSSI percentiles, fly-by count,
+                                //  suggested EnterAt and ExitAt
+            {
+                RssiCalibration<CALIBRATION_BIN_SHIFT> &calibration = cmdRssiNodePtr->getCalibration();
+                const CalibrationResult &result = calibration.getResult();
+                buffer.write8(calibration.getStatus());
+                buffer.write32(calibration.getSampleCount());
+                ioBufferWriteRssi(buffer, result.noiseP10);
+                ioBufferWriteRssi(buffer, result.noiseP50);
+                ioBufferWriteRssi(buffer, result.noiseFloor);
+                ioBufferWriteRssi(buffer, result.peakP25);
+                ioBufferWriteRssi(buffer, result.peakP50);
+                ioBufferWriteRssi(buffer, result.peakMax);
+                buffer.write16(result.passCount);
+                ioBufferWriteRssi(buffer, result.enterAtLevel);
+                ioBufferWriteRssi(buffer, result.exitAtLevel);
+            }
+            break;
+#endif
+
+        case READ_NOISE_FLOOR:  // noise floor (zero until estimated), blocks in estimate, max drift,
+                                //  EnterAt and ExitAt in use
+            {
+                NoiseFloorTracker<NOISE_FLOOR_BLOCKS> &noiseFloor = cmdRssiNodePtr->getNoiseFloor();
+                ioBufferWriteRssi(buffer, noiseFloor.isValid() ? noiseFloor.getFloor() : 0);
+                buffer.write8(noiseFloor.getBlockCount());
+                ioBufferWriteRssi(buffer, cmdRssiNodePtr->getThresholdFloatMax());
+                ioBufferWriteRssi(buffer, cmdRssiNodePtr->getState().enterAtEffective);
+                ioBufferWriteRssi(buffer, cmdRssiNodePtr->getState().exitAtEffective);
+            }
+            break;
+
+#if RSSI_WINDOWS_FLAG
+        case READ_RSSI_WINDOWS:  // window count, then length (seconds), max and min RSSI for each window
+            buffer.write8(RSSI_WINDOW_COUNT);
+            for (uint8_t i = 0; i < RSSI_WINDOW_COUNT; ++i)
+            {
+                SlidingMinMax<RSSI_WINDOW_BLOCKS> &window = cmdRssiNodePtr->getRssiWindow(i);
+                buffer.write8(RssiNode::rssiWindowSecs[i]);
+                ioBufferWriteRssi(buffer, window.getMax());
+                ioBufferWriteRssi(buffer, window.getMin());
+            }
+            break;
+#endif
+
+#if RSSI_PYRAMID_FLAG
+        case READ_RSSI_PYRAMID:  // tier, entries in tier, start offset, entries returned, entry length (ms),
+                                 //  ms since newest entry, then max, min and mean RSSI for each entry
+                                 //  (newest first, zero-filled to RSSI_PYRAMID_READ_ENTRIES)
+            {
+                RssiPyramid<RSSI_PYRAMID_TIERS, RSSI_PYRAMID_SIZE, RSSI_PYRAMID_FACTOR> &pyramid =
+                        cmdRssiNodePtr->getRssiPyramid();
+                const uint8_t tier = pyramidQuery.tier;
+                const uint8_t count = pyramid.getCount(tier);
+                const uint8_t offset = pyramidQuery.offset;
+                uint8_t num = (offset < count) ? (count - offset) : 0;
+                if (num > RSSI_PYRAMID_READ_ENTRIES)
+                    num = RSSI_PYRAMID_READ_ENTRIES;
+                buffer.write8(tier);
+                buffer.write8(count);
+                buffer.write8(offset);
+                buffer.write8(num);
+                buffer.write16((uint16_t)((uint32_t)pyramid.getScale(tier) * RSSI_PYRAMID_ENTRY_MICROS / 1000));
+                const utime_t sinceMicros = micros() - pyramid.getLastMicros(tier);
+                buffer.write16((count > 0 && sinceMicros < 0xFFFFUL * 1000) ? (uint16_t)(sinceMicros / 1000) : 0xFFFF);
+                for (uint8_t i = 0; i < RSSI_PYRAMID_READ_ENTRIES; ++i)
+                {
+                    if (i < num)
+                    {
+                        const PyramidEntry &e = pyramid.getEntry(tier, offset + i);
+                        ioBufferWriteRssi(buffer, e.maxRssi);
+                        ioBufferWriteRssi(buffer, e.minRssi);
+                        ioBufferWriteRssi(buffer, e.meanRssi);
+                    }
+                    else
+                    {
+                        ioBufferWriteRssi(buffer, 0);
+                        ioBufferWriteRssi(buffer, 0);
+                        ioBufferWriteRssi(buffer, 0);
+                    }
+                }
+            }
+            break;
+#endif
+
+#if RSSI_TRACE_FLAG
+        case READ_RSSI_TRACE:  // sequence number of first sample, samples in packet, encoded length,
+                               //  samples still queued, TRACE_FLAG_... value, then encoded samples
+                               //  (zero-filled to RSSI_TRACE_PACKET_SIZE)
+            {
+                RssiTrace<RSSI_TRACE_SIZE> &trace = cmdRssiNodePtr->getRssiTrace();
+                uint8_t data[RSSI_TRACE_PACKET_SIZE - RSSI_TRACE_HEADER_SIZE];
+                uint8_t flags = (cmdRssiNodePtr->getTraceMode() == RSSI_TRACE_RAW) ? TRACE_FLAG_RAW : 0;
+                uint16_t seq;
+                uint8_t count, len;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    if (trace.takeOverflow())
+                        flags |= TRACE_FLAG_OVERFLOW;
+                    seq = trace.getSeq();
+                    len = trace.encode(data, sizeof(data), count);
+                }
+                buffer.write16(seq);
+                buffer.write8(count);
+                buffer.write8(len);
+                buffer.write16(trace.getCount());
+                buffer.write8(flags);
+                for (uint8_t i = 0; i < sizeof(data); ++i)
+                    buffer.write8((i < len) ? data[i] : 0);
+            }
+            break;
+#endif
+
+#if PASS_ENVELOPE_FLAG
+        case READ_PASS_ENVELOPE:  // lap number, points in envelope (zero if not kept), ms per point,
+                                  //  start of envelope relative to lap time (ms), start point,
+                                  //  then max RSSI for each point (zero-filled to PASS_ENVELOPE_READ_POINTS)
+            {
+                const PassEnvelope<PASS_ENVELOPE_POINTS> *envelope =
+                        cmdRssiNodePtr->getPassEnvelopes().find(envelopeQuery.lap);
+                const uint8_t count = envelope ? envelope->pointCount : 0;
+                const uint8_t offset = envelopeQuery.offset;
+                buffer.write8(envelopeQuery.lap);
+                buffer.write8(count);
+                buffer.write16(envelope ? envelope->pointMs : 0);
+                buffer.write16(envelope ? (uint16_t)envelope->startOffsetMs : 0);
+                buffer.write8(offset);
+                for (uint8_t i = 0; i < PASS_ENVELOPE_READ_POINTS; ++i)
+                {
+                    const uint16_t idx = (uint16_t)offset + i;
+                    ioBufferWriteRssi(buffer, (idx < count) ? envelope->points[idx] : 0);
+                }
+            }
+            break;
+#endif
+
+#if MATCH_DETECTOR_FLAG
+        case READ_CROSSING_DETECTOR:  // DETECTOR_... value, DETECTOR_FLAG_... value, template points,
+                                      //  passes learned, correlation (percent) for newest window,
+                                      //  min correlation (percent), min rise, start point, then
+                                      //  template values (zero-filled to DETECTOR_TEMPLATE_READ_POINTS)
+            {
+                MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> &matchedDetector =
+                        cmdRssiNodePtr->getMatchedDetector();
+                buffer.write8(cmdRssiNodePtr->getDetectorEngine());
+                buffer.write8(cmdRssiNodePtr->getDetectorLearnFlag() ? DETECTOR_FLAG_LEARN : 0);
+                buffer.write8(MATCH_DETECTOR_TAPS);
+                buffer.write8(matchedDetector.getLearnCount());
+                buffer.write8((uint8_t)(((uint16_t)matchedDetector.getScore() * 100 + 128) >> 8));
+                buffer.write8((uint8_t)(((uint16_t)matchedDetector.getMinCorr() * 100 + 128) >> 8));
+                ioBufferWriteRssi(buffer, matchedDetector.getMinRise());
+                buffer.write8(detectorTemplateOffset);
+                for (uint8_t i = 0; i < DETECTOR_TEMPLATE_READ_POINTS; ++i)
+                    buffer.write8((detectorTemplateOffset + i < MATCH_DETECTOR_TAPS) ?
+                            matchedDetector.getTemplatePoint(detectorTemplateOffset + i) : 0);
+            }
+            break;
+#endif
+
+#if HEAT_HISTORY_FLAG
+        case READ_RECOMPUTED_LAPS:  // EnterAt, ExitAt, passes found (max HEAT_HISTORY_RESULT_PASSES), start pass,
+                                    //  RECOMPUTE_FLAG_..., ms since start of retained history, then ms since
+                                    //  pass and peak RSSI for each pass (zero-filled to HEAT_HISTORY_READ_PASSES)
+            {
+                HeatHistory<HEAT_HISTORY_BYTES> &heatHistory = cmdRssiNodePtr->getHeatHistory();
+                const uint8_t total = (recomputeQuery.nodePtr == cmdRssiNodePtr) ? recomputeQuery.passCount : 0;
+                const utime_t nowMicros = micros();
+                ioBufferWriteRssi(buffer, recomputeQuery.enterAt);
+                ioBufferWriteRssi(buffer, recomputeQuery.exitAt);
+                buffer.write8(total);
+                buffer.write8(recomputeQuery.offset);
+                buffer.write8(heatHistory.isTruncated() ? RECOMPUTE_FLAG_TRUNCATED : 0);
+                buffer.write32(heatHistory.isStarted() ?
+                        (nowMicros - heatHistory.getStartMicros()) / 1000 : 0);
+                for (uint8_t i = 0; i < HEAT_HISTORY_READ_PASSES; ++i)
+                {
+                    const uint16_t idx = (uint16_t)recomputeQuery.offset + i;
+                    const bool validFlag = idx < total;
+                    buffer.write32(validFlag ? (nowMicros - recomputeQuery.passes[idx].timestamp) / 1000 : 0);
+                    ioBufferWriteRssi(buffer, validFlag ? recomputeQuery.passes[idx].rssiPeak : 0);
+                }
+            }
+            break;
+#endif
+
+        case READ_SAMPLE_RATE:  // node ADC readings per second (zero if inactive), readings per sample,
+                                //  active nodes, burst flag
+            {
+                const uint8_t slot = cmdRssiNodePtr->getNodeIndex();
+                uint16_t rateHz;
+                uint8_t oversampleCount, activeCount;
+                bool burstFlag;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+                {
+                    rateHz = RssiNode::sampleScheduler.getSlotRateHz(slot);
+                    oversampleCount = RssiNode::sampleScheduler.getSlotOversample(slot);
+                    activeCount = RssiNode::sampleScheduler.getActiveCount();
+                    burstFlag = RssiNode::sampleScheduler.isSlotBurst(slot);
+                }
+                buffer.write16(rateHz);
+                buffer.write8(oversampleCount);
+                buffer.write8(activeCount);
+                buffer.write8(burstFlag ? 1 : 0);
+            }
+            break;
+
+        case READ_TASK_STATS:  // task count, then ID, CPU share (1/1000) and max run time for each task
+            {
+                utime_t nowMicros = micros();
+                uint8_t count = housekeepingTasks.getTaskCount();
+                buffer.write8(count);
+                for (uint8_t i = 0; i < HOUSEKEEPING_TASK_MAX; ++i)
+                {
+                    if (i < count)
+                    {
+                        buffer.write8(housekeepingTasks.getTaskId(i));
+                        buffer.write16(housekeepingTasks.getSharePermille(i, nowMicros));
+                        buffer.write16(housekeepingTasks.getStats(i).maxMicros);
+                    }
+                    else
+                    {
+                        buffer.write8(TASK_ID_NONE);
+                        buffer.write16(0);
+                        buffer.write16(0);
+                    }
+                }
+                housekeepingTasks.clearStats(nowMicros);  // next read covers time since this one
+            }
+            break;
+
         case READ_REVISION_CODE:  // reply with NODE_API_LEVEL and verification value
-            buffer.write16((0x25 << 8) + NODE_API_LEVEL);
+            buffer.write16(NODE_REVISION_CODE);
             break;
 
         case READ_NODE_RSSI_PEAK:
@@ -288,6 +945,12 @@ void Message::handleReadCommand(bool serialFlag)
             buffer.writeTextBlock(firmwareProcTypeString);
             break;
 
+#if NODE_DESCRIPTOR_FLAG
+        case READ_NODE_DESCRIPTOR:
+            handleReadNodeDescriptor();
+            break;
+#endif
+
         default:  // If an invalid command is sent, write nothing back, master must react
             LOG_ERROR("Invalid read command: ", command, HEX);
             actFlag = false;  // not valid activity
@@ -309,54 +972,189 @@ void Message::handleReadCommand(bool serialFlag)
     command = 0;  // Clear previous command
 }
 
-void Message::handleReadLapPassStats(mtime_t timeNowVal)
+// Last values sent via lap-stats reads, per node; READ_LAP_STATS_DELTA only
+//  sends fields that differ from these
+struct LapStatsReport
 {
-    buffer.write8(cmdRssiNodePtr->getLastPass().lap);
-    buffer.write16(uint16_t(timeNowVal - cmdRssiNodePtr->getLastPass().timestamp));  // ms since lap
-    ioBufferWriteRssi(buffer, cmdRssiNodePtr->getState().rssi);
-    ioBufferWriteRssi(buffer, cmdRssiNodePtr->getState().nodeRssiPeak);
-    ioBufferWriteRssi(buffer, cmdRssiNodePtr->getLastPass().rssiPeak);  // RSSI peak for last lap pass
-    buffer.write16(uint16_t(cmdRssiNodePtr->getState().loopTimeMicros));
+    uint8_t generation = 0;  // incremented for each READ_LAP_STATS_DELTA response
+    uint8_t lap = 0;
+    rssi_t rssi = 0;
+    rssi_t nodeRssiPeak = 0;
+    rssi_t passRssiPeak = 0;
+    rssi_t passRssiNadir = MAX_RSSI;
+    rssi_t nodeRssiNadir = MAX_RSSI;
+    uint8_t flags = 0;
+    uint16_t loopTime = 0;
+};
+
+static LapStatsReport lapStatsReportArray[MULTI_RHNODE_MAX];
+
+// Returns true if next historic extremum to be sent is a peak
+static bool isNextExtremumPeak(RssiNode *rssiNodePtr)
+{
+    return !rssiNodePtr->getHistory().peakSend->isEmpty() &&
+             (rssiNodePtr->getHistory().nadirSend->isEmpty() ||
+               (rssiNodePtr->getHistory().peakSend->first().firstTime <
+                rssiNodePtr->getHistory().nadirSend->first().firstTime));
 }
 
-void Message::handleReadLapExtremums(mtime_t timeNowVal)
+// Returns LAPSTATS_FLAG_... value for current node
+static uint8_t getLapStatsFlags(RssiNode *rssiNodePtr)
 {
     // set flag if 'crossing' in progress
-    uint8_t flags = cmdRssiNodePtr->getState().crossing ?
+    uint8_t flags = rssiNodePtr->getState().crossing ?
             (uint8_t)LAPSTATS_FLAG_CROSSING : (uint8_t)0;
-    if (!cmdRssiNodePtr->getHistory().peakSend->isEmpty() &&
-          (cmdRssiNodePtr->getHistory().nadirSend->isEmpty() ||
-            (cmdRssiNodePtr->getHistory().peakSend->first().firstTime <
-             cmdRssiNodePtr->getHistory().nadirSend->first().firstTime)))
+    if (isNextExtremumPeak(rssiNodePtr))
     {
         flags |= LAPSTATS_FLAG_PEAK;
     }
-    buffer.write8(flags);
-    ioBufferWriteRssi(buffer, cmdRssiNodePtr->getLastPass().rssiNadir);  // lowest rssi since end of last pass
-    ioBufferWriteRssi(buffer, cmdRssiNodePtr->getState().nodeRssiNadir);
-
-    if (!cmdRssiNodePtr->getHistory().peakSend->isEmpty() &&
-          (cmdRssiNodePtr->getHistory().nadirSend->isEmpty() ||
-            (cmdRssiNodePtr->getHistory().peakSend->first().firstTime <
-             cmdRssiNodePtr->getHistory().nadirSend->first().firstTime)))
+    return flags;
+}
+
+// Writes (and removes) next historic extremum to be sent, or zeros if none pending
+static void ioBufferWriteNextExtremum(Buffer& buf, RssiNode *rssiNodePtr, utime_t timeNowMicros)
+{
+    if (isNextExtremumPeak(rssiNodePtr))
     {
         // send peak
-        ioBufferWriteExtremum(buffer, cmdRssiNodePtr->getHistory().peakSend->first(), timeNowVal);
-        cmdRssiNodePtr->getHistory().peakSend->removeFirst();
+        ioBufferWriteExtremum(buf, rssiNodePtr->getHistory().peakSend->first(), timeNowMicros);
+        rssiNodePtr->getHistory().peakSend->removeFirst();
     }
-    else if (!cmdRssiNodePtr->getHistory().nadirSend->isEmpty() &&
-              (cmdRssiNodePtr->getHistory().peakSend->isEmpty() ||
-                (cmdRssiNodePtr->getHistory().nadirSend->first().firstTime <
-                 cmdRssiNodePtr->getHistory().peakSend->first().firstTime)))
+    else if (!rssiNodePtr->getHistory().nadirSend->isEmpty())
     {
         // send nadir
-        ioBufferWriteExtremum(buffer, cmdRssiNodePtr->getHistory().nadirSend->first(), timeNowVal);
-        cmdRssiNodePtr->getHistory().nadirSend->removeFirst();
+        ioBufferWriteExtremum(buf, rssiNodePtr->getHistory().nadirSend->first(), timeNowMicros);
+        rssiNodePtr->getHistory().nadirSend->removeFirst();
     }
     else
     {
-        ioBufferWriteRssi(buffer, 0);
-        buffer.write16(0);
-        buffer.write16(0);
+        ioBufferWriteRssi(buf, 0);
+        buf.write16(0);
+        buf.write16(0);
     }
 }
+
+void Message::handleReadLapPassStats(utime_t timeNowMicros)
+{
+    LapStatsReport &report = lapStatsReportArray[cmdRssiNodePtr->getNodeIndex()];
+    report.lap = cmdRssiNodePtr->getLastPass().lap;
+    report.rssi = cmdRssiNodePtr->getState().rssi;
+    report.nodeRssiPeak = cmdRssiNodePtr->getState().nodeRssiPeak;
+    report.passRssiPeak = cmdRssiNodePtr->getLastPass().rssiPeak;
+    report.loopTime = uint16_t(cmdRssiNodePtr->getState().loopTimeMicros);
+
+    buffer.write8(report.lap);
+    buffer.write16(uint16_t((timeNowMicros - cmdRssiNodePtr->getLastPass().timestamp) / 1000));  // ms since lap
+    ioBufferWriteRssi(buffer, report.rssi);
+    ioBufferWriteRssi(buffer, report.nodeRssiPeak);
+    ioBufferWriteRssi(buffer, report.passRssiPeak);  // RSSI peak for last lap pass
+    buffer.write16(report.loopTime);
+}
+
+void Message::handleReadLapExtremums(utime_t timeNowMicros)
+{
+    LapStatsReport &report = lapStatsReportArray[cmdRssiNodePtr->getNodeIndex()];
+    report.flags = getLapStatsFlags(cmdRssiNodePtr);
+    report.passRssiNadir = cmdRssiNodePtr->getLastPass().rssiNadir;
+    report.nodeRssiNadir = cmdRssiNodePtr->getState().nodeRssiNadir;
+
+    buffer.write8(report.flags);
+    ioBufferWriteRssi(buffer, report.passRssiNadir);  // lowest rssi since end of last pass
+    ioBufferWriteRssi(buffer, report.nodeRssiNadir);
+    ioBufferWriteNextExtremum(buffer, cmdRssiNodePtr, timeNowMicros);
+}
+
+// Writes generation counter and LAPDELTA_... mask, followed by only those
+//  lap-stats fields that have changed since the previous lap-stats read
+void Message::handleReadLapStatsDelta(utime_t timeNowMicros)
+{
+    LapStatsReport &report = lapStatsReportArray[cmdRssiNodePtr->getNodeIndex()];
+    struct State &state = cmdRssiNodePtr->getState();
+    struct LastPass &lastPass = cmdRssiNodePtr->getLastPass();
+    uint8_t flags = getLapStatsFlags(cmdRssiNodePtr);
+    uint16_t loopTime = uint16_t(state.loopTimeMicros);
+    uint8_t mask = 0;
+
+    if (lastPass.lap != report.lap)
+        mask |= LAPDELTA_LAP;
+    if (state.rssi >= report.rssi + LAPDELTA_RSSI_STEP || state.rssi + LAPDELTA_RSSI_STEP <= report.rssi)
+        mask |= LAPDELTA_RSSI;
+    if (state.nodeRssiPeak != report.nodeRssiPeak || lastPass.rssiPeak != report.passRssiPeak)
+        mask |= LAPDELTA_PEAKS;
+    if (lastPass.rssiNadir != report.passRssiNadir || state.nodeRssiNadir != report.nodeRssiNadir)
+        mask |= LAPDELTA_NADIRS;
+    if (!cmdRssiNodePtr->getHistory().peakSend->isEmpty() ||
+            !cmdRssiNodePtr->getHistory().nadirSend->isEmpty())
+        mask |= (LAPDELTA_EXTREMUM | LAPDELTA_FLAGS);  // flags say if extremum is peak or nadir
+    if ((flags & LAPSTATS_FLAG_CROSSING) != (report.flags & LAPSTATS_FLAG_CROSSING))
+        mask |= LAPDELTA_FLAGS;
+    if ((loopTime > report.loopTime ? loopTime - report.loopTime : report.loopTime - loopTime) >
+            (report.loopTime >> LAPDELTA_LOOPTIME_SHIFT))
+        mask |= LAPDELTA_LOOPTIME;
+
+    buffer.write8(++report.generation);
+    buffer.write8(mask);
+    if (mask & LAPDELTA_LAP)
+    {
+        report.lap = lastPass.lap;
+        buffer.write8(report.lap);
+        buffer.write16(uint16_t((timeNowMicros - lastPass.timestamp) / 1000));  // ms since lap
+    }
+    if (mask & LAPDELTA_RSSI)
+    {
+        report.rssi = state.rssi;
+        ioBufferWriteRssi(buffer, report.rssi);
+    }
+    if (mask & LAPDELTA_PEAKS)
+    {
+        report.nodeRssiPeak = state.nodeRssiPeak;
+        report.passRssiPeak = lastPass.rssiPeak;
+        ioBufferWriteRssi(buffer, report.nodeRssiPeak);
+        ioBufferWriteRssi(buffer, report.passRssiPeak);
+    }
+    if (mask & LAPDELTA_NADIRS)
+    {
+        report.passRssiNadir = lastPass.rssiNadir;
+        report.nodeRssiNadir = state.nodeRssiNadir;
+        ioBufferWriteRssi(buffer, report.passRssiNadir);
+        ioBufferWriteRssi(buffer, report.nodeRssiNadir);
+    }
+    if (mask & LAPDELTA_FLAGS)
+    {
+        report.flags = flags;
+        buffer.write8(flags);
+    }
+    if (mask & LAPDELTA_EXTREMUM)
+    {
+        ioBufferWriteNextExtremum(buffer, cmdRssiNodePtr, timeNowMicros);
+    }
+    if (mask & LAPDELTA_LOOPTIME)
+    {
+        report.loopTime = loopTime;
+        buffer.write16(loopTime);
+    }
+}
+
+#if NODE_DESCRIPTOR_FLAG
+// Writes everything the server needs at startup into a single response
+void Message::handleReadNodeDescriptor()
+{
+    buffer.write16(NODE_REVISION_CODE);
+    buffer.write16(RHFEAT_FLAGS_VALUE);
+    buffer.write8(RssiNode::multiRssiNodeCount);
+    buffer.writeTextBlock(firmwareVersionString);
+    buffer.writeTextBlock(firmwareProcTypeString);
+    buffer.writeTextBlock(firmwareBuildDateString);
+    buffer.writeTextBlock(firmwareBuildTimeString);
+    for (uint8_t nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
+    {
+        RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[nIdx]);
+        buffer.write8(rssiNodePtr->getSlotIndex());
+        buffer.write16(rssiNodePtr->getVtxFreq());
+        ioBufferWriteRssi(buffer, rssiNodePtr->getEnterAtLevel());
+        ioBufferWriteRssi(buffer, rssiNodePtr->getExitAtLevel());
+        ioBufferWriteRssi(buffer, rssiNodePtr->getState().nodeRssiPeak);
+        ioBufferWriteRssi(buffer, rssiNodePtr->getState().nodeRssiNadir);
+    }
+}
+#endif
@@ -2,9 +2,14 @@
 #define commands_h
 
 #include "io.h"
+#include "util/time-sync.h"
+#include "util/task-scheduler.h"
 
 // API level for node; increment when commands are modified
-#define NODE_API_LEVEL 36
+#define NODE_API_LEVEL 60
+
+// value returned by READ_REVISION_CODE command (verification value in upper byte)
+#define NODE_REVISION_CODE ((0x25 << 8) + NODE_API_LEVEL)
 
 class Message
 {
@@ -15,8 +20,12 @@ public:
     byte getPayloadSize();
     void handleWriteCommand(bool serialFlag);
     void handleReadCommand(bool serialFlag);
-    void handleReadLapPassStats(mtime_t timeNowVal);
-    void handleReadLapExtremums(mtime_t timeNowVal);
+    void handleReadLapPassStats(utime_t timeNowMicros);
+    void handleReadLapExtremums(utime_t timeNowMicros);
+    void handleReadLapStatsDelta(utime_t timeNowMicros);
+#if NODE_DESCRIPTOR_FLAG
+    void handleReadNodeDescriptor();
+#endif
 };
 
 #define MIN_FREQ 100
@@ -28,6 +37,7 @@ public:
 #define READ_LAP_STATS 0x05
 #define READ_LAP_PASS_STATS 0x0D
 #define READ_LAP_EXTREMUMS 0x0E
+#define READ_LAP_STATS_DELTA 0x0F  // read lap-stats fields changed since previous read
 #define READ_RHFEAT_FLAGS 0x11     // read feature flags value
 #define READ_REVISION_CODE 0x22    // read NODE_API_LEVEL and verification value
 #define READ_NODE_RSSI_PEAK 0x23   // read 'state.nodeRssiPeak' value
@@ -35,6 +45,8 @@ public:
 #define READ_ENTER_AT_LEVEL 0x31
 #define READ_EXIT_AT_LEVEL 0x32
 #define READ_TIME_MILLIS 0x33      // read current 'millis()' value
+#define READ_RECOMPUTED_LAPS 0x34  // read passes found by replaying heat history (see WRITE_RECOMPUTE_LAPS)
+#define READ_CROSSING_DETECTOR 0x35  // read detector engine, limits and matched-filter template points
 #define READ_MULTINODE_COUNT 0x39  // read # of nodes handled by this processor
 #define READ_CURNODE_INDEX 0x3A    // read index of current node for this processor
 #define READ_NODE_SLOTIDX 0x3C     // read node slot index (for multi-node setup)
@@ -42,10 +54,40 @@ public:
 #define READ_FW_BUILDDATE 0x3E     // read firmware build date string
 #define READ_FW_BUILDTIME 0x3F     // read firmware build time string
 #define READ_FW_PROCTYPE 0x40      // read node processor type
+#define READ_NODE_DESCRIPTOR 0x41  // read API level, features, firmware info and settings for all nodes
+#define READ_NODE_SETTINGS 0x42    // read frequency, EnterAt and ExitAt values in one response
+#define READ_TIME_SYNC 0x43        // read response for time-sync exchange (and current estimate)
+#define READ_LAP_SYNC_TIME 0x44    // read last lap timestamp in synchronized server time (with micros)
+#define READ_LAP_EPOCH_OFFSET 0x45  // read last lap time relative to race epoch (ms and micros)
+#define READ_SAMPLE_STATS 0x46     // read sample timing, sample-FIFO, gap and load-shed stats for node
+#define READ_TASK_STATS 0x47       // read CPU share and max run time for main-loop tasks
+#define READ_SAMPLE_RATE 0x48      // read rate at which node is sampled, readings per sample and burst mode
+#define READ_LAP_PEAK_FIT 0x49     // read method, quality and offset of last lap timestamp refinement
+#define READ_PROVISIONAL_PASS 0x4A  // read status and time of pass raised at peak detection (before exit)
+#define READ_CALIBRATION 0x4B      // read RSSI distribution and suggested EnterAt/ExitAt from calibration capture
+#define READ_NOISE_FLOOR 0x4C      // read noise-floor estimate and EnterAt/ExitAt levels in use
+#define READ_RSSI_WINDOWS 0x4D     // read max and min RSSI over recent sliding windows (e.g. 1, 10, 60 s)
+#define READ_RSSI_PYRAMID 0x4E     // read entries of RSSI summary tier selected by WRITE_RSSI_PYRAMID_QUERY
+#define READ_RSSI_TRACE 0x4F       // read next packet of delta/run-length encoded trace samples
+#define READ_PASS_ENVELOPE 0x50    // read RSSI envelope of pass selected by WRITE_PASS_ENVELOPE_QUERY
 
 #define WRITE_FREQUENCY 0x51
+#define WRITE_BCAST_FREQUENCY 0x52   // broadcast table of frequencies (I2C general call)
+#define WRITE_TIME_SYNC 0x5A       // start time-sync exchange (server send time, previous receive time)
+#define WRITE_RACE_EPOCH 0x5B      // race start time (server ms), server send time and epoch ID
+#define WRITE_PROVISIONAL_DROP 0x5C  // RSSI drop below pass peak that raises provisional pass (0 = off)
+#define WRITE_CALIBRATE 0x5D       // start calibration capture (seconds, CALIBRATE_FLAG_... values)
+#define WRITE_THRESHOLD_FLOAT 0x5E  // max drift of EnterAt/ExitAt with noise floor (0 = fixed levels)
+#define WRITE_RSSI_PYRAMID_QUERY 0x5F  // select tier and start offset for READ_RSSI_PYRAMID
+#define WRITE_RSSI_TRACE_MODE 0x60  // start or stop trace streaming (RSSI_TRACE_... value)
+#define WRITE_PASS_ENVELOPE_QUERY 0x61  // select lap number and start point for READ_PASS_ENVELOPE
+#define WRITE_RECOMPUTE_LAPS 0x62  // set EnterAt/ExitAt and start pass for READ_RECOMPUTED_LAPS
+#define WRITE_HISTORY_PROMINENCE 0x63  // RSSI reversal that declares a history peak/nadir (1 = every reversal)
+#define WRITE_CROSSING_DETECTOR 0x64  // select crossing detector (DETECTOR_... value), flags and limits
+#define WRITE_DETECTOR_TEMPLATE 0x65  // write matched-filter template points and start point for READ_CROSSING_DETECTOR
 #define WRITE_ENTER_AT_LEVEL 0x71
 #define WRITE_EXIT_AT_LEVEL 0x72
+#define WRITE_BCAST_ENTER_EXIT 0x73  // broadcast table of EnterAt/ExitAt values (I2C general call)
 #define WRITE_CURNODE_INDEX 0x7A   // write index of current node for this processor
 
 #define SEND_STATUS_MESSAGE 0x75   // send status message from server to node
@@ -53,6 +95,12 @@ public:
 #define RESET_PAIRED_NODE 0x79     // command to reset node for ISP
 #define JUMP_TO_BOOTLOADER 0x7E    // jump to bootloader for flash update
 
+// payload for WRITE_BCAST_... commands is a mask byte (bit set for each entry present)
+//  followed by a table entry for each node; I2C nodes use entry (i2cAddress-8)/2 and
+//  multi-node processors use the entry matching each node index
+#define BCAST_TABLE_SIZE 8
+#define BCAST_PAYLOAD_SIZE (1 + BCAST_TABLE_SIZE * 2)
+
 #define FREQ_SET        0x01
 #define FREQ_CHANGED    0x02
 #define ENTERAT_CHANGED 0x04
@@ -64,6 +112,45 @@ public:
 #define LAPSTATS_FLAG_CROSSING 0x01  // crossing is in progress
 #define LAPSTATS_FLAG_PEAK 0x02      // reported extremum is peak
 
+#define CALIBRATE_FLAG_APPLY 0x01    // set suggested EnterAt/ExitAt when calibration capture finishes
+
+#define RSSI_TRACE_HEADER_SIZE 7     // READ_RSSI_TRACE header (sequence, counts, flags) before encoded data
+#define TRACE_FLAG_OVERFLOW 0x01     // samples were dropped (queue full) since previous packet
+#define TRACE_FLAG_RAW 0x02          // samples are raw RSSI (else filtered)
+
+#define RECOMPUTE_FLAG_TRUNCATED 0x01  // oldest heat history was dropped (buffer full)
+
+#define DETECTOR_FLAG_LEARN 0x01     // blend shape of detected passes into matched-filter template
+#define DETECTOR_TEMPLATE_WRITE_POINTS 8   // points in WRITE_DETECTOR_TEMPLATE payload
+#define DETECTOR_TEMPLATE_READ_POINTS 16   // points in READ_CROSSING_DETECTOR response
+#define DETECTOR_TEMPLATE_DEFAULT 0xFF     // WRITE_DETECTOR_TEMPLATE start point that restores default template
+
+// bits in READ_LAP_STATS_DELTA mask (fields follow in this order when present)
+#define LAPDELTA_LAP      0x01  // lap number (1 byte) and ms since lap (2 bytes)
+#define LAPDELTA_RSSI     0x02  // current RSSI
+#define LAPDELTA_PEAKS    0x04  // node peak and last-pass peak RSSI
+#define LAPDELTA_NADIRS   0x08  // last-pass nadir and node nadir RSSI
+#define LAPDELTA_FLAGS    0x10  // LAPSTATS_FLAG_... value
+#define LAPDELTA_EXTREMUM 0x20  // pending extremum (RSSI, ms since first time, duration)
+#define LAPDELTA_LOOPTIME 0x40  // loop time (micros)
+
+#define LAPDELTA_RSSI_STEP 2       // RSSI change needed before it is sent again
+#define LAPDELTA_LOOPTIME_SHIFT 3  // loop-time change (1/8 of value) needed before it is sent again
+
+#define RACE_EPOCH_ID_NONE 0            // epoch ID reported when no race epoch has been set
+#define RACE_EPOCH_OFFSET_NONE 0x7FFFFFFF  // lap offset reported when no race epoch has been set
+
+// IDs for main-loop tasks (reported by READ_TASK_STATS)
+#define TASK_ID_SAMPLING 0        // processing of queued RSSI samples
+#define TASK_ID_SETTINGS 1        // applying settings changed via commands
+#define TASK_ID_COMMS_MONITOR 2   // I2C communications monitor
+#define TASK_ID_STATUS_LED 3      // status LED and buzzer
+#define TASK_ID_SHUTDOWN 4        // RPi signal and shutdown-button actions
+#define TASK_ID_AUXLED_BLINK 5    // AUX LED blink while shutdown button pressed
+#define TASK_ID_NONE 0xFF         // unused entry in READ_TASK_STATS response
+
+#define HOUSEKEEPING_TASK_MAX 6   // entries in READ_TASK_STATS response
+
 // upper-byte values for SEND_STATUS_MESSAGE payload (lower byte is data)
 #define STATMSG_SDBUTTON_STATE 0x01    // shutdown button state (1=pressed, 0=released)
 #define STATMSG_SHUTDOWN_STARTED 0x02  // system shutdown started
@@ -71,6 +158,9 @@ public:
 
 RssiNode *getCmdRssiNodePtr();
 
+extern TimeSync timeSync;
+extern TaskScheduler<HOUSEKEEPING_TASK_MAX> housekeepingTasks;
+
 extern uint8_t settingChangedFlags;
 
 // dummy macro
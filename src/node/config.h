@@ -25,24 +25,183 @@
 #define RHFEAT_STM32_MODE ((uint16_t)0x0004)      // STM 32-bit processor running multiple nodes
 #define RHFEAT_JUMPTO_BOOTLDR ((uint16_t)0x0008)  // JUMP_TO_BOOTLOADER command supported
 #define RHFEAT_IAP_FIRMWARE ((uint16_t)0x0010)    // in-application programming of firmware supported
+#define RHFEAT_CALIBRATION ((uint16_t)0x0020)     // WRITE_CALIBRATE capture supported
+#define RHFEAT_RSSI_WINDOWS ((uint16_t)0x0040)    // READ_RSSI_WINDOWS supported
+#define RHFEAT_RSSI_PYRAMID ((uint16_t)0x0080)    // READ_RSSI_PYRAMID supported
+#define RHFEAT_RSSI_TRACE ((uint16_t)0x0100)      // RSSI trace streaming supported
+#define RHFEAT_PASS_ENVELOPE ((uint16_t)0x0200)   // READ_PASS_ENVELOPE supported
+#define RHFEAT_HEAT_HISTORY ((uint16_t)0x0400)    // WRITE_RECOMPUTE_LAPS supported
+#define RHFEAT_MATCH_DETECTOR ((uint16_t)0x0800)  // matched-filter crossing detector supported
 #define RHFEAT_NONE ((uint16_t)0)
 
 #if STM32_MODE_FLAG
 // value returned by READ_RHFEAT_FLAGS command
-#define RHFEAT_FLAGS_VALUE (RHFEAT_STM32_MODE | RHFEAT_JUMPTO_BOOTLDR | RHFEAT_IAP_FIRMWARE)
+#define RHFEAT_FLAGS_VALUE (RHFEAT_STM32_MODE | RHFEAT_JUMPTO_BOOTLDR | RHFEAT_IAP_FIRMWARE | \
+                            RHFEAT_NODE_FEATURES)
 
 #define SERIAL_BAUD_RATE 921600
-#define MULTI_RHNODE_MAX 8
 #define STM32_SERIALUSB_FLAG 0  // 1 to use BPill USB port for serial link
 
+// Set to 1 if RSSI inputs are fed to the ADC via an external analog multiplexer
+//  (like a CD74HC4067), which is needed for more than 8 nodes
+#ifndef RSSI_MUX_FLAG
+#define RSSI_MUX_FLAG 0
+#endif
+
+// maximum number of nodes (may be set via build flag); storage for node state
+//  is sized by this value, and pin maps below must have at least this many entries
+#ifndef MULTI_RHNODE_MAX
+#if RSSI_MUX_FLAG
+#define MULTI_RHNODE_MAX 16
+#else
+#define MULTI_RHNODE_MAX 8
+#endif
+#endif
+
+#define SAMPLE_TIMER_INSTANCE TIM4  // hardware timer that drives sample scheduling
+#define SAMPLE_OVERSAMPLE_MAX 4     // max readings per sample period when nodes are inactive
+#define ADAPTIVE_SAMPLING_FLAG 1    // 1 to use extra readings only for nodes near a crossing
+#define RSSI_PYRAMID_READ_ENTRIES 16  // entries returned by READ_RSSI_PYRAMID
+#define RSSI_TRACE_PACKET_SIZE 64   // READ_RSSI_TRACE response size (header and encoded samples)
+#define PASS_ENVELOPE_READ_POINTS 64  // points returned by READ_PASS_ENVELOPE
+#define HEAT_HISTORY_READ_PASSES 16  // passes returned by READ_RECOMPUTED_LAPS
+#define HEAT_HISTORY_RESULT_PASSES 255  // passes kept from replay for READ_RECOMPUTED_LAPS (max 255)
+
+#ifdef STM32_F4_PROCTYPE
+#define NODE_STATE_RAM_MAX 106496   // bytes of RAM for state of all nodes (of 128 KB; checked at build time)
+#define SAMPLE_FIFO_SIZE 32         // samples queued per node between sampling interrupt and loop
+#define PEAK_REFINE_FLAG 1          // 1 to refine lap timestamp from filtered samples near pass peak
+#define PEAK_WINDOW_SIZE 64         // filtered samples kept for lap timestamp refinement
+#define ZERO_PHASE_REFINE_FLAG 1    // 1 to refine lap timestamp from raw samples after crossing
+#define CALIBRATION_FLAG 1          // 1 for calibration capture (suggested EnterAt/ExitAt)
+#define CALIBRATION_BIN_SHIFT 2     // calibration histogram bins are 2^this RSSI units wide
+#define RSSI_WINDOWS_FLAG 1         // 1 for sliding windows of recent max/min RSSI
+#define RSSI_WINDOW_BLOCKS 20       // blocks in each sliding min/max window (resolution of window)
+#define RSSI_PYRAMID_FLAG 1         // 1 for RSSI summary pyramid
+#define RSSI_TRACE_FLAG 1           // 1 for RSSI trace streaming
+#define RSSI_TRACE_SIZE 256         // samples queued per node for trace streaming
+#define PASS_ENVELOPE_FLAG 1        // 1 to keep RSSI envelopes of recent passes
+#define PASS_ENVELOPE_POINTS 64     // points in each pass envelope (must be even)
+#if MULTI_RHNODE_MAX > 8
+// less RAM per node for more than 8 nodes (heat history is 32 KB over all nodes)
+#define RSSI_PYRAMID_SIZE 60
+#define PASS_ENVELOPE_PASSES 4
+#define HEAT_HISTORY_BYTES (32768 / MULTI_RHNODE_MAX)
+#else
+#define RSSI_PYRAMID_SIZE 120       // entries in each tier of RSSI summary pyramid
+#define PASS_ENVELOPE_PASSES 8      // passes whose RSSI envelopes are kept
+#define HEAT_HISTORY_BYTES 6144     // bytes per node for peaks/nadirs of current heat
+#endif
+#define HEAT_HISTORY_FLAG 1         // 1 to keep heat history for WRITE_RECOMPUTE_LAPS
+#define MATCH_DETECTOR_FLAG 1       // 1 for matched-filter crossing detector
+#define MATCH_DETECTOR_TAPS 32      // template points of matched-filter crossing detector
+#define MATCH_POINT_SAMPLES 8       // samples averaged into each template point (window is 256 samples)
+#else
+// F1 has 20 KB of RAM, which leaves room for 8 nodes with lap timing and
+//  calibration only
+#define NODE_STATE_RAM_MAX 14336    // bytes of RAM for state of all nodes (of 20 KB; checked at build time)
+#define SAMPLE_FIFO_SIZE 16
+#define PEAK_REFINE_FLAG 1
+#define PEAK_WINDOW_SIZE 24
+#define ZERO_PHASE_REFINE_FLAG 0
+#define CALIBRATION_FLAG 1
+#define CALIBRATION_BIN_SHIFT 3
+#define RSSI_WINDOWS_FLAG 0
+#define RSSI_PYRAMID_FLAG 0
+#define RSSI_TRACE_FLAG 0
+#define PASS_ENVELOPE_FLAG 0
+#define HEAT_HISTORY_FLAG 0
+#define MATCH_DETECTOR_FLAG 0
+#endif
+
 #else
 // value returned by READ_RHFEAT_FLAGS command
-#define RHFEAT_FLAGS_VALUE RHFEAT_NONE
+#define RHFEAT_FLAGS_VALUE RHFEAT_NODE_FEATURES
 
 #define SERIAL_BAUD_RATE 115200
 #define MULTI_RHNODE_MAX 1
+#define NODE_STATE_RAM_MAX 1536     // bytes of RAM for node state (of 2 KB; checked at build time)
+#define SAMPLE_FIFO_SIZE 16         // samples queued between sampling interrupt and loop
+#define SAMPLE_OVERSAMPLE_MAX 1
+#define ZERO_PHASE_REFINE_FLAG 0    // not enough RAM for raw-sample window
+#define ADAPTIVE_SAMPLING_FLAG 0
+
+// not enough RAM on the ATmega328P for the features below (node state must leave
+//  room for globals and stack); tests with __TEST_ALL_FEATURES__ build them in
+#ifdef __TEST_ALL_FEATURES__
+#define ARDUINO_EXTRA_FEATURES 1
+#else
+#define ARDUINO_EXTRA_FEATURES 0
+#endif
+#define PEAK_REFINE_FLAG ARDUINO_EXTRA_FEATURES
+#define PEAK_WINDOW_SIZE 24
+#define CALIBRATION_FLAG ARDUINO_EXTRA_FEATURES
+#define CALIBRATION_BIN_SHIFT 3
+#define RSSI_WINDOWS_FLAG ARDUINO_EXTRA_FEATURES
+#define RSSI_WINDOW_BLOCKS 10
+#define RSSI_PYRAMID_FLAG ARDUINO_EXTRA_FEATURES
+#define RSSI_PYRAMID_SIZE 8
+#define RSSI_PYRAMID_READ_ENTRIES 7   // response must fit 32-byte I2C transfer
+#define RSSI_TRACE_FLAG ARDUINO_EXTRA_FEATURES
+#define RSSI_TRACE_SIZE 128
+#define RSSI_TRACE_PACKET_SIZE 31
+#define PASS_ENVELOPE_FLAG ARDUINO_EXTRA_FEATURES
+#define PASS_ENVELOPE_PASSES 2
+#define PASS_ENVELOPE_POINTS 32
+#define PASS_ENVELOPE_READ_POINTS 24
+#define MATCH_DETECTOR_FLAG ARDUINO_EXTRA_FEATURES
+#define MATCH_DETECTOR_TAPS 16
+#define MATCH_POINT_SAMPLES 16
+#define HEAT_HISTORY_FLAG ARDUINO_EXTRA_FEATURES
+#define HEAT_HISTORY_BYTES 1024
+#define HEAT_HISTORY_READ_PASSES 4    // response must fit 32-byte I2C transfer
+#define HEAT_HISTORY_RESULT_PASSES 16
 #endif  // STM32_MODE_FLAG
 
+// features flags for optional node features (included in RHFEAT_FLAGS_VALUE)
+#define RHFEAT_NODE_FEATURES ((CALIBRATION_FLAG ? RHFEAT_CALIBRATION : RHFEAT_NONE) | \
+                              (RSSI_WINDOWS_FLAG ? RHFEAT_RSSI_WINDOWS : RHFEAT_NONE) | \
+                              (RSSI_PYRAMID_FLAG ? RHFEAT_RSSI_PYRAMID : RHFEAT_NONE) | \
+                              (RSSI_TRACE_FLAG ? RHFEAT_RSSI_TRACE : RHFEAT_NONE) | \
+                              (PASS_ENVELOPE_FLAG ? RHFEAT_PASS_ENVELOPE : RHFEAT_NONE) | \
+                              (HEAT_HISTORY_FLAG ? RHFEAT_HEAT_HISTORY : RHFEAT_NONE) | \
+                              (MATCH_DETECTOR_FLAG ? RHFEAT_MATCH_DETECTOR : RHFEAT_NONE))
+
+#define SAMPLE_PERIOD_MICROS 1000  // time between samples for each node
+#define SAMPLE_GAP_FILL_MAX 8      // gaps of up to this many missed samples are interpolated
+#define LOAD_SHED_BACKLOG (SAMPLE_FIFO_SIZE / 2)  // queued samples that indicate overload
+#define LOAD_SHED_HOLD_MS 100      // non-critical tasks are skipped this long after overload
+#define LOAD_SHED_MAX_PRIORITY 2   // tasks with higher priority values are shed while overloaded
+
+#define SAMPLE_BURST_MARGIN 10         // burst sampling starts when RSSI is within this of EnterAt
+#define SAMPLE_BURST_SLOPE 6           // or when RSSI rises by this much over SAMPLE_BURST_SLOPE_SAMPLES
+#define SAMPLE_BURST_SLOPE_SAMPLES 16
+
+#define PEAK_REFINE_SPAN 8             // lap time is centroid of RSSI within this of pass peak
+#define PEAK_REFINE_MIN_QUALITY 25     // refined time used if fit quality is at least this (1-100)
+#define PROVISIONAL_PASS_DROP 10       // provisional pass raised when RSSI falls this far below pass peak
+#define HISTORY_PROMINENCE 1           // RSSI reversal that declares a history peak/nadir (1 = every reversal)
+#define PASS_ENVELOPE_MARGIN 16        // pass envelope capture starts when RSSI is within this of EnterAt
+
+#define NOISE_FLOOR_BLOCKS 16          // block minima kept for noise-floor estimate
+#define NOISE_FLOOR_BLOCK_SAMPLES 500  // samples in each block (window is 8 seconds)
+
+#define RSSI_WINDOW_COUNT 3            // sliding windows for recent RSSI max/min
+#define RSSI_WINDOW_SECS_LIST { 1, 10, 60 }  // length of each window (seconds)
+
+#define RSSI_PYRAMID_TIERS 4           // tiers in RSSI summary pyramid (1 ms, 10 ms, 100 ms, 1 s entries)
+#define RSSI_PYRAMID_FACTOR 10         // entries of a tier combined into one entry of the next tier
+#define RSSI_PYRAMID_ENTRY_MICROS 1000 // time covered by each tier-0 entry
+
+#define HEAT_HISTORY_HYSTERESIS 1      // RSSI reversal that completes a heat-history peak/nadir (replay is exact only at 1)
+
+#define CALIBRATION_MIN_RISE 16        // fly-by peaks must rise this far above noise floor
+#define CALIBRATION_ENTER_PERCENT 70   // suggested EnterAt is this far from noise floor to fly-by peak
+#define CALIBRATION_EXIT_PERCENT 40    // suggested ExitAt is this far from noise floor to fly-by peak
+
+#define ZERO_PHASE_WINDOW_SIZE 256     // raw samples kept for zero-phase refinement
+#define ZERO_PHASE_HALF_WIDTH 64       // raw samples filtered on each side of pass peak
+#define ZERO_PHASE_ALPHA_SHIFT 3       // filter time constant is 2^this samples (each direction)
 
 #if STM32_MODE_FLAG || defined(__TEST__)
 #define ATOMIC_BLOCK(x)
@@ -106,6 +265,10 @@
 #define RX5808_SEL6_PIN PB14
 #define RX5808_SEL7_PIN PB15
 
+#define RX5808_SEL_PIN_MAP { RX5808_SEL0_PIN, RX5808_SEL1_PIN, RX5808_SEL2_PIN, RX5808_SEL3_PIN, \
+                             RX5808_SEL4_PIN, RX5808_SEL5_PIN, RX5808_SEL6_PIN, RX5808_SEL7_PIN \
+                             RX5808_SEL_PIN_MAP_EXT }
+
 #define BUZZER_OUTPUT_PIN PA8
 #define BUZZER_OUT_ONSTATE LOW
 #define BUZZER_OUT_OFFSTATE HIGH
@@ -123,6 +286,8 @@
 #define RSSI_INPUT6_PIN A6
 #define RSSI_INPUT7_PIN A7
 
+#define RX5808_SEL_PIN_MAP_EXT         //no pins for more than 8 nodes
+
 #define VOLTAGE_MONITOR_PIN PB1
 
 // on the S32_BPill PCB this pin is connected to RPi GPIO24, which should be
@@ -143,6 +308,21 @@
 #define RSSI_INPUT6_PIN A5
 #define RSSI_INPUT7_PIN A6
 
+#if RSSI_MUX_FLAG
+// with multiplexer, RSSI inputs are on mux channels 0-15 (via RSSI_INPUT0_PIN)
+//  and the pins used for direct RSSI inputs drive the SEL lines for nodes 9-16
+#define RX5808_SEL_PIN_MAP_EXT , A0, A1, A2, A3, A4, A5, A6, PB2
+
+#ifndef RSSI_MUX_INPUT_PIN
+#define RSSI_MUX_INPUT_PIN RSSI_INPUT0_PIN
+#endif
+#define RSSI_MUX_SELECT_PIN_MAP { PB5, PB10, PC14, PC15 }  //S0-S3 lines to multiplexer
+#define RSSI_MUX_SELECT_BITS 4
+#define RSSI_MUX_SETTLE_MICROS 5       //time for mux output to settle after channel change
+#else
+#define RX5808_SEL_PIN_MAP_EXT
+#endif
+
 #define VOLTAGE_MONITOR_PIN PB0
 
 #define RPI_SIGNAL_PIN A7
@@ -150,6 +330,13 @@
 
 #endif
 
+#define RSSI_INPUT_PIN_MAP { RSSI_INPUT0_PIN, RSSI_INPUT1_PIN, RSSI_INPUT2_PIN, RSSI_INPUT3_PIN, \
+                             RSSI_INPUT4_PIN, RSSI_INPUT5_PIN, RSSI_INPUT6_PIN, RSSI_INPUT7_PIN }
+
+#if RSSI_MUX_FLAG && !defined(RSSI_MUX_INPUT_PIN)
+#error "RSSI multiplexer not supported for this board"
+#endif
+
 #define MODULE_LED_ONSTATE LOW
 #define MODULE_LED_OFFSTATE HIGH
 
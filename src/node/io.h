@@ -5,11 +5,29 @@
 
 #define TEXT_BLOCK_SIZE 16   // length of data for 'writeTextBlock()'
 
+// READ_NODE_DESCRIPTOR response:  header (revision code, feature flags, node count,
+//  firmware strings) followed by an entry (slot index, frequency, EnterAt, ExitAt,
+//  node peak, node nadir) for each node
+#define NODE_DESCRIPTOR_HEADER_SIZE (5 + 4 * TEXT_BLOCK_SIZE)
+#define NODE_DESCRIPTOR_ENTRY_SIZE 7
+#define NODE_DESCRIPTOR_SIZE (NODE_DESCRIPTOR_HEADER_SIZE + \
+                              MULTI_RHNODE_MAX * NODE_DESCRIPTOR_ENTRY_SIZE)
+
+// Arduino nodes (low RAM) size buffers for a full I2C transfer and do not
+//  support READ_NODE_DESCRIPTOR (tests with __TEST_ALL_FEATURES__ still cover it)
+#if STM32_MODE_FLAG || defined(__TEST_ALL_FEATURES__)
+#define NODE_DESCRIPTOR_FLAG 1
+#define IO_BUFFER_SIZE (NODE_DESCRIPTOR_SIZE + 1)  // include checksum byte
+#else
+#define NODE_DESCRIPTOR_FLAG 0
+#define IO_BUFFER_SIZE 32
+#endif
+
 class Buffer {
     public:
         uint8_t index = 0;
         uint8_t size = 0;
-        uint8_t data[20];  // Data array for I/O, up to 20 bytes per message
+        uint8_t data[IO_BUFFER_SIZE];  // Data array for I/O
 
         bool isEmpty() {
             return size == 0;
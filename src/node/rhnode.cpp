@@ -87,11 +87,72 @@ void i2cReceive(int byteCount);
 bool i2cReadAndValidateIoBuffer(byte expectedSize);
 void i2cTransmit();
 
-#elif STM32_SERIALUSB_FLAG
+#else
+#if STM32_SERIALUSB_FLAG
 void serialEvent();
 #endif
 
+static HardwareTimer *sampleTimerPtr = NULL;
+#endif
+
+// Called by timer interrupt at each sample slot time; reads RSSI for the
+//  node in the slot into its sample FIFO (processed later by main loop)
+void sampleTimerTick()
+{
+    utime_t nowMicros = micros();
+    uint8_t slot = RssiNode::sampleScheduler.timerTick(nowMicros);
+    if (slot == SAMPLE_SLOT_NONE)
+        return;
+    RssiNode::rssiNodeArray[slot].rssiAcquire(nowMicros, RssiNode::sampleScheduler.getSlotOversample(slot));
+#if RSSI_MUX_FLAG
+    // switch multiplexer now so it settles before next node is sampled
+    RssiNode::rssiNodeArray[RssiNode::sampleScheduler.getNextSlot()].rssiMuxSelect();
+#endif
+}
+
+// Keeps only nodes that are activated and not powered down in the sampling
+//  rotation (the time freed goes to sampling the remaining nodes more often)
+static void updateSampleRotation()
+{
+    bool changedFlag = false;
+    for (uint8_t nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
+    {
+        RssiNode &node = RssiNode::rssiNodeArray[nIdx];
+        bool activeFlag = node.getActivatedFlag() && !node.isRxPoweredDown();
+        if (RssiNode::sampleScheduler.setSlotActive(nIdx, activeFlag))
+        {
+            if (activeFlag)
+                node.restartSampling();  // not sampled until rotation is updated
+            changedFlag = true;
+        }
+    }
+    if (!changedFlag)
+        return;
+#if STM32_MODE_FLAG
+    sampleTimerPtr->pause();
+    utime_t tickMicros = RssiNode::sampleScheduler.updateRotation();
+    if (tickMicros > 0)
+    {
+        sampleTimerPtr->setOverflow(tickMicros, MICROSEC_FORMAT);
+        sampleTimerPtr->resume();
+    }
+#else
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        RssiNode::sampleScheduler.updateRotation();  // single node; timer interval unchanged
+    }
+#endif
+}
+
+#if !STM32_MODE_FLAG
+ISR(TIMER1_COMPA_vect)
+{
+    sampleTimerTick();
+}
+#endif
+
 void setModuleLed(bool onFlag);
+static void initHousekeepingTasks();
 
 #if defined(RPI_SIGNAL_PIN) || defined(AUXLED_OUTPUT_PIN) || defined(BUZZER_OUTPUT_PIN)
 void handleRpiSignalAndShutdownActions(mtime_t curTimeMs);
@@ -203,6 +264,9 @@ void setup()
 
 #if STM32_MODE_FLAG
 
+#if RSSI_MUX_FLAG
+    RssiNode::initRssiMux();
+#endif
     for (int nIdx=0; nIdx<MULTI_RHNODE_MAX; ++nIdx)
         RssiNode::rssiNodeArray[nIdx].initRx5808Pins(nIdx);
 
@@ -233,6 +297,14 @@ void setup()
         }
     }
 
+    // start timer that samples each node at a fixed phase
+    utime_t tickMicros = RssiNode::sampleScheduler.init(
+                            RssiNode::multiRssiNodeCount, SAMPLE_PERIOD_MICROS);
+    sampleTimerPtr = new HardwareTimer(SAMPLE_TIMER_INSTANCE);
+    sampleTimerPtr->setOverflow(tickMicros, MICROSEC_FORMAT);
+    sampleTimerPtr->attachInterrupt(sampleTimerTick);
+    sampleTimerPtr->resume();
+
 #else
     RssiNode::multiRssiNodeCount = 1;
     RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
@@ -266,158 +338,242 @@ void setup()
     rssiNodePtr->initRxModule();  //init and set RX5808 to default frequency
     rssiNodePtr->rssiInit();      //initialize RSSI processing
 
+    // start Timer1 (CTC mode, prescaler 8) to drive sampling
+    RssiNode::sampleScheduler.init(1, SAMPLE_PERIOD_MICROS);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TCCR1A = 0;
+        TCCR1B = _BV(WGM12) | _BV(CS11);
+        TCNT1 = 0;
+        OCR1A = (uint16_t)((F_CPU / 8 / 1000000L) * SAMPLE_PERIOD_MICROS - 1);
+        TIMSK1 = _BV(OCIE1A);
+    }
 #endif
+
+    initHousekeepingTasks();
 }
 
+static uint8_t samplingTaskIdx = 0;      // task entry used to account sample processing
+static uint8_t commsChangeFlags = 0;     // 'settingChangedFlags' values for comms-monitor task
+static uint8_t statusChangeFlags = 0;    // 'settingChangedFlags' values for status-LED task
+static bool overloadFlag = false;        // sample backlog reached LOAD_SHED_BACKLOG recently
+static mtime_t overloadEndMs = 0;        // non-critical tasks shed until this time
+
 #if !STM32_MODE_FLAG
 static bool commsMonitorEnabledFlag = false;
 static mtime_t commsMonitorLastResetTime = 0;
+static bool commsI2cLapStatsFlag = false;  // I2C LAPSTATS_READ received while activated
 #endif
 
-// Main loop
-void loop()
+// Processes samples queued by the sampling interrupt for each node; returns
+//  true if any samples were processed.  A large backlog of queued samples
+//  means the main loop is falling behind, so non-critical tasks are shed
+//  for a while (see 'loop()')
+static bool processAcquiredSamples()
 {
-    static mtime_t loopMillis = 0;
-#ifdef BUZZER_OUTPUT_PIN
-    static bool waitingForFirstCommsFlag = true;
-#endif
-
-#if STM32_MODE_FLAG && STM32_SERIALUSB_FLAG
-    serialEvent();  // need to check serial-USB for data (called automatically if Serial)
-#endif
-
-    mtime_t curTimeMs = millis();
-    if (curTimeMs > loopMillis)
-    {  // limit to once per millisecond
-
-        // read raw RSSI close to taking timestamp
-        bool crossingFlag;
-        if (RssiNode::multiRssiNodeCount <= (uint8_t)1)
-            crossingFlag = RssiNode::rssiNodeArray[0].rssiProcess(curTimeMs);
-        else
+    bool processedFlag = false;
+    for (uint8_t nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
+    {
+        utime_t startMicros = micros();
+        if (RssiNode::rssiNodeArray[nIdx].getSampleFifo().getCount() >= LOAD_SHED_BACKLOG)
         {
-            crossingFlag = false;
-            for (uint8_t nIdx=0; nIdx<RssiNode::multiRssiNodeCount; ++nIdx)
-            {
-                RssiNode::rssiNodeArray[nIdx].rssiProcess(curTimeMs);
-                curTimeMs = millis();
-            }
+            overloadFlag = true;
+            overloadEndMs = millis() + LOAD_SHED_HOLD_MS;
         }
+        uint8_t count = RssiNode::rssiNodeArray[nIdx].rssiProcessSamples();
+        if (count > 0)
+        {
+            RssiNode::sampleScheduler.recordProcessing(nIdx, micros() - startMicros, count);
+            processedFlag = true;
+        }
+    }
+    return processedFlag;
+}
 
-        // update settings and status LED
+// Applies settings changed via commands
+static void settingsTask(mtime_t /*curTimeMs*/)
+{
+    RssiNode *rssiNodePtr = getCmdRssiNodePtr();
+
+    uint8_t changeFlags;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        changeFlags = settingChangedFlags;
+        settingChangedFlags &= COMM_ACTIVITY;  // clear all except COMM_ACTIVITY
+    }
+    commsChangeFlags |= changeFlags;
+    statusChangeFlags |= changeFlags;
 
-        RssiNode *rssiNodePtr = getCmdRssiNodePtr();
+#if !STM32_MODE_FLAG
+    bool oldActFlag = rssiNodePtr->getActivatedFlag();
 
-        uint8_t changeFlags;
+                  // set freq here if Arduino running single RX5808 module
+                  //  otherwise set in 'commands'
+    if (changeFlags & FREQ_SET)
+    {
+        uint16_t newVtxFreq;
         ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
         {
-            changeFlags = settingChangedFlags;
-            settingChangedFlags &= COMM_ACTIVITY;  // clear all except COMM_ACTIVITY
+            newVtxFreq = rssiNodePtr->getVtxFreq();
         }
+        rssiNodePtr->setRxModuleToFreq(newVtxFreq);
+        rssiNodePtr->setActivatedFlag(true);
 
-#if !STM32_MODE_FLAG
-        bool oldActFlag = rssiNodePtr->getActivatedFlag();
-
-                      // set freq here if Arduino running single RX5808 module
-                      //  otherwise set in 'commands'
-        if (changeFlags & FREQ_SET)
+        if (changeFlags & FREQ_CHANGED)
         {
-            uint16_t newVtxFreq;
-            ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
-            {
-                newVtxFreq = rssiNodePtr->getVtxFreq();
-            }
-            rssiNodePtr->setRxModuleToFreq(newVtxFreq);
-            rssiNodePtr->setActivatedFlag(true);
-
-            if (changeFlags & FREQ_CHANGED)
-            {
-                rssiNodePtr->rssiStateReset();  // restart rssi peak tracking for node
-            }
+            rssiNodePtr->rssiStateReset();  // restart rssi peak tracking for node
         }
+    }
+
+    if (oldActFlag && (changeFlags & LAPSTATS_READ) && (changeFlags & SERIAL_CMD_MSG) == (uint8_t)0)
+        commsI2cLapStatsFlag = true;
 #endif
 
-        // also allow READ_LAP_STATS command to activate operations
-        //  so they will resume after node or I2C bus reset
-        if (!rssiNodePtr->getActivatedFlag() && (changeFlags & LAPSTATS_READ))
-            rssiNodePtr->setActivatedFlag(true);
+    // also allow READ_LAP_STATS command to activate operations
+    //  so they will resume after node or I2C bus reset
+    if (!rssiNodePtr->getActivatedFlag() && (changeFlags & LAPSTATS_READ))
+        rssiNodePtr->setActivatedFlag(true);
+
+    if (changeFlags & (FREQ_SET | LAPSTATS_READ))
+        updateSampleRotation();
+}
 
 #if !STM32_MODE_FLAG
-        if (commsMonitorEnabledFlag)
-        {
-            if (changeFlags & COMM_ACTIVITY)
-            {  //communications activity detected; update comms monitor time
-                commsMonitorLastResetTime = curTimeMs;
-            }
-            else if (curTimeMs - commsMonitorLastResetTime > COMMS_MONITOR_TIME_MS)
-            {  //too long since last communications activity detected
-                commsMonitorEnabledFlag = false;
-                // redo init, which should release I2C pins (SDA & SCL) if "stuck"
-                i2cInitialize(true);
-            }
-        }
-        else if (oldActFlag && (changeFlags & LAPSTATS_READ) &&
-                (changeFlags & SERIAL_CMD_MSG) == (uint8_t)0)
-        {  //if activated and I2C LAPSTATS_READ cmd received then enable comms monitor
-            commsMonitorEnabledFlag = true;
+// Re-initializes I2C if communications stop (in case bus is "stuck")
+static void commsMonitorTask(mtime_t curTimeMs)
+{
+    const uint8_t changeFlags = commsChangeFlags;
+    commsChangeFlags = 0;
+    if (commsMonitorEnabledFlag)
+    {
+        if (changeFlags & COMM_ACTIVITY)
+        {  //communications activity detected; update comms monitor time
             commsMonitorLastResetTime = curTimeMs;
         }
+        else if (curTimeMs - commsMonitorLastResetTime > COMMS_MONITOR_TIME_MS)
+        {  //too long since last communications activity detected
+            commsMonitorEnabledFlag = false;
+            // redo init, which should release I2C pins (SDA & SCL) if "stuck"
+            i2cInitialize(true);
+        }
+    }
+    else if (commsI2cLapStatsFlag)
+    {  //if activated and I2C LAPSTATS_READ cmd received then enable comms monitor
+        commsMonitorEnabledFlag = true;
+        commsMonitorLastResetTime = curTimeMs;
+    }
+    commsI2cLapStatsFlag = false;
+}
 #endif
 
-        // Status LED
-        if (curTimeMs <= 1000)
-        {  //flash two times during first second of running
-            if (curTimeMs >= 500)  //don't check until 500ms elapsed
-            {
-                const int ti = (int)(curTimeMs-500) / 100;
-                const bool sFlag = (ti == 1 || ti == 3);
-                setModuleLed(sFlag);
+// Updates status LED (and buzzer)
+static void statusLedTask(mtime_t curTimeMs)
+{
 #ifdef BUZZER_OUTPUT_PIN
-                setBuzzerState(sFlag);
+    static bool waitingForFirstCommsFlag = true;
+#endif
+    const uint8_t changeFlags = statusChangeFlags;
+    statusChangeFlags = 0;
+
+    if (curTimeMs <= 1000)
+    {  //flash two times during first second of running
+        if (curTimeMs >= 500)  //don't check until 500ms elapsed
+        {
+            const int ti = (int)(curTimeMs-500) / 100;
+            const bool sFlag = (ti == 1 || ti == 3);
+            setModuleLed(sFlag);
+#ifdef BUZZER_OUTPUT_PIN
+            setBuzzerState(sFlag);
 #endif
-            }
         }
-        else if ((int)(curTimeMs % 20) == 0)
-        {  //only run every 20ms (so flashes/beeps last longer and less CPU load)
+        return;
+    }
 
 #ifdef BUZZER_OUTPUT_PIN
-            if (buzzerBeepDurationCounter > 0)
-            {
-                if (--buzzerBeepDurationCounter <= 0)
-                    setBuzzerState(false);
-            }
+    if (buzzerBeepDurationCounter > 0)
+    {
+        if (--buzzerBeepDurationCounter <= 0)
+            setBuzzerState(false);
+    }
 #endif
-            // if crossing or communications activity then LED on
-            if (crossingFlag)
-                setModuleLed(true);
-            else if (changeFlags & COMM_ACTIVITY)
-            {
-                setModuleLed(true);
-                settingChangedFlags = 0;  // clear COMM_ACTIVITY flag
+    // if crossing or communications activity then LED on
+    if (RssiNode::multiRssiNodeCount <= (uint8_t)1 && RssiNode::rssiNodeArray[0].getState().crossing)
+        setModuleLed(true);
+    else if (changeFlags & COMM_ACTIVITY)
+    {
+        setModuleLed(true);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            settingChangedFlags &= ~COMM_ACTIVITY;  // clear COMM_ACTIVITY flag
+        }
 #ifdef BUZZER_OUTPUT_PIN
-                lastCommActivityTimeMs = curTimeMs;
-                if (waitingForFirstCommsFlag && (changeFlags & LAPSTATS_READ))
-                {
-                    waitingForFirstCommsFlag = false;
-                    setBuzzerState(true);  // beep when operations activated
-                    buzzerBeepDurationCounter = 1;
-                }
+        lastCommActivityTimeMs = curTimeMs;
+        if (waitingForFirstCommsFlag && (changeFlags & LAPSTATS_READ))
+        {
+            waitingForFirstCommsFlag = false;
+            setBuzzerState(true);  // beep when operations activated
+            buzzerBeepDurationCounter = 1;
+        }
+#endif
+    }
+    else
+        setModuleLed(curTimeMs % 2000 == 0);  // blink
+}
+
+#ifdef AUXLED_OUTPUT_PIN
+// Shows fast blink while shutdown button pressed
+static void auxLedBlinkTask(mtime_t curTimeMs)
+{
+    if (shutdownButtonPressedFlag && (!shutdownHasBeenStartedFlag) && (!rpiSignalMissingFlag))
+        digitalWrite(AUXLED_OUTPUT_PIN, ((int)((curTimeMs/2) % 40) == 0) ? HIGH : LOW);
+}
 #endif
-            }
-            else
-                setModuleLed(curTimeMs % 2000 == 0);  // blink
 
+// Sets up housekeeping tasks run by main loop
+static void initHousekeepingTasks()
+{
+    samplingTaskIdx = housekeepingTasks.addTask(TASK_ID_SAMPLING, NULL, 0, 0);
+    housekeepingTasks.addTask(TASK_ID_SETTINGS, settingsTask, 1, 1);
+#if !STM32_MODE_FLAG
+    housekeepingTasks.addTask(TASK_ID_COMMS_MONITOR, commsMonitorTask, 10, 2);
+#endif
+    //only run every 20ms (so flashes/beeps last longer and less CPU load)
+    housekeepingTasks.addTask(TASK_ID_STATUS_LED, statusLedTask, 20, 3);
 #if defined(RPI_SIGNAL_PIN) || defined(AUXLED_OUTPUT_PIN) || defined(BUZZER_OUTPUT_PIN)
-            handleRpiSignalAndShutdownActions(curTimeMs);
+    housekeepingTasks.addTask(TASK_ID_SHUTDOWN, handleRpiSignalAndShutdownActions, 20, 4);
 #endif
-        }
+#ifdef AUXLED_OUTPUT_PIN
+    housekeepingTasks.addTask(TASK_ID_AUXLED_BLINK, auxLedBlinkTask, 2, 5);
+#endif
+    housekeepingTasks.clearStats(micros());
+}
 
-#ifdef AUXLED_OUTPUT_PIN  // show fast blink while shutdown button pressed
-        if (shutdownButtonPressedFlag && (!shutdownHasBeenStartedFlag) && (!rpiSignalMissingFlag))
-            digitalWrite(AUXLED_OUTPUT_PIN, ((int)((curTimeMs/2) % 40) == 0) ? HIGH : LOW);
+// Main loop
+void loop()
+{
+#if STM32_MODE_FLAG && STM32_SERIALUSB_FLAG
+    serialEvent();  // need to check serial-USB for data (called automatically if Serial)
 #endif
 
-        loopMillis = curTimeMs;
+    utime_t startMicros = micros();
+    if (processAcquiredSamples())
+        housekeepingTasks.addRunTime(samplingTaskIdx, micros() - startMicros);
+
+    // run one housekeeping task in the slack time after sampling
+    const mtime_t curTimeMs = millis();
+    if (overloadFlag)
+    {
+        if ((int32_t)(curTimeMs - overloadEndMs) < 0)
+            housekeepingTasks.shedDueTasks(curTimeMs, LOAD_SHED_MAX_PRIORITY);
+        else
+            overloadFlag = false;
+    }
+    const int8_t taskIdx = housekeepingTasks.getDueTask(curTimeMs);
+    if (taskIdx >= 0)
+    {
+        startMicros = micros();
+        housekeepingTasks.runTask(taskIdx, curTimeMs);
+        housekeepingTasks.addRunTime(taskIdx, micros() - startMicros);
     }
 }
 
@@ -0,0 +1,59 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "../RssiNode.h"
+#include "../commands.h"
+
+// test node is at I2C address 8, so uses entry 0 of broadcast tables
+void fillBcastTable(Message& msg, uint8_t cmd, uint8_t mask, uint16_t entry0, uint16_t entry1)
+{
+  msg.command = cmd;
+  msg.buffer.flipForWrite();
+  msg.buffer.write8(mask);
+  msg.buffer.write16(entry0);
+  msg.buffer.write16(entry1);
+  for (int i = 2; i < BCAST_TABLE_SIZE; i++)
+    msg.buffer.write16(0);
+  assertEqual(msg.getPayloadSize(), msg.buffer.size);
+}
+
+unittest(bcastEnterExit)
+{
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->setEnterAtLevel(96);
+  rssiNodePtr->setExitAtLevel(80);
+
+  Message msg;
+  // entry for this node not flagged in mask; ignored
+  fillBcastTable(msg, WRITE_BCAST_ENTER_EXIT, 0x02, (100 << 8) | 70, (120 << 8) | 110);
+  msg.handleWriteCommand(false);
+  assertEqual(96, rssiNodePtr->getEnterAtLevel());
+  assertEqual(80, rssiNodePtr->getExitAtLevel());
+
+  fillBcastTable(msg, WRITE_BCAST_ENTER_EXIT, 0x03, (100 << 8) | 70, (120 << 8) | 110);
+  msg.handleWriteCommand(false);
+  assertEqual(100, rssiNodePtr->getEnterAtLevel());
+  assertEqual(70, rssiNodePtr->getExitAtLevel());
+}
+
+unittest(bcastFrequency)
+{
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->setVtxFreq(5800);
+
+  Message msg;
+  fillBcastTable(msg, WRITE_BCAST_FREQUENCY, 0x01, 5685, 5760);
+  msg.handleWriteCommand(false);
+  assertEqual(5685, rssiNodePtr->getVtxFreq());
+  assertTrue(settingChangedFlags & FREQ_CHANGED);
+
+  msg.command = READ_NODE_SETTINGS;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  assertEqual(5685, msg.buffer.read16());
+  assertEqual(rssiNodePtr->getEnterAtLevel(), msg.buffer.read8());
+  assertEqual(rssiNodePtr->getExitAtLevel(), msg.buffer.read8());
+}
+
+unittest_main()
@@ -0,0 +1,63 @@
+#include <ArduinoUnitTests.h>
+#include "../util/rssi-calibration.h"
+
+// noise around 50, with a 100-sample triangular fly-by to 'peak' every 1000 samples
+static bool addSignal(RssiCalibration<2>& c, int count, const int* peaks, int numPeaks)
+{
+  bool finished = false;
+  for (int i = 0; i < count; ++i)
+  {
+    int v = 50 + ((i * 7) % 5) - 2;
+    int pos = i % 1000;
+    int idx = i / 1000;
+    if (idx < numPeaks && pos >= 450 && pos < 550)
+    {
+      int rise = (peaks[idx] - 50) * (50 - abs(pos - 500)) / 50;
+      if (rise > v - 50)
+        v = 50 + rise;
+    }
+    finished = c.addSample((rssi_t)v);
+  }
+  return finished;
+}
+
+unittest(calibrationFlyBys)
+{
+  RssiCalibration<2> c;
+  assertEqual(CALIBRATION_IDLE, c.getStatus());
+  c.start(5000, 16, 70, 40);
+  static const int peaks[] = { 120, 130, 124, 116, 128 };
+  assertFalse(addSignal(c, 4999, peaks, 5));
+  assertEqual(CALIBRATION_CAPTURING, c.getStatus());
+  assertTrue(c.addSample(50));
+  assertEqual(CALIBRATION_DONE, c.getStatus());
+  assertEqual(5000, c.getSampleCount());
+  assertFalse(c.addSample(50));  // capture over
+
+  const CalibrationResult &r = c.getResult();
+  assertEqual(5, r.passCount);
+  assertLess(abs((int)r.noiseP50 - 50), 3);
+  assertLess(abs((int)r.peakMax - 130), 3);
+  assertLess(abs((int)r.peakP25 - 120), 3);
+  assertTrue(r.noiseP10 <= r.noiseP50 && r.noiseP50 <= r.noiseFloor);
+  assertLess((int)r.noiseFloor, 60);
+  assertTrue(r.exitAtLevel > r.noiseFloor && r.exitAtLevel < r.enterAtLevel);
+  assertTrue(r.enterAtLevel < r.peakP25);
+}
+
+unittest(calibrationNoPasses)
+{
+  RssiCalibration<2> c;
+  c.start(3000, 16, 70, 40);
+  static const int peaks[] = { 60, 60, 60 };  // not above noise floor
+  assertTrue(addSignal(c, 3000, peaks, 3));
+  assertEqual(CALIBRATION_NO_PASSES, c.getStatus());
+  assertEqual(0, c.getResult().passCount);
+  assertEqual(0, c.getResult().enterAtLevel);
+
+  c.start(0, 16, 70, 40);  // cancel
+  assertEqual(CALIBRATION_IDLE, c.getStatus());
+  assertFalse(c.addSample(50));
+}
+
+unittest_main()
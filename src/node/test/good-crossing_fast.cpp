@@ -72,19 +72,19 @@ unittest(fastCrossing) {
   assertEqual(-60, (int)history.rssiChange);
   assertEqual(130, (int)history.peak.rssi);
   assertEqual(timestamp(3), (int)history.peak.firstTime);
-  assertEqual(time(1)-1, (int)history.peak.duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peak.duration);
   assertEqual(70, (int)history.nadir.rssi); // first downward trend
   assertEqual(timestamp(4), (int)history.nadir.firstTime);
   assertEqual(0, (int)history.nadir.duration);
 
   assertEqual(130, (int)history.peakSend->first().rssi);
   assertEqual(timestamp(3), (int)history.peakSend->first().firstTime);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   assertTrue(history.nadirSend->isEmpty());
 
   assertEqual(130, (int)lastPass.rssiPeak);
   assertEqual(50, (int)lastPass.rssiNadir);
-  assertEqual((timestamp(3)+timestamp(4)-1)/2, (int)lastPass.timestamp);
+  assertEqual((timestamp(3)+timestamp(4)-TICK_MICROS)/2, (int)lastPass.timestamp);
   assertEqual(1, (int)lastPass.lap);
 
   // small rise
@@ -105,19 +105,19 @@ unittest(fastCrossing) {
   assertEqual(0, (int)history.peak.duration);
   assertEqual(70, (int)history.nadir.rssi);
   assertEqual(timestamp(4), (int)history.nadir.firstTime);
-  assertEqual(time(1)-1, (int)history.nadir.duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadir.duration);
 
   assertEqual(130, (int)history.peakSend->first().rssi);
   assertEqual(timestamp(3), (int)history.peakSend->first().firstTime);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   history.peakSend->removeFirst();
   assertEqual(70, (int)history.nadirSend->first().rssi);
   assertEqual(timestamp(4), (int)history.nadirSend->first().firstTime);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   assertEqual(130, (int)lastPass.rssiPeak);
   assertEqual(50, (int)lastPass.rssiNadir);
-  assertEqual((timestamp(3)+timestamp(4)-1)/2, (int)lastPass.timestamp);
+  assertEqual((timestamp(3)+timestamp(4)-TICK_MICROS)/2, (int)lastPass.timestamp);
   assertEqual(1, (int)lastPass.lap);
 
   // small fall
@@ -125,10 +125,10 @@ unittest(fastCrossing) {
 
   assertEqual(75, (int)history.peakSend->first().rssi);
   assertEqual(timestamp(5), (int)history.peakSend->first().firstTime);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   assertEqual(70, (int)history.nadirSend->first().rssi);
   assertEqual(timestamp(4), (int)history.nadirSend->first().firstTime);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
   history.nadirSend->removeFirst();
 }
 
@@ -49,17 +49,17 @@ unittest(gradualCrossing) {
   assertEqual(130, (int)state.nodeRssiPeak);
 
   assertFalse(state.crossing);
-  assertEqual(time(2)-1, (int)state.passPeak.duration);
+  assertEqual(time(2)-TICK_MICROS, (int)state.passPeak.duration);
   assertEqual(70, (int)state.passRssiNadir);
 
   assertEqual(130, (int)history.peak.rssi);
-  assertEqual(time(2)-1, (int)history.peak.duration);
+  assertEqual(time(2)-TICK_MICROS, (int)history.peak.duration);
   assertEqual(70, (int)history.nadir.rssi);
   assertEqual(0, (int)history.nadir.duration);
 
   assertFalse(history.peakSend->isEmpty());
   assertEqual(130, (int)history.peakSend->first().rssi);
-  assertEqual(time(2)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(2)-TICK_MICROS, (int)history.peakSend->first().duration);
   assertTrue(history.nadirSend->isEmpty());
 
   assertEqual(130, (int)state.nodeRssiPeak);
@@ -76,19 +76,19 @@ unittest(slowCrossing) {
   assertEqual(-60, (int)history.rssiChange);
   assertEqual(130, (int)history.peak.rssi);
   assertEqual(timestamp(3), (int)history.peak.firstTime);
-  assertEqual(time(1+duration)-1, (int)history.peak.duration);
+  assertEqual(time(1+duration)-TICK_MICROS, (int)history.peak.duration);
   assertEqual(70, (int)history.nadir.rssi); // first downward trend
   assertEqual(timestamp(4+duration), (int)history.nadir.firstTime);
   assertEqual(0, (int)history.nadir.duration);
 
   assertEqual(130, (int)history.peakSend->first().rssi);
   assertEqual(timestamp(3), (int)history.peakSend->first().firstTime);
-  assertEqual(time(1+duration)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1+duration)-TICK_MICROS, (int)history.peakSend->first().duration);
   assertTrue(history.nadirSend->isEmpty());
 
   assertEqual(130, (int)lastPass.rssiPeak);
   assertEqual(50, (int)lastPass.rssiNadir);
-  assertEqual((timestamp(3)+timestamp(4+duration)-1)/2, (int)lastPass.timestamp);
+  assertEqual((timestamp(3)+timestamp(4+duration)-TICK_MICROS)/2, (int)lastPass.timestamp);
   assertEqual(1, (int)lastPass.lap);
 }
 
@@ -0,0 +1,46 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "../RssiNode.h"
+#include "../commands.h"
+
+#if NODE_DESCRIPTOR_FLAG
+unittest(nodeDescriptor)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->setVtxFreq(5740);
+  rssiNodePtr->setEnterAtLevel(110);
+  rssiNodePtr->setExitAtLevel(90);
+
+  Message msg;
+  msg.command = READ_NODE_DESCRIPTOR;
+  msg.handleReadCommand(false);
+
+  assertEqual(NODE_DESCRIPTOR_HEADER_SIZE + NODE_DESCRIPTOR_ENTRY_SIZE + 1, msg.buffer.size);
+  assertEqual(msg.buffer.calculateChecksum(msg.buffer.size - 1), msg.buffer.data[msg.buffer.size - 1]);
+
+  msg.buffer.flipForRead();
+  assertEqual(NODE_REVISION_CODE, msg.buffer.read16());
+  assertEqual(RHFEAT_FLAGS_VALUE, msg.buffer.read16());
+  assertEqual(1, msg.buffer.read8());
+  assertEqual('t', msg.buffer.read8());  // "FIRMWARE_VERSION: test"
+  msg.buffer.index = NODE_DESCRIPTOR_HEADER_SIZE;
+  assertEqual(0, msg.buffer.read8());
+  assertEqual(5740, msg.buffer.read16());
+  assertEqual(110, msg.buffer.read8());
+  assertEqual(90, msg.buffer.read8());
+}
+#else
+unittest(nodeDescriptorNotSupported)
+{
+  Message msg;
+  msg.command = READ_NODE_DESCRIPTOR;
+  msg.handleReadCommand(false);
+  assertTrue(msg.buffer.isEmpty());  // Arduino node does not answer
+}
+#endif
+
+unittest_main()
@@ -0,0 +1,225 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+#define SIGNAL_LEN 8000
+#define PASS_COUNT 8
+#define PASS_SPACING 900   // ms between pass centers
+#define PASS_HALF_WIDTH 120
+#define SPIKE_INDEX 7650   // short glitch after last pass
+
+NoFilter<rssi_t> rawFilter;
+
+static rssi_t signalValues[SIGNAL_LEN];
+
+static int passCenter(int p) { return 500 + p * PASS_SPACING; }
+
+// noisy triangular passes (1 ms samples), with 'skew' moving each peak later
+//  within its pass, and a short spike that reaches EnterAt
+static void makeSignal(int noiseSpread, int skew)
+{
+  uint32_t seed = 4321;
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    const int noise = (int)((seed >> 16) % (2 * noiseSpread + 1)) - noiseSpread;
+    int pass = 0;
+    for (int p = 0; p < PASS_COUNT; ++p)
+    {
+      const int d = i - passCenter(p);
+      if (d > -PASS_HALF_WIDTH - skew && d <= 0)
+        pass = 80 + 80 * d / (PASS_HALF_WIDTH + skew);
+      else if (d > 0 && d < PASS_HALF_WIDTH - skew)
+        pass = 80 - 80 * d / (PASS_HALF_WIDTH - skew);
+    }
+    signalValues[i] = (i >= SPIKE_INDEX && i < SPIKE_INDEX + 4) ? 105 : (rssi_t)(40 + pass + noise);
+  }
+}
+
+struct DetectedPass
+{
+  utime_t timestamp;
+  rssi_t rssiPeak;
+};
+
+// crossing handling of 'RssiNode::rssiProcessValue()' with the given detector
+static int runDetector(CrossingDetector &detector, DetectedPass *passes, int maxPasses)
+{
+  int count = 0;
+  bool crossing = false;
+  rssi_t peak = 0;
+  utime_t firstTime = 0, duration = 0;
+  detector.reset();
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    const rssi_t v = signalValues[i];
+    const utime_t t = (utime_t)i * 1000;
+    const uint8_t transition = detector.update(v, t, crossing);
+    if (transition == DETECT_PASS_START)
+      crossing = true;
+    else if (transition == DETECT_PASS_END)
+    {
+      if (count < maxPasses)
+      {
+        uint8_t quality;
+        if (!detector.getPass(passes[count].timestamp, passes[count].rssiPeak, quality))
+        {
+          passes[count].timestamp = firstTime + duration / 2;
+          passes[count].rssiPeak = peak;
+        }
+      }
+      ++count;
+      crossing = false;
+      peak = 0;
+    }
+    if (crossing)
+    {
+      if (v > peak)
+      {
+        peak = v;
+        firstTime = t;
+        duration = 0;
+      }
+      else if (v == peak)
+        duration = t - firstTime;
+    }
+  }
+  return count;
+}
+
+static int32_t passError(const DetectedPass &pass, int p)
+{
+  const int32_t err = (int32_t)pass.timestamp - (int32_t)passCenter(p) * 1000;
+  return (err < 0) ? -err : err;
+}
+
+unittest(detectorsSideBySide)
+{
+  makeSignal(12, 0);
+  ThresholdDetector threshold;
+  threshold.setLevels(100, 80);
+  static MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> matched;
+
+  DetectedPass tPasses[16], mPasses[16];
+  const int tCount = runDetector(threshold, tPasses, 16);
+  const int mCount = runDetector(matched, mPasses, 16);
+
+  // noise splits threshold passes and the spike adds one; matched filter finds each pass once
+  assertTrue(tCount > PASS_COUNT);
+  assertEqual(PASS_COUNT, mCount);
+  int32_t mErrSum = 0, mErrMax = 0;
+  for (int p = 0; p < PASS_COUNT; ++p)
+  {
+    const int32_t err = passError(mPasses[p], p);
+    mErrSum += err;
+    if (err > mErrMax)
+      mErrMax = err;
+    assertTrue(mPasses[p].rssiPeak >= 110);
+  }
+  assertTrue(mErrMax <= 2000);
+
+  // thresholds avoid the noise and the spike only with levels set just below the peaks
+  threshold.setLevels(108, 60);
+  assertEqual(PASS_COUNT, runDetector(threshold, tPasses, 16));
+  int32_t tErrSum = 0;
+  for (int p = 0; p < PASS_COUNT; ++p)
+    tErrSum += passError(tPasses[p], p);
+  assertTrue(mErrSum <= tErrSum);
+}
+
+unittest(matchedTemplateLearned)
+{
+  makeSignal(4, 60);  // peak well after middle of each pass
+  static MatchedFilterDetector<MATCH_DETECTOR_TAPS, MATCH_POINT_SAMPLES> matched;
+  matched.setDefaultTemplate();
+  const uint8_t taps = matched.getTaps();
+  assertEqual(0, (int)matched.getTemplatePoint(0));
+  assertTrue(matched.getTemplatePoint(taps / 2) >= 90);
+
+  // learn shape from each pass as it ends
+  bool crossing = false;
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    const uint8_t transition = matched.update(signalValues[i], (utime_t)i * 1000, crossing);
+    if (transition == DETECT_PASS_START)
+      crossing = true;
+    else if (transition == DETECT_PASS_END)
+    {
+      utime_t t;
+      rssi_t peak;
+      uint8_t quality;
+      matched.getPass(t, peak, quality);
+      matched.learn();
+      crossing = false;
+    }
+  }
+  assertEqual(PASS_COUNT, (int)matched.getLearnCount());
+  // learned template is steep after its peak (asymmetric)
+  uint8_t peakIdx = 0;
+  for (uint8_t i = 1; i < taps; ++i)
+    if (matched.getTemplatePoint(i) > matched.getTemplatePoint(peakIdx))
+      peakIdx = i;
+  assertTrue(matched.getTemplatePoint(peakIdx) >= 90);
+  assertTrue(peakIdx + 3 < taps);
+  assertTrue(matched.getTemplatePoint(peakIdx + 3) < matched.getTemplatePoint(peakIdx - 3));
+
+  // learned template times the skewed passes at their peaks
+  DetectedPass passes[16];
+  assertEqual(PASS_COUNT, runDetector(matched, passes, 16));
+  for (int p = 0; p < PASS_COUNT; ++p)
+    assertTrue(passError(passes[p], p) <= 16000);
+
+  // written template
+  matched.setTemplatePoint(0, 250);
+  assertEqual(MATCH_TEMPLATE_MAX, (int)matched.getTemplatePoint(0));
+  matched.setDefaultTemplate();
+  assertEqual(0, (int)matched.getLearnCount());
+  assertEqual(0, (int)matched.getTemplatePoint(0));
+}
+
+#if MATCH_DETECTOR_FLAG
+unittest(nodeSelectsDetector)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&rawFilter);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->setEnterAtLevel(100);
+  rssiNodePtr->setExitAtLevel(80);
+  rssiNodePtr->setDetector(DETECTOR_MATCHED, false);
+  assertEqual(DETECTOR_MATCHED, (int)rssiNodePtr->getDetectorEngine());
+
+  makeSignal(12, 0);
+  const utime_t startMicros = micros();
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), signalValues[i]);
+    milliTick(nano);
+  }
+  struct LastPass &lastPass = rssiNodePtr->getLastPass();
+  assertEqual(PASS_COUNT, (int)lastPass.lap);
+  assertEqual(PEAK_REFINE_MATCHED, (int)lastPass.refineMethod);
+  assertTrue(lastPass.fitQuality >= 80);
+  const int32_t err = (int32_t)(lastPass.timestamp - startMicros) -
+                      (int32_t)passCenter(PASS_COUNT - 1) * 1000;
+  assertTrue(err <= 2000 && err >= -2000);
+
+  // back to EnterAt/ExitAt (noise and spike now add passes)
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setDetector(DETECTOR_THRESHOLD, false);
+  const uint8_t lap = lastPass.lap;
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), signalValues[i]);
+    milliTick(nano);
+  }
+  assertTrue((int)(uint8_t)(lastPass.lap - lap) > PASS_COUNT);
+  assertTrue(lastPass.refineMethod != PEAK_REFINE_MATCHED);
+}
+#endif
+
+unittest_main()
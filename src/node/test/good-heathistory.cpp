@@ -0,0 +1,242 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+#include "../commands.h"
+#include "../util/heat-history.h"
+
+#define SIGNAL_LEN 6000
+
+static rssi_t signalValues[SIGNAL_LEN];
+
+// passes with noise on a slowly varying background (1 ms samples)
+static void makeSignal()
+{
+  uint32_t seed = 12345;
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    const int noise = (int)((seed >> 16) % 5) - 2;
+    const int phase = i % 750;
+    const int pass = (phase < 150) ? 90 - abs(phase - 75) : 15;  // triangular pass every 750 ms
+    signalValues[i] = (rssi_t)(40 + pass + noise + (i / 500) % 3);
+  }
+}
+
+// crossing logic of 'RssiNode::rssiProcessValue()' applied to every sample
+static int livePasses(rssi_t enterAt, rssi_t exitAt, HistoryPass *passes)
+{
+  int count = 0;
+  bool crossing = false;
+  rssi_t peak = 0;
+  utime_t firstTime = 0, duration = 0;
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    const rssi_t v = signalValues[i];
+    const utime_t t = (utime_t)i * 1000;
+    if (!crossing && v >= enterAt)
+      crossing = true;
+    else if (crossing && v < exitAt)
+    {
+      passes[count].timestamp = firstTime + duration / 2;
+      passes[count].rssiPeak = peak;
+      ++count;
+      crossing = false;
+      peak = 0;
+    }
+    if (crossing)
+    {
+      if (v > peak)
+      {
+        peak = v;
+        firstTime = t;
+        duration = 0;
+      }
+      else if (v == peak)
+        duration = t - firstTime;
+    }
+  }
+  return count;
+}
+
+unittest(replayMatchesLive)
+{
+  makeSignal();
+  static HeatHistory<16384> history;
+  history.clear();
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+    history.add(signalValues[i], (utime_t)i * 1000, 1);
+  assertFalse(history.isTruncated());
+  assertTrue(history.getEntryCount() > 100);
+
+  const rssi_t levels[][2] = { { 100, 80 }, { 120, 110 }, { 60, 50 }, { 128, 127 } };
+  for (int k = 0; k < 4; ++k)
+  {
+    HistoryPass live[32], replayed[32];
+    const int liveCount = livePasses(levels[k][0], levels[k][1], live);
+    assertEqual(liveCount, history.replay(levels[k][0], levels[k][1], 0, replayed, 32));
+    for (int i = 0; i < liveCount; ++i)
+    {
+      assertEqual(live[i].timestamp, replayed[i].timestamp);
+      assertEqual(live[i].rssiPeak, replayed[i].rssiPeak);
+    }
+  }
+
+  // passes from given start index
+  HistoryPass live[32], page[2];
+  const int liveCount = livePasses(100, 80, live);
+  assertEqual(8, liveCount);
+  assertEqual(liveCount, history.replay(100, 80, 3, page, 2));
+  assertEqual(live[3].timestamp, page[0].timestamp);
+  assertEqual(live[4].timestamp, page[1].timestamp);
+}
+
+unittest(hysteresisAndTruncation)
+{
+  makeSignal();
+  static HeatHistory<4096> full;
+  static HeatHistory<24> small;
+  full.clear();
+  small.clear();
+  for (int i = 0; i < SIGNAL_LEN; ++i)
+  {
+    full.add(signalValues[i], 5000000 + (utime_t)i * 1000, 5);
+    small.add(signalValues[i], 5000000 + (utime_t)i * 1000, 5);
+  }
+  // noise is dropped, so only the passes (and background steps) remain
+  assertTrue(full.getEntryCount() < 60);
+  HistoryPass live[32], replayed[32];
+  const int liveCount = livePasses(100, 80, live);
+  assertEqual(liveCount, full.replay(100, 80, 0, replayed, 32));
+  for (int i = 0; i < liveCount; ++i)
+    assertEqual(live[i].rssiPeak, replayed[i].rssiPeak);
+
+  // oldest extremums dropped when buffer is full; newest passes are kept
+  assertTrue(small.isTruncated());
+  assertTrue(small.getUsedBytes() <= 24);
+  assertTrue(small.getStartMicros() > 5000000 + 750000);
+  const int smallCount = small.replay(100, 80, 0, replayed, 32);
+  assertTrue(smallCount > 0 && smallCount < liveCount);
+  assertEqual(live[liveCount - 1].timestamp + 5000000, replayed[smallCount - 1].timestamp);
+
+  small.clear();
+  assertEqual(0, small.getEntryCount());
+  assertEqual(0, small.replay(100, 80, 0, replayed, 32));
+}
+
+
+#if HEAT_HISTORY_FLAG
+#define NODE_SIGNAL_LEN 2400  // four passes (node history is smaller than the one above)
+
+LowPassFilter50Hz lowpassFilter;
+
+// laps reported by node for first 'NODE_SIGNAL_LEN' samples of signal; timestamps
+//  are before peak refinement (which replay does not do) and relative to 'startMicros'
+static int nodePasses(RssiNode *rssiNodePtr, GodmodeState* nano, rssi_t enterAt, rssi_t exitAt,
+                      HistoryPass *passes, utime_t &startMicros)
+{
+  startMicros = micros();
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setEnterAtLevel(enterAt);
+  rssiNodePtr->setExitAtLevel(exitAt);
+  struct LastPass &lastPass = rssiNodePtr->getLastPass();
+  uint8_t lap = lastPass.lap;
+  int count = 0;
+  for (int i = 0; i < NODE_SIGNAL_LEN; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), signalValues[i]);
+    milliTick(nano);
+    if (lastPass.lap != lap)
+    {
+      lap = lastPass.lap;
+      passes[count].timestamp = lastPass.timestamp - lastPass.refineMicros - startMicros;
+      passes[count].rssiPeak = lastPass.rssiPeak;
+      ++count;
+    }
+  }
+  return count;
+}
+
+unittest(nodeReplayMatchesLiveLaps)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&lowpassFilter);
+  rssiNodePtr->setActivatedFlag(true);
+  makeSignal();
+
+  // history kept while timing with one set of levels gives the laps that
+  //  the node times live with another
+  HistoryPass live[8], replayed[8];
+  utime_t liveStart, replayStart;
+  const int liveCount = nodePasses(rssiNodePtr, nano, 120, 110, live, liveStart);
+  assertEqual(4, liveCount);
+  nodePasses(rssiNodePtr, nano, 100, 80, replayed, replayStart);
+  HeatHistory<HEAT_HISTORY_BYTES> &history = rssiNodePtr->getHeatHistory();
+  assertFalse(history.isTruncated());
+  assertEqual(liveCount, history.replay(120, 110, 0, replayed, 8));
+  for (int i = 0; i < liveCount; ++i)
+  {
+    assertEqual(live[i].timestamp, replayed[i].timestamp - replayStart);
+    assertEqual(live[i].rssiPeak, replayed[i].rssiPeak);
+  }
+}
+
+// writes WRITE_RECOMPUTE_LAPS and reads first page; returns passes found
+static uint8_t readRecomputedLaps(Message &msg, rssi_t enterAt, rssi_t exitAt, uint8_t offset,
+                                  rssi_t &firstPeak)
+{
+  msg.command = WRITE_RECOMPUTE_LAPS;
+  msg.buffer.flipForWrite();
+  ioBufferWriteRssi(msg.buffer, enterAt);
+  ioBufferWriteRssi(msg.buffer, exitAt);
+  msg.buffer.write8(offset);
+  msg.handleWriteCommand(false);
+  msg.command = READ_RECOMPUTED_LAPS;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  ioBufferReadRssi(msg.buffer);
+  ioBufferReadRssi(msg.buffer);
+  const uint8_t total = msg.buffer.read8();
+  msg.buffer.read8();  // start pass
+  msg.buffer.read8();  // flags
+  msg.buffer.read32();  // ms since start of history
+  msg.buffer.read32();  // ms since first pass on page
+  firstPeak = ioBufferReadRssi(msg.buffer);
+  return total;
+}
+
+unittest(recomputeReplaysOncePerRequest)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&lowpassFilter);
+  rssiNodePtr->setActivatedFlag(true);
+  makeSignal();
+  HistoryPass live[8];
+  utime_t liveStart;
+  const int liveCount = nodePasses(rssiNodePtr, nano, 120, 110, live, liveStart);
+
+  Message msg;
+  rssi_t peak;
+  assertEqual(liveCount, readRecomputedLaps(msg, 120, 110, 0, peak));
+  assertEqual(live[0].rssiPeak, peak);
+
+  // another pass; later pages of the same request come from the first replay
+  for (int i = NODE_SIGNAL_LEN; i < NODE_SIGNAL_LEN + 750; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), signalValues[i]);
+    milliTick(nano);
+  }
+  assertEqual(liveCount, readRecomputedLaps(msg, 120, 110, 2, peak));
+  assertEqual(live[2].rssiPeak, peak);
+  assertEqual(liveCount + 1, readRecomputedLaps(msg, 120, 110, 0, peak));
+}
+#endif
+
+unittest_main()
@@ -45,25 +45,25 @@ unittest(historyBuffer_withoutReads) {
   sendSignal(rssiNodePtr, nano, 80);
   assertEqual(80, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   // large extremum nadir
   sendSignal(rssiNodePtr, nano, 20);
   assertEqual(20, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   // small extremum peak
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
   // merged with current peakSend
-  assertEqual(time(3)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(3)-TICK_MICROS, (int)history.peakSend->first().duration);
   // small extremum nadir
   sendSignal(rssiNodePtr, nano, 40);
   assertEqual(40, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
   // merged with current nadirSend
-  assertEqual(time(3)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(3)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
@@ -118,12 +118,12 @@ unittest(historyBuffer_withReads) {
   sendSignal(rssiNodePtr, nano, 80);
   assertEqual(80, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   // large extremum nadir
   sendSignal(rssiNodePtr, nano, 20);
   assertEqual(20, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   history.peakSend->removeFirst();
 
@@ -131,7 +131,7 @@ unittest(historyBuffer_withReads) {
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
 
   history.nadirSend->removeFirst();
 
@@ -139,7 +139,7 @@ unittest(historyBuffer_withReads) {
   sendSignal(rssiNodePtr, nano, 40);
   assertEqual(40, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   history.peakSend->removeFirst();
 
@@ -0,0 +1,83 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+#include "../commands.h"
+
+uint8_t readDelta(Message& msg, uint8_t& gen)
+{
+  msg.command = READ_LAP_STATS_DELTA;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  gen = msg.buffer.read8();
+  return msg.buffer.read8();
+}
+
+unittest(lapStatsDelta)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+
+  Message msg;
+  uint8_t gen, lastGen;
+
+  // full read sets baseline, so delta read has no changes except loop time
+  msg.command = READ_LAP_PASS_STATS;
+  msg.handleReadCommand(false);
+  msg.command = READ_LAP_EXTREMUMS;
+  msg.handleReadCommand(false);
+  uint8_t mask = readDelta(msg, gen);
+  assertEqual(0, mask & ~LAPDELTA_LOOPTIME);
+  lastGen = gen;
+
+  mask = readDelta(msg, gen);
+  assertEqual(0, mask);
+  assertEqual(2 + 1, msg.buffer.size);  // generation, mask, checksum
+  assertEqual((uint8_t)(lastGen + 1), gen);
+
+  // small RSSI change is not sent
+  sendSignal(rssiNodePtr, nano, 51);
+  mask = readDelta(msg, gen);
+  assertEqual(0, mask & LAPDELTA_RSSI);
+
+  // enter crossing; RSSI, peak and crossing flag are sent
+  sendSignal(rssiNodePtr, nano, 130);
+  mask = readDelta(msg, gen);
+  assertTrue(mask & LAPDELTA_RSSI);
+  assertTrue(mask & LAPDELTA_PEAKS);
+  assertTrue(mask & LAPDELTA_FLAGS);
+  assertFalse(mask & LAPDELTA_LAP);
+  assertEqual(130, msg.buffer.read8());  // rssi
+  assertEqual(130, msg.buffer.read8());  // node peak
+  msg.buffer.read8();                    // last-pass peak
+  if (mask & LAPDELTA_NADIRS)
+  {
+    msg.buffer.read8();
+    msg.buffer.read8();
+  }
+  assertTrue(msg.buffer.read8() & LAPSTATS_FLAG_CROSSING);
+
+  // exit crossing; lap and pending extremum are sent
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+  mask = readDelta(msg, gen);
+  assertTrue(mask & LAPDELTA_LAP);
+  assertTrue(mask & LAPDELTA_EXTREMUM);
+  assertTrue(mask & LAPDELTA_FLAGS);
+  assertEqual(rssiNodePtr->getLastPass().lap, msg.buffer.read8());
+
+  // nothing left to send
+  readDelta(msg, gen);
+  mask = readDelta(msg, gen);
+  assertEqual(0, mask & ~LAPDELTA_LOOPTIME);
+}
+
+unittest_main()
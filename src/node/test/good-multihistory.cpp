@@ -50,25 +50,25 @@ unittest(historyBuffer_multi1_withoutReads) {
   sendSignal(rssiNodePtr, nano, 80);
   assertEqual(80, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   // large extremum nadir
   sendSignal(rssiNodePtr, nano, 20);
   assertEqual(20, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   // small extremum peak
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
   // overwrite
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   // small extremum nadir
   sendSignal(rssiNodePtr, nano, 40);
   assertEqual(40, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
   // overwrite
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
@@ -123,12 +123,12 @@ unittest(historyBuffer_multi1_withReads) {
   sendSignal(rssiNodePtr, nano, 80);
   assertEqual(80, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
   // large extremum nadir
   sendSignal(rssiNodePtr, nano, 20);
   assertEqual(20, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   history.peakSend->removeFirst();
 
@@ -136,7 +136,7 @@ unittest(historyBuffer_multi1_withReads) {
   sendSignal(rssiNodePtr, nano, 60);
   assertEqual(60, (int)history.peak.rssi);
   assertEqual(80, (int)history.peakSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.peakSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.peakSend->first().duration);
 
   history.nadirSend->removeFirst();
 
@@ -144,7 +144,7 @@ unittest(historyBuffer_multi1_withReads) {
   sendSignal(rssiNodePtr, nano, 40);
   assertEqual(40, (int)history.nadir.rssi);
   assertEqual(20, (int)history.nadirSend->first().rssi);
-  assertEqual(time(1)-1, (int)history.nadirSend->first().duration);
+  assertEqual(time(1)-TICK_MICROS, (int)history.nadirSend->first().duration);
 
   history.peakSend->removeFirst();
 
@@ -0,0 +1,101 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+static void addBlocks(NoiseFloorTracker<8>& t, int blocks, int base, bool exclude)
+{
+  for (int b = 0; b < blocks; ++b)
+  {
+    for (int i = 0; i < 10; ++i)
+    {
+      int v = base + (i % 3) * 2;
+      if (i == 5)
+        v += 40;  // short spike (fly-by) does not affect block minimum
+      t.add((rssi_t)v, exclude, 10);
+    }
+  }
+}
+
+unittest(noiseFloorTracker)
+{
+  NoiseFloorTracker<8> t;
+  addBlocks(t, 3, 50, false);
+  assertFalse(t.isValid());
+  addBlocks(t, 1, 50, false);
+  assertTrue(t.isValid());
+  assertEqual(50, t.getFloor());
+
+  // blocks during crossing are not used
+  addBlocks(t, 4, 90, true);
+  assertEqual(4, t.getBlockCount());
+  assertEqual(50, t.getFloor());
+
+  // one deep fade is ignored; floor follows sustained drift
+  addBlocks(t, 1, 20, false);
+  assertEqual(50, t.getFloor());
+  addBlocks(t, 6, 60, false);
+  assertEqual(60, t.getFloor());
+
+  t.clear();
+  assertFalse(t.isValid());
+  assertEqual(0, t.getBlockCount());
+}
+
+unittest(floatingThresholds)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setEnterAtLevel(96);
+  rssiNodePtr->setExitAtLevel(80);
+  struct State & state = rssiNodePtr->getState();
+  assertEqual(96, (int)state.enterAtEffective);
+  assertEqual(80, (int)state.exitAtEffective);
+
+  // fixed levels while floating is off
+  for (int i = 0; i < NOISE_FLOOR_BLOCKS * NOISE_FLOOR_BLOCK_SAMPLES; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), 50);
+    milliTick(nano);
+  }
+  assertTrue(rssiNodePtr->getNoiseFloor().isValid());
+  assertEqual(50, (int)rssiNodePtr->getNoiseFloor().getFloor());
+
+  rssiNodePtr->setThresholdFloatMax(10);
+  assertEqual(96, (int)state.enterAtEffective);
+
+  // floor rises; levels follow up to the max drift
+  for (int i = 0; i < NOISE_FLOOR_BLOCKS * NOISE_FLOOR_BLOCK_SAMPLES; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), 56);
+    milliTick(nano);
+  }
+  assertEqual(56, (int)rssiNodePtr->getNoiseFloor().getFloor());
+  assertEqual(102, (int)state.enterAtEffective);
+  assertEqual(86, (int)state.exitAtEffective);
+  assertEqual(96, (int)rssiNodePtr->getEnterAtLevel());
+
+  for (int i = 0; i < NOISE_FLOOR_BLOCKS * NOISE_FLOOR_BLOCK_SAMPLES; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), 75);
+    milliTick(nano);
+  }
+  assertEqual(106, (int)state.enterAtEffective);
+  assertEqual(90, (int)state.exitAtEffective);
+
+  // new level is relative to current floor
+  rssiNodePtr->setEnterAtLevel(110);
+  assertEqual(110, (int)state.enterAtEffective);
+  assertEqual(80, (int)state.exitAtEffective);
+
+  rssiNodePtr->setThresholdFloatMax(0);
+  rssiNodePtr->setEnterAtLevel(96);
+  assertEqual(96, (int)state.enterAtEffective);
+}
+
+unittest_main()
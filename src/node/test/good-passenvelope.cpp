@@ -0,0 +1,86 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+unittest(envelopeDecimation)
+{
+  PassEnvelopeStore<16, 2> store;
+  assertTrue(store.find(1) == NULL);
+
+  // 100-sample pass (1 ms apart) peaking at sample 40; lap timestamp at peak
+  for (int i = 0; i < 100; ++i)
+    store.add((rssi_t)(150 - abs(i - 40)), 1000000 + i * 1000, true);
+  assertTrue(store.isCapturing());
+  store.finish(7, 1000000 + 40 * 1000, 1000);
+  assertFalse(store.isCapturing());
+
+  const PassEnvelope<16> *e = store.find(7);
+  assertTrue(e != NULL);
+  assertEqual(13, e->pointCount);  // 100 samples at 8 per point (last point partial)
+  assertEqual(8, e->pointMs);
+  assertEqual(-40, e->startOffsetMs);
+  assertEqual(150, e->points[5]);  // samples 40-47
+  assertEqual(117, e->points[0]);  // max of samples 0-7
+  assertEqual(94, e->points[12]);  // partial point (samples 96-99)
+}
+
+unittest(envelopeAbortAndReplace)
+{
+  PassEnvelopeStore<16, 2> store;
+  for (int i = 0; i < 10; ++i)
+    store.add(100, i * 1000, true);
+  store.add(50, 10000, false);  // approach without crossing
+  assertFalse(store.isCapturing());
+  store.finish(1, 5000, 1000);
+  assertTrue(store.find(1) == NULL);
+
+  for (uint8_t lap = 1; lap <= 3; ++lap)
+  {
+    store.add(100, 0, true);
+    store.finish(lap, 0, 1000);
+  }
+  assertTrue(store.find(1) == NULL);  // oldest replaced
+  assertTrue(store.find(2) != NULL);
+  assertEqual(1, store.find(3)->pointCount);
+  assertEqual(1, store.find(3)->pointMs);
+}
+
+#if PASS_ENVELOPE_FLAG
+unittest(envelopeOnNodePass)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setEnterAtLevel(96);
+  rssiNodePtr->setExitAtLevel(80);
+  struct LastPass & lastPass = rssiNodePtr->getLastPass();
+
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 90);   // approach (within margin of EnterAt)
+  sendSignal(rssiNodePtr, nano, 130);  // crossing
+  sendSignal(rssiNodePtr, nano, 110);
+  sendSignal(rssiNodePtr, nano, 50);   // exit
+  assertFalse(rssiNodePtr->getState().crossing);
+
+  const PassEnvelope<PASS_ENVELOPE_POINTS> *e = rssiNodePtr->getPassEnvelopes().find(lastPass.lap);
+  assertTrue(e != NULL);
+  assertTrue(e->pointCount >= PASS_ENVELOPE_POINTS / 2 && e->pointCount <= PASS_ENVELOPE_POINTS);
+  assertTrue(e->startOffsetMs < 0);  // envelope starts before lap timestamp
+  rssi_t maxRssi = 0;
+  for (int i = 0; i < e->pointCount; ++i)
+    if (e->points[i] > maxRssi)
+      maxRssi = e->points[i];
+  assertEqual(130, maxRssi);
+  assertEqual(90, e->points[0]);
+  // envelope covers approach through exit
+  assertTrue((e->pointCount - 1) * e->pointMs + e->startOffsetMs > 0);
+}
+#endif
+
+unittest_main()
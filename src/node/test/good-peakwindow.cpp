@@ -0,0 +1,58 @@
+#include <ArduinoUnitTests.h>
+#include "../util/peak-window.h"
+
+static void addSamples(PeakWindow<16>& w, const rssi_t* values, int n)
+{
+  for (int i = 0; i < n; ++i)
+    w.add(10000 + i * 1000, values[i]);
+}
+
+unittest(peakWindowPlateau)
+{
+  PeakWindow<16> w;
+  static const rssi_t v[] = { 50, 50, 80, 90, 100, 100, 90, 80, 50, 50 };
+  addSamples(w, v, 10);
+  utime_t t = 0;
+  assertEqual(100, w.refine(8, t));
+  assertEqual(14500, t);
+}
+
+unittest(peakWindowSubSample)
+{
+  PeakWindow<16> w;
+  static const rssi_t v[] = { 50, 50, 85, 96, 100, 98, 94, 85, 50 };
+  addSamples(w, v, 9);
+  utime_t t = 0;
+  assertEqual(66, w.refine(8, t));  // two samples before peak, three after
+  assertEqual(14300, t);
+}
+
+unittest(peakWindowFreeze)
+{
+  PeakWindow<16> w;
+  w.add(9000, 60);
+  w.startPass();
+  static const rssi_t v[] = { 70, 100, 90, 80, 70, 60, 60, 60, 60, 60, 60, 60 };
+  addSamples(w, v, 12);
+  assertEqual(11, w.getCount());  // stopped after 8 samples past peak
+  w.add(30000, 50);
+  assertEqual(11, w.getCount());
+
+  // higher peak after window was frozen; earlier samples dropped
+  w.add(31000, 110);
+  assertEqual(1, w.getCount());
+  w.endPass();
+}
+
+unittest(peakWindowTruncated)
+{
+  PeakWindow<16> w;
+  static const rssi_t v[] = { 98, 99, 100, 90 };
+  addSamples(w, v, 4);
+  utime_t t = 0;
+  assertEqual(PEAK_FIT_QUALITY_NONE, w.refine(8, t));  // rise not in window
+  w.clear();
+  assertEqual(PEAK_FIT_QUALITY_NONE, w.refine(8, t));
+}
+
+unittest_main()
@@ -0,0 +1,201 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+NoFilter<rssi_t> rawFilter;  // noise reaches history unsmoothed
+
+struct ExtremumCounts
+{
+  int peaks;
+  int nadirs;
+  rssi_t maxPeak;
+  rssi_t minNadir;
+};
+
+// sends noisy background with two passes, reading history as the server would
+static ExtremumCounts runNoisySignal(GodmodeState* nano, rssi_t prominence)
+{
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&rawFilter);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->setHistoryProminence(prominence);
+  struct History & history = rssiNodePtr->getHistory();
+
+  ExtremumCounts counts = { 0, 0, 0, MAX_RSSI };
+  uint32_t seed = 1;
+  for (int i = 0; i < 3000; ++i)
+  {
+    seed = seed * 1103515245 + 12345;
+    const int noise = (int)((seed >> 16) % 4) - 1;  // spread less than prominence of 4
+    const int pass = (i >= 1000 && i < 1200) ? 100 - abs(i - 1100) :
+                     (i >= 2020 && i < 2180) ? 80 - abs(i - 2100) : 0;
+    rssiNodePtr->rssiProcessValue(micros(), (rssi_t)(50 + pass + noise));
+    milliTick(nano);
+    if (!history.peakSend->isEmpty())
+    {
+      ++counts.peaks;
+      if (history.peakSend->first().rssi > counts.maxPeak)
+        counts.maxPeak = history.peakSend->first().rssi;
+      history.peakSend->removeFirst();
+    }
+    if (!history.nadirSend->isEmpty())
+    {
+      ++counts.nadirs;
+      if (history.nadirSend->first().rssi < counts.minNadir)
+        counts.minNadir = history.nadirSend->first().rssi;
+      history.nadirSend->removeFirst();
+    }
+  }
+  return counts;
+}
+
+unittest(prominenceCutsNoise)
+{
+  GodmodeState* nano = GODMODE();
+  const ExtremumCounts every = runNoisySignal(nano, 1);
+  const ExtremumCounts filtered = runNoisySignal(nano, 4);
+
+  assertTrue(every.peaks >= 10 * filtered.peaks);
+  assertTrue(every.nadirs >= 10 * filtered.nadirs);
+  // pass peaks and background low between them are kept
+  assertEqual(2, filtered.peaks);
+  assertEqual(1, filtered.nadirs);
+  assertEqual(every.maxPeak, filtered.maxPeak);
+  assertTrue(filtered.maxPeak >= 145);
+  assertEqual(every.minNadir, filtered.minNadir);
+}
+
+unittest(prominencePlateauMerged)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->setHistoryProminence(4);
+  struct History & history = rssiNodePtr->getHistory();
+
+  sendSignal(rssiNodePtr, nano, 40);
+  sendSignal(rssiNodePtr, nano, 40);
+  history.peakSend->clear();
+  history.nadirSend->clear();
+  sendSignal(rssiNodePtr, nano, 80);
+  const utime_t firstTime = history.peak.firstTime;
+  sendSignal(rssiNodePtr, nano, 78);  // dip smaller than prominence
+  assertTrue(history.peakSend->isEmpty());
+  sendSignal(rssiNodePtr, nano, 80);  // back at peak value extends plateau
+  sendSignal(rssiNodePtr, nano, 40);
+  assertFalse(history.peakSend->isEmpty());
+  assertEqual(80, (int)history.peakSend->first().rssi);
+  assertEqual(firstTime, history.peakSend->first().firstTime);
+  assertEqual(time(3) - TICK_MICROS, history.peakSend->first().duration);
+}
+
+static void sendRaw(RssiNode *rssiNodePtr, GodmodeState* nano, rssi_t rssi, int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), rssi);
+    milliTick(nano);
+  }
+}
+
+unittest(prominencePassExtremumsKept)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&rawFilter);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->setEnterAtLevel(98);
+  rssiNodePtr->setExitAtLevel(96);
+  rssiNodePtr->setHistoryProminence(8);
+  struct History & history = rssiNodePtr->getHistory();
+
+  sendRaw(rssiNodePtr, nano, 40, 10);
+  sendRaw(rssiNodePtr, nano, 100, 10);
+  assertEqual(1, (int)rssiNodePtr->getState().crossing);
+  history.peakSend->clear();
+  history.nadirSend->clear();
+  sendRaw(rssiNodePtr, nano, 95, 10);
+  // pass end declares pass peak (fall to 95 is less than prominence)
+  assertEqual(0, (int)rssiNodePtr->getState().crossing);
+  assertFalse(history.peakSend->isEmpty());
+  assertEqual(100, (int)history.peakSend->first().rssi);
+  sendRaw(rssiNodePtr, nano, 93, 10);
+  assertTrue(history.nadirSend->isEmpty());
+  sendRaw(rssiNodePtr, nano, 99, 10);
+  // pass start declares low before pass (rise from 93 is less than prominence)
+  assertEqual(1, (int)rssiNodePtr->getState().crossing);
+  assertFalse(history.nadirSend->isEmpty());
+  assertEqual(93, (int)history.nadirSend->first().rssi);
+}
+
+// sends samples and takes each declared peak/nadir from the send buffers
+static void sendRawDrain(RssiNode *rssiNodePtr, GodmodeState* nano, rssi_t rssi, int count,
+                         ExtremumCounts &counts)
+{
+  struct History & history = rssiNodePtr->getHistory();
+  for (int i = 0; i < count; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), rssi);
+    milliTick(nano);
+    if (!history.peakSend->isEmpty())
+    {
+      ++counts.peaks;
+      counts.maxPeak = history.peakSend->first().rssi;
+      history.peakSend->removeFirst();
+    }
+    if (!history.nadirSend->isEmpty())
+    {
+      ++counts.nadirs;
+      counts.minNadir = history.nadirSend->first().rssi;
+      history.nadirSend->removeFirst();
+    }
+  }
+}
+
+unittest(prominenceOnePlateauNotReversal)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->rssiSetFilter(&rawFilter);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->setHistoryProminence(1);
+
+  ExtremumCounts counts = { 0, 0, 0, MAX_RSSI };
+  sendRawDrain(rssiNodePtr, nano, 40, 10, counts);
+  sendRawDrain(rssiNodePtr, nano, 50, 10, counts);
+  counts = { 0, 0, 0, MAX_RSSI };
+  // rise, flat, rise: plateau is part of the rise (no nadir, unlike the
+  //  stream before prominence was added)
+  sendRawDrain(rssiNodePtr, nano, 60, 10, counts);
+  assertEqual(0, counts.nadirs);
+  // fall, flat, fall: only the peak before the fall
+  sendRawDrain(rssiNodePtr, nano, 50, 10, counts);
+  sendRawDrain(rssiNodePtr, nano, 40, 10, counts);
+  assertEqual(1, counts.peaks);
+  assertEqual(60, counts.maxPeak);
+  assertEqual(0, counts.nadirs);
+  // rise declares the low of the fall
+  sendRawDrain(rssiNodePtr, nano, 45, 10, counts);
+  assertEqual(1, counts.nadirs);
+  assertEqual(40, counts.minNadir);
+  assertEqual(1, counts.peaks);
+}
+
+unittest_main()
@@ -0,0 +1,91 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+/**
+ * Provisional pass raised when RSSI falls below pass peak, then amended,
+ * confirmed or retracted.
+ */
+unittest(provisionalPass) {
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  assertEqual(PROVISIONAL_PASS_DROP, (int)rssiNodePtr->getProvisionalDrop());
+
+  struct State & state = rssiNodePtr->getState();
+  struct LastPass & lastPass = rssiNodePtr->getLastPass();
+  struct ProvisionalPass & provisional = rssiNodePtr->getProvisionalPass();
+  const uint8_t lap = lastPass.lap;
+  const uint8_t revision = provisional.revision;
+
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+
+  // enter; nothing raised while at peak
+  sendSignal(rssiNodePtr, nano, 130);
+  assertTrue(state.crossing);
+  assertEqual(PROVISIONAL_NONE, (int)provisional.status);
+
+  // fall below peak, but still above ExitAt
+  sendSignal(rssiNodePtr, nano, 110);
+  assertTrue(state.crossing);
+  assertEqual(PROVISIONAL_PENDING, (int)provisional.status);
+  assertEqual(lap + 1, (int)provisional.lap);
+  assertEqual(130, (int)provisional.rssiPeak);
+  assertEqual(timestamp(3) + (time(1) - TICK_MICROS) / 2, provisional.timestamp);
+  assertEqual(revision + 1, (int)provisional.revision);
+  assertEqual(lap, (int)lastPass.lap);
+
+  // higher peak amends provisional pass
+  sendSignal(rssiNodePtr, nano, 140);
+  assertEqual(revision + 1, (int)provisional.revision);
+  sendSignal(rssiNodePtr, nano, 120);
+  assertEqual(PROVISIONAL_PENDING, (int)provisional.status);
+  assertEqual(140, (int)provisional.rssiPeak);
+  assertEqual(timestamp(5) + (time(1) - TICK_MICROS) / 2, provisional.timestamp);
+  assertEqual(revision + 2, (int)provisional.revision);
+
+  // exit confirms with final lap timestamp
+  sendSignal(rssiNodePtr, nano, 50);
+  assertFalse(state.crossing);
+  assertEqual(lap + 1, (int)lastPass.lap);
+  assertEqual(PROVISIONAL_CONFIRMED, (int)provisional.status);
+  assertEqual(lastPass.timestamp, provisional.timestamp);
+  assertEqual(revision + 3, (int)provisional.revision);
+
+  // crossing discarded before exit
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 100);
+  assertEqual(PROVISIONAL_PENDING, (int)provisional.status);
+  assertEqual(lap + 2, (int)provisional.lap);
+  rssiNodePtr->rssiStateReset();
+  assertEqual(PROVISIONAL_RETRACTED, (int)provisional.status);
+  assertEqual(revision + 5, (int)provisional.revision);
+  assertEqual(lap + 1, (int)lastPass.lap);
+}
+
+unittest(provisionalPassDisabled) {
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiStateReset();
+  rssiNodePtr->setProvisionalDrop(0);
+  struct ProvisionalPass & provisional = rssiNodePtr->getProvisionalPass();
+  const uint8_t revision = provisional.revision;
+
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 90);
+  sendSignal(rssiNodePtr, nano, 50);
+  assertEqual(revision, (int)provisional.revision);
+  rssiNodePtr->setProvisionalDrop(PROVISIONAL_PASS_DROP);
+}
+
+unittest_main()
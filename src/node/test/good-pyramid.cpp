@@ -0,0 +1,70 @@
+#include <ArduinoUnitTests.h>
+#include "../util/rssi-pyramid.h"
+
+unittest(pyramidCascade)
+{
+  RssiPyramid<3, 8, 10> p;
+  assertEqual(0, p.getCount(0));
+  assertEqual(1, p.getScale(0));
+  assertEqual(100, p.getScale(2));
+
+  // 250 samples: ramp 0..99 repeated, time 1000 micros apart
+  for (int i = 0; i < 250; ++i)
+    p.add((rssi_t)(i % 100), (utime_t)(i + 1) * 1000, 1);
+  assertEqual(8, p.getCount(0));   // ring full
+  assertEqual(8, p.getCount(1));   // 25 entries completed, ring holds 8
+  assertEqual(2, p.getCount(2));
+  assertEqual(250000, p.getLastMicros(0));
+  assertEqual(250000, p.getLastMicros(1));
+  assertEqual(200000, p.getLastMicros(2));
+
+  assertEqual(49, p.getEntry(0, 0).maxRssi);  // newest sample (249 % 100)
+  assertEqual(42, p.getEntry(0, 7).minRssi);
+
+  const PyramidEntry &e1 = p.getEntry(1, 0);  // samples 240-249
+  assertEqual(49, e1.maxRssi);
+  assertEqual(40, e1.minRssi);
+  assertEqual(45, e1.meanRssi);  // 44.5 rounded up
+
+  const PyramidEntry &e2 = p.getEntry(2, 1);  // samples 0-99
+  assertEqual(99, e2.maxRssi);
+  assertEqual(0, e2.minRssi);
+  assertEqual(50, e2.meanRssi);  // mean of 10 rounded block means
+
+  p.clear();
+  assertEqual(0, p.getCount(0));
+  assertEqual(0, p.getCount(2));
+}
+
+// each tier's entry matches brute-force aggregates over the samples it covers
+unittest(pyramidMatchesBruteForce)
+{
+  RssiPyramid<3, 8, 10> p;
+  static rssi_t values[1000];
+  for (int i = 0; i < 1000; ++i)
+  {
+    values[i] = (rssi_t)(100 + (i * 37) % 61 - (i % 50 < 5 ? 40 : 0));
+    p.add(values[i], (utime_t)i * 1000, 2);
+  }
+  const int samplesPerEntry[3] = { 2, 20, 200 };
+  for (int t = 0; t < 3; ++t)
+  {
+    for (int k = 0; k < p.getCount(t); ++k)
+    {
+      int end = 1000 - k * samplesPerEntry[t];
+      rssi_t hi = 0, lo = MAX_RSSI;
+      for (int j = end - samplesPerEntry[t]; j < end; ++j)
+      {
+        if (values[j] > hi)
+          hi = values[j];
+        if (values[j] < lo)
+          lo = values[j];
+      }
+      assertEqual(hi, p.getEntry(t, k).maxRssi);
+      assertEqual(lo, p.getEntry(t, k).minRssi);
+      assertTrue(p.getEntry(t, k).meanRssi >= lo && p.getEntry(t, k).meanRssi <= hi);
+    }
+  }
+}
+
+unittest_main()
@@ -0,0 +1,123 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+#include "../commands.h"
+
+static void writeRaceEpoch(Message& msg, uint32_t startServerMs, uint32_t sendServerMs, uint8_t epochId)
+{
+  msg.command = WRITE_RACE_EPOCH;
+  msg.buffer.flipForWrite();
+  msg.buffer.write32(startServerMs);
+  msg.buffer.write32(sendServerMs);
+  msg.buffer.write8(epochId);
+  msg.handleWriteCommand(false);
+}
+
+static int64_t readEpochOffsetMicros(Message& msg, uint8_t& epochId)
+{
+  msg.command = READ_LAP_EPOCH_OFFSET;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  msg.buffer.read8();  // lap
+  epochId = msg.buffer.read8();
+  int32_t offsetMs = (int32_t)msg.buffer.read32();
+  uint16_t offsetMicros = msg.buffer.read16();
+  return (int64_t)offsetMs * 1000 + offsetMicros;
+}
+
+unittest(raceEpochNotSet)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+
+  Message msg;
+  msg.command = READ_LAP_EPOCH_OFFSET;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  msg.buffer.read8();
+  assertEqual(RACE_EPOCH_ID_NONE, msg.buffer.read8());
+  assertEqual((uint32_t)RACE_EPOCH_OFFSET_NONE, msg.buffer.read32());
+}
+
+unittest(raceEpochOffset)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  sendSignal(rssiNodePtr, nano, 50);
+
+  // race starts 3 seconds after command is sent (clocks not synchronized)
+  Message msg;
+  writeRaceEpoch(msg, 503000, 500000, 7);
+  utime_t epochMicros = micros() + 3000000;
+
+  nano->micros += 10000000;
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+  utime_t lapMicros = rssiNodePtr->getLastPass().timestamp;
+  assertMore(rssiNodePtr->getLastPass().lap, 0);
+
+  uint8_t epochId;
+  int64_t offsetMicros = readEpochOffsetMicros(msg, epochId);
+  assertEqual(7, epochId);
+  assertEqual((int64_t)(lapMicros - epochMicros), offsetMicros);
+}
+
+unittest(raceEpochBeforeStart)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  nano->micros = 20000000;
+
+  // last pass is before race start; offset is negative
+  Message msg;
+  writeRaceEpoch(msg, 1000000, 990000, 1);
+  utime_t epochMicros = micros() + 10000000;
+  utime_t lapMicros = RssiNode::rssiNodeArray[0].getLastPass().timestamp;
+  uint8_t epochId;
+  int64_t offsetMicros = readEpochOffsetMicros(msg, epochId);
+  assertEqual(1, epochId);
+  assertEqual(-(int64_t)(epochMicros - lapMicros), offsetMicros);
+}
+
+unittest(raceEpochMicrosWrap)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+
+  // micros wraps during race
+  nano->micros = 0xFFFFFFFF - 5000000;
+  sendSignal(rssiNodePtr, nano, 50);
+  Message msg;
+  writeRaceEpoch(msg, 1000, 1000, 2);
+  utime_t epochMicros = micros();
+
+  nano->micros += 10000000;
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 130);
+  sendSignal(rssiNodePtr, nano, 50);
+  sendSignal(rssiNodePtr, nano, 50);
+  utime_t lapMicros = rssiNodePtr->getLastPass().timestamp;
+
+  uint8_t epochId;
+  int64_t offsetMicros = readEpochOffsetMicros(msg, epochId);
+  assertEqual(2, epochId);
+  assertEqual((int64_t)(utime_t)(lapMicros - epochMicros), offsetMicros);
+}
+
+unittest_main()
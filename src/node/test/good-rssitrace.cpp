@@ -0,0 +1,136 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+
+// decodes packet data into 'out'; returns number of samples
+static int decodeTrace(const uint8_t *data, int len, rssi_t *out)
+{
+  int n = 0;
+  if (len <= 0)
+    return 0;
+  out[n++] = data[0];
+  for (int i = 1; i < len; ++i)
+  {
+    const uint8_t b = data[i];
+    const rssi_t prev = out[n - 1];
+    if (b < TRACE_CODE_RUN)
+      out[n++] = (rssi_t)(prev + b - TRACE_DELTA_BIAS);
+    else if (b < TRACE_CODE_ABS)
+    {
+      for (int r = 0; r <= (b & 0x3F); ++r)
+        out[n++] = prev;
+    }
+    else
+      out[n++] = data[++i];
+  }
+  return n;
+}
+
+unittest(traceRoundTrip)
+{
+  RssiTrace<256> t;
+  static rssi_t values[200];
+  for (int i = 0; i < 200; ++i)
+  {  // steady stretches, small steps and large jumps
+    values[i] = (rssi_t)((i < 80) ? 50 : (i < 150) ? 50 + (i - 80) * 2 : ((i % 2) ? 200 : 20));
+    t.add(values[i]);
+  }
+  assertEqual(200, t.getCount());
+
+  uint8_t data[57];
+  rssi_t out[256];
+  int total = 0;
+  uint16_t expectSeq = 0;
+  while (t.getCount() > 0)
+  {
+    assertEqual(expectSeq, t.getSeq());
+    uint8_t count;
+    uint8_t len = t.encode(data, sizeof(data), count);
+    assertTrue(len <= sizeof(data));
+    assertEqual(count, decodeTrace(data, len, out));
+    for (int i = 0; i < count; ++i)
+      assertEqual(values[total + i], out[i]);
+    total += count;
+    expectSeq += count;
+  }
+  assertEqual(200, total);
+  assertFalse(t.takeOverflow());
+}
+
+unittest(traceSteadyIsCompact)
+{
+  RssiTrace<256> t;
+  for (int i = 0; i < 200; ++i)
+    t.add(60);
+  uint8_t data[24];  // Arduino packet data size
+  uint8_t count;
+  assertEqual(5, t.encode(data, sizeof(data), count));  // value, then runs of 64, 64, 64, 7
+  assertEqual(200, count);
+  assertEqual(0, t.getCount());
+}
+
+unittest(traceOverflow)
+{
+  RssiTrace<16> t;
+  for (int i = 0; i < 20; ++i)
+    t.add((rssi_t)i);
+  assertEqual(16, t.getCount());
+  assertEqual(4, t.getSeq());  // oldest four dropped
+  assertTrue(t.takeOverflow());
+  assertFalse(t.takeOverflow());
+  uint8_t data[8];
+  uint8_t count;
+  assertEqual(8, t.encode(data, sizeof(data), count));
+  assertEqual(8, count);
+  assertEqual(4, data[0]);
+  assertEqual(12, t.getSeq());
+}
+
+#if RSSI_TRACE_FLAG
+unittest(traceModeOnNode)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  rssiNodePtr->rssiStateReset();
+  RssiTrace<RSSI_TRACE_SIZE> &trace = rssiNodePtr->getRssiTrace();
+
+  rssiNodePtr->setTraceMode(RSSI_TRACE_OFF);
+  sendSignal(rssiNodePtr, nano, 40);
+  assertEqual(0, trace.getCount());
+
+  rssiNodePtr->setTraceMode(RSSI_TRACE_RAW);
+  for (int i = 0; i < 10; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), (rssi_t)(40 + i));
+    milliTick(nano);
+  }
+  assertEqual(10, trace.getCount());
+  uint8_t data[16];
+  uint8_t count;
+  trace.encode(data, sizeof(data), count);
+  assertEqual(10, count);
+  assertEqual(40, data[0]);
+  assertEqual(TRACE_DELTA_BIAS + 1, data[1]);
+
+  sendSignal(rssiNodePtr, nano, 40);  // filter is filled
+  rssiNodePtr->setTraceMode(RSSI_TRACE_FILTERED);
+  assertEqual(0, trace.getSeq());
+  for (int i = 0; i < 20; ++i)
+  {
+    rssiNodePtr->rssiProcessValue(micros(), 40);
+    milliTick(nano);
+  }
+  assertEqual(20, trace.getCount());
+
+  rssiNodePtr->setTraceMode(7);  // invalid value turns trace off
+  assertEqual(RSSI_TRACE_OFF, rssiNodePtr->getTraceMode());
+  assertEqual(0, trace.getCount());
+}
+#endif
+
+unittest_main()
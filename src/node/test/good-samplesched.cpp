@@ -0,0 +1,278 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "util.h"
+#include "../util/sample-scheduler.h"
+#include "../util/sample-fifo.h"
+#include "../commands.h"
+
+unittest(sampleSchedulerPhases)
+{
+  SampleScheduler<4> sched;
+  assertEqual(250, sched.init(4, 1000));
+
+  // ticks visit slots in order; jitter is deviation of each slot's sample interval
+  utime_t t = 10000;
+  for (int i = 0; i < 12; ++i)
+  {
+    utime_t late = (i == 6) ? 30 : 0;  // one late tick for slot 2
+    assertEqual(i % 4, sched.timerTick(t + late));
+    assertEqual((i + 1) % 4, sched.getNextSlot());
+    t += 250;
+  }
+  SampleSlotStats stats = sched.readStats(2);
+  assertEqual(30, stats.jitterMax);  // late, then early by same amount
+  assertEqual(0, sched.readStats(1).jitterMax);
+  assertEqual(0, sched.readStats(2).jitterMax);  // max cleared by read
+}
+
+unittest(sampleSchedulerRotation)
+{
+  SampleScheduler<8, 4> sched;
+  assertEqual(125, sched.init(8, 1000));
+  assertEqual(1, sched.getOversampleCount());
+
+  // three of eight slots active; each sampled twice per period
+  for (uint8_t i = 0; i < 8; ++i)
+    sched.setSlotActive(i, (i == 1 || i == 4 || i == 6));
+  assertFalse(sched.setSlotActive(4, true));  // unchanged
+  assertEqual(166, sched.updateRotation());
+  assertEqual(3, sched.getActiveCount());
+  assertEqual(2, sched.getOversampleCount());
+  assertEqual(2008, sched.getSlotRateHz(4));
+  assertEqual(0, sched.getSlotRateHz(0));
+
+  static const uint8_t expected[] = { 1, 4, 6 };
+  utime_t t = 5000;
+  for (int i = 0; i < 9; ++i)
+  {
+    assertEqual(expected[i % 3], sched.timerTick(t));
+    t += 166;
+  }
+  assertEqual(0, sched.readStats(4).jitterMax);
+
+  // one slot active; oversampling is limited
+  for (uint8_t i = 0; i < 8; ++i)
+    sched.setSlotActive(i, i == 6);
+  assertEqual(250, sched.updateRotation());
+  assertEqual(4, sched.getOversampleCount());
+
+  // no slots active
+  sched.setSlotActive(6, false);
+  assertEqual(0, sched.updateRotation());
+  assertEqual(SAMPLE_SLOT_NONE, sched.timerTick(t));
+  assertEqual(SAMPLE_SLOT_NONE, sched.getNextSlot());
+}
+
+unittest(sampleSchedulerBurst)
+{
+  SampleScheduler<8, 4> sched;
+  sched.init(8, 1000);
+  for (uint8_t i = 2; i < 8; ++i)
+    sched.setSlotActive(i, false);
+  assertEqual(125, sched.updateRotation());
+  assertEqual(4, sched.getOversampleCount());
+
+  // slot 1 idle: sampled only on first round of each period
+  sched.setSlotBurst(1, false);
+  assertEqual(4, sched.getSlotOversample(0));
+  assertEqual(1, sched.getSlotOversample(1));
+  assertEqual(4000, sched.getSlotRateHz(0));
+  assertEqual(1000, sched.getSlotRateHz(1));
+
+  static const uint8_t expected[] = { 0, 1, 0, SAMPLE_SLOT_NONE, 0, SAMPLE_SLOT_NONE, 0, SAMPLE_SLOT_NONE };
+  utime_t t = 5000;
+  for (int i = 0; i < 24; ++i)
+  {
+    assertEqual(expected[i % 8], sched.timerTick(t));
+    t += 125;
+  }
+  assertEqual(0, sched.readStats(0).jitterMax);
+  assertEqual(0, sched.readStats(1).jitterMax);  // expected interval is whole period
+
+  // back to burst; change of interval not counted as jitter
+  sched.setSlotBurst(1, true);
+  for (int i = 0; i < 8; ++i)
+  {
+    assertEqual(i % 2, sched.timerTick(t));
+    t += 125;
+  }
+  assertEqual(0, sched.readStats(1).jitterMax);
+}
+
+unittest(sampleSchedulerProcessing)
+{
+  SampleScheduler<4> sched;
+  sched.init(4, 1000);
+  sched.recordProcessing(1, 300, 3);
+  SampleSlotStats stats = sched.readStats(1);
+  assertEqual(100, stats.processMax);
+  assertEqual(0, stats.overBudgetCount);
+  sched.recordProcessing(1, 800, 3);  // over 250 micros per sample
+  stats = sched.readStats(1);
+  assertEqual(266, stats.processMax);
+  assertEqual(1, stats.overBudgetCount);
+}
+
+unittest(sampleFifo)
+{
+  SampleFifo<4> fifo;
+  RssiSample s;
+  assertFalse(fifo.pop(s));
+  assertTrue(fifo.push(100, 1));
+  assertTrue(fifo.push(200, 2));
+  assertTrue(fifo.push(300, 3));
+  assertFalse(fifo.push(400, 4));  // full (holds N-1)
+  assertEqual(3, fifo.getHighWater());
+  assertEqual(1, fifo.getOverflowCount());
+  assertTrue(fifo.pop(s));
+  assertEqual(100, s.timeMicros);
+  assertEqual(1, s.rssi);
+  assertTrue(fifo.push(500, 5));
+  fifo.clearHighWater();
+  assertEqual(3, fifo.getHighWater());  // reset to current count
+  fifo.clear();
+  assertEqual(0, fifo.getCount());
+  assertFalse(fifo.pop(s));
+}
+
+unittest(sampleAcquireAndProcess)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->initRx5808Pins(0);
+  rssiNodePtr->rssiSetFilter(&testFilter);
+  rssiNodePtr->rssiInit();
+  rssiNodePtr->setActivatedFlag(true);
+  RssiNode::sampleScheduler.init(1, 1000);
+
+  // interrupt acquires samples; loop processes them later in batches
+  nano->analogPin[A0] = 200;
+  for (int b = 0; b < 30; ++b)
+  {
+    for (int i = 0; i < 10; ++i)
+    {
+      RssiNode::rssiNodeArray[RssiNode::sampleScheduler.timerTick(micros())].rssiAcquire(micros());
+      milliTick(nano);
+    }
+    assertEqual(10, rssiNodePtr->getSampleFifo().getCount());
+    assertEqual(10, rssiNodePtr->rssiProcessSamples());
+    assertEqual(0, rssiNodePtr->getSampleFifo().getCount());
+  }
+  assertEqual(100, rssiNodePtr->getState().rssi);
+  assertEqual(TICK_MICROS, rssiNodePtr->getState().loopTimeMicros);  // time between samples
+
+  // loop stalls; FIFO overflows
+  for (int i = 0; i < SAMPLE_FIFO_SIZE + 2; ++i)
+  {
+    RssiNode::rssiNodeArray[RssiNode::sampleScheduler.timerTick(micros())].rssiAcquire(micros());
+    milliTick(nano);
+  }
+
+  Message msg;
+  msg.command = READ_SAMPLE_STATS;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  assertEqual(0, msg.buffer.read16());  // jitter max
+  msg.buffer.read16();                  // jitter avg
+  msg.buffer.read16();                  // process max
+  assertEqual(0, msg.buffer.read16());  // over budget
+  assertEqual(SAMPLE_FIFO_SIZE - 1, msg.buffer.read8());  // FIFO high-water mark
+  assertEqual(3, msg.buffer.read16());  // FIFO overflows
+  assertEqual(0, msg.buffer.read32());  // missed samples (gap not yet processed)
+
+  // processing the queued samples finds the gap left by the overflow
+  assertEqual(SAMPLE_FIFO_SIZE - 1, rssiNodePtr->rssiProcessSamples());
+  RssiNode::rssiNodeArray[RssiNode::sampleScheduler.timerTick(micros())].rssiAcquire(micros());
+  assertEqual(1, rssiNodePtr->rssiProcessSamples());
+  SampleGapStats &gapStats = rssiNodePtr->getSampleGapStats();
+  assertEqual(3, gapStats.missedCount);
+  assertEqual(1, gapStats.gapCount);
+  assertEqual(3, gapStats.maxGapSamples);
+  assertEqual(TICK_MICROS, rssiNodePtr->getState().loopTimeMicros);  // gap filled at sample period
+}
+
+unittest(sampleOversampling)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->initRx5808Pins(0);
+  rssiNodePtr->restartSampling();
+  SampleFifo<SAMPLE_FIFO_SIZE> &fifo = rssiNodePtr->getSampleFifo();
+  fifo.clear();
+
+  // four readings averaged into one sample, timed at middle of readings
+  static const int raw[] = { 200, 202, 210, 212 };
+  for (int i = 0; i < 4; ++i)
+  {
+    nano->analogPin[A0] = raw[i];
+    rssiNodePtr->rssiAcquire(10000 + i * 250, 4);
+    assertEqual(i < 3 ? 0 : 1, fifo.getCount());
+  }
+  RssiSample sample;
+  assertTrue(fifo.pop(sample));
+  assertEqual(10375, sample.timeMicros);
+  assertEqual(103, sample.rssi);
+  assertEqual(SAMPLE_FLAG_RESYNC, sample.flags);
+}
+
+unittest(sampleRateCommand)
+{
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode::sampleScheduler.init(1, 1000);
+
+  Message msg;
+  msg.command = READ_SAMPLE_RATE;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  assertEqual(1000, msg.buffer.read16());
+  assertEqual(1, msg.buffer.read8());
+  assertEqual(1, msg.buffer.read8());
+  assertEqual(1, msg.buffer.read8());  // burst (not adaptive on single-node build)
+}
+
+unittest(sampleGapFill)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+
+  RssiNode::multiRssiNodeCount = 1;
+  RssiNode *rssiNodePtr = &(RssiNode::rssiNodeArray[0]);
+  rssiNodePtr->rssiInit();
+  SampleGapStats &gapStats = rssiNodePtr->getSampleGapStats();
+  gapStats = SampleGapStats();
+  SampleFifo<SAMPLE_FIFO_SIZE> &fifo = rssiNodePtr->getSampleFifo();
+  fifo.clear();
+
+  // first sample after init is a resync point; no gap counted
+  fifo.push(1000000, 50, SAMPLE_FLAG_RESYNC);
+  fifo.push(1001000, 50);
+  fifo.push(1004000, 80);  // two missed samples; filled as 60 and 70
+  rssiNodePtr->rssiProcessSamples();
+  assertEqual(2, gapStats.missedCount);
+  assertEqual(1, gapStats.gapCount);
+
+  // long gap is counted but not filled
+  fifo.push(1004000 + (SAMPLE_GAP_FILL_MAX + 3) * 1000UL, 80);
+  rssiNodePtr->rssiProcessSamples();
+  assertEqual(2 + SAMPLE_GAP_FILL_MAX + 2, gapStats.missedCount);
+  assertEqual(SAMPLE_GAP_FILL_MAX + 2, gapStats.maxGapSamples);
+  assertEqual((SAMPLE_GAP_FILL_MAX + 3) * 1000UL, rssiNodePtr->getState().loopTimeMicros);
+
+  // gap after a pause for tuning is expected
+  fifo.push(1100000, 80, SAMPLE_FLAG_RESYNC);
+  rssiNodePtr->rssiProcessSamples();
+  assertEqual(2, gapStats.gapCount);
+
+  Message msg;
+  msg.command = READ_SAMPLE_STATS;
+  msg.handleReadCommand(false);
+  assertEqual(21 + 1, msg.buffer.size);  // includes checksum
+}
+
+unittest_main()
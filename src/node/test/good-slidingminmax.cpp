@@ -0,0 +1,42 @@
+#include <ArduinoUnitTests.h>
+#include "../util/sliding-minmax.h"
+
+#define BLOCK 4
+
+unittest(slidingMinMaxEmpty)
+{
+  SlidingMinMax<8> w;
+  assertEqual(0, w.getMax());
+  assertEqual(MAX_RSSI, w.getMin());
+  w.add(70, BLOCK);  // partial block counts
+  assertEqual(70, w.getMax());
+  assertEqual(70, w.getMin());
+  w.clear();
+  assertEqual(0, w.getMax());
+}
+
+// compares against brute-force extremes over the same window
+unittest(slidingMinMaxMatchesBruteForce)
+{
+  SlidingMinMax<8> w;
+  static rssi_t values[2000];  // more than 256 blocks (sequence numbers wrap)
+  for (int i = 0; i < 2000; ++i)
+  {
+    values[i] = (rssi_t)(100 + (i * 37) % 61 - (i % 50 < 5 ? 40 : 0) + (i % 97 < 3 ? 60 : 0));
+    w.add(values[i], BLOCK);
+    // window is 7 complete blocks plus the block in progress (empty if one just completed)
+    int start = (((i + 1) % BLOCK == 0) ? (i + 1) / BLOCK - 7 : i / BLOCK - 7) * BLOCK;
+    rssi_t hi = 0, lo = MAX_RSSI;
+    for (int j = (start > 0 ? start : 0); j <= i; ++j)
+    {
+      if (values[j] > hi)
+        hi = values[j];
+      if (values[j] < lo)
+        lo = values[j];
+    }
+    assertEqual(hi, w.getMax());
+    assertEqual(lo, w.getMin());
+  }
+}
+
+unittest_main()
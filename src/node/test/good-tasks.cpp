@@ -0,0 +1,121 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "../util/task-scheduler.h"
+#include "../RssiNode.h"
+#include "../commands.h"
+
+static mtime_t lastFastMs, lastSlowMs;
+static int fastCount, slowCount;
+
+static void fastTask(mtime_t timeMs) { lastFastMs = timeMs; ++fastCount; }
+static void slowTask(mtime_t timeMs) { lastSlowMs = timeMs; ++slowCount; }
+
+static void runPass(TaskScheduler<4>& sched, mtime_t nowMs)
+{
+  int8_t idx = sched.getDueTask(nowMs);
+  if (idx >= 0)
+    sched.runTask(idx, nowMs);
+}
+
+unittest(taskSchedulerPeriods)
+{
+  TaskScheduler<4> sched;
+  assertEqual(0, sched.addTask(7, NULL, 0, 0));  // accounting-only entry
+  assertEqual(1, sched.addTask(8, fastTask, 1, 1));
+  assertEqual(2, sched.addTask(9, slowTask, 20, 2));
+  fastCount = slowCount = 0;
+
+  // one task per pass; higher priority first
+  runPass(sched, 0);
+  assertEqual(1, fastCount);
+  assertEqual(0, slowCount);
+  runPass(sched, 0);
+  assertEqual(1, slowCount);
+  assertEqual(-1, sched.getDueTask(0));
+
+  for (mtime_t ms = 1; ms <= 45; ++ms)
+  {
+    runPass(sched, ms);
+    runPass(sched, ms);
+  }
+  assertEqual(46, fastCount);
+  assertEqual(3, slowCount);
+  assertEqual(40, lastSlowMs);
+
+  // late run is passed its scheduled time and missed runs are skipped
+  runPass(sched, 103);
+  runPass(sched, 103);
+  assertEqual(100, lastSlowMs);
+  assertEqual(4, slowCount);
+  for (mtime_t ms = 104; ms < 120; ++ms)
+    runPass(sched, ms);
+  assertEqual(4, slowCount);
+  runPass(sched, 120);
+  runPass(sched, 120);
+  assertEqual(5, slowCount);
+}
+
+unittest(taskSchedulerStats)
+{
+  TaskScheduler<4> sched;
+  sched.addTask(1, NULL, 0, 0);
+  sched.addTask(2, fastTask, 1, 1);
+  sched.clearStats(1000);
+  sched.addRunTime(0, 200);
+  sched.addRunTime(0, 300);
+  sched.addRunTime(1, 50);
+  assertEqual(500, sched.getSharePermille(0, 2000));
+  assertEqual(50, sched.getSharePermille(1, 2000));
+  assertEqual(300, sched.getStats(0).maxMicros);
+  assertEqual(2, sched.getStats(0).runCount);
+  sched.clearStats(2000);
+  assertEqual(0, sched.getSharePermille(0, 3000));
+}
+
+unittest(taskSchedulerShed)
+{
+  TaskScheduler<4> sched;
+  sched.addTask(1, fastTask, 1, 1);
+  sched.addTask(2, slowTask, 20, 3);
+  fastCount = slowCount = 0;
+
+  // overloaded: low-priority task skipped for current period, critical task still runs
+  assertEqual(1, sched.shedDueTasks(0, 2));
+  assertEqual(1, sched.getShedCount());
+  runPass(sched, 0);
+  assertEqual(1, fastCount);
+  assertEqual(-1, sched.getDueTask(0));
+  assertEqual(0, sched.shedDueTasks(1, 2));  // nothing due at or above threshold
+  for (mtime_t ms = 1; ms <= 20; ++ms)
+  {
+    runPass(sched, ms);
+    runPass(sched, ms);
+  }
+  assertEqual(1, slowCount);
+  assertEqual(20, lastSlowMs);
+  assertEqual(1, sched.getShedCount());
+}
+
+unittest(taskStatsCommand)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+  uint8_t idx = housekeepingTasks.addTask(TASK_ID_SETTINGS, fastTask, 1, 1);
+  housekeepingTasks.clearStats(micros());
+  housekeepingTasks.addRunTime(idx, 100);
+  nano->micros += 1000;
+
+  Message msg;
+  msg.command = READ_TASK_STATS;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  assertEqual(1, msg.buffer.read8());
+  assertEqual(TASK_ID_SETTINGS, msg.buffer.read8());
+  assertEqual(100, msg.buffer.read16());  // share (1/1000)
+  assertEqual(100, msg.buffer.read16());  // max micros
+  assertEqual(TASK_ID_NONE, msg.buffer.read8());
+  assertEqual(1 + HOUSEKEEPING_TASK_MAX * 5 + 1, msg.buffer.size);  // includes checksum
+}
+
+unittest_main()
@@ -0,0 +1,102 @@
+#include <ArduinoUnitTests.h>
+#include <Godmode.h>
+#include "../util/time-sync.h"
+#include "../RssiNode.h"
+#include "../commands.h"
+
+// server clock runs 500ppm fast and is 100000ms ahead of node at node time 0
+static uint32_t serverTime(mtime_t nodeMs)
+{
+  return 100000 + nodeMs + nodeMs / 2000;
+}
+
+// exchange with given one-way delays (ms); returns server receive time
+static uint32_t doExchange(TimeSync& ts, mtime_t nodeMs, uint32_t prevRecvMs,
+                           int reqDelay, int respDelay)
+{
+  ts.requestReceived(serverTime(nodeMs - reqDelay), prevRecvMs, nodeMs);
+  ts.responseSent(nodeMs + 1);
+  return serverTime(nodeMs + 1 + respDelay);
+}
+
+unittest(timeSyncEstimate)
+{
+  TimeSync ts;
+  assertFalse(ts.isSynced());
+  assertEqual(TIME_SYNC_BOUND_UNKNOWN, ts.getBoundMs(0));
+
+  static const int delays[] = { 3, 9, 2, 14, 2, 6, 3, 20, 2, 5, 4 };
+  uint32_t recvMs = 0;
+  mtime_t nodeMs = 1000;
+  for (unsigned i = 0; i < sizeof(delays) / sizeof(delays[0]); ++i)
+  {
+    recvMs = doExchange(ts, nodeMs, recvMs, delays[i], delays[(i + 3) % 11]);
+    nodeMs += 1000;
+  }
+  ts.requestReceived(serverTime(nodeMs), recvMs, nodeMs);
+
+  assertTrue(ts.isSynced());
+  assertEqual(TIME_SYNC_SAMPLES, ts.getSampleCount());
+  // skew within 150ppm of actual
+  assertMore(ts.getSkewPpm(), 350);
+  assertLess(ts.getSkewPpm(), 650);
+  // converted time within bound
+  mtime_t lapMs = nodeMs - 500;
+  int32_t err = (int32_t)(ts.toServerTime(lapMs) - serverTime(lapMs));
+  uint16_t bound = ts.getBoundMs(lapMs);
+  assertLess(bound, 6);
+  assertLessOrEqual(err, (int32_t)bound);
+  assertMoreOrEqual(err, -(int32_t)bound);
+}
+
+unittest(timeSyncLostResponse)
+{
+  TimeSync ts;
+  // previous response not received (receive time of zero); no sample taken
+  ts.requestReceived(5000, 0, 100);
+  ts.responseSent(101);
+  ts.requestReceived(6000, 0, 1100);
+  assertFalse(ts.isSynced());
+}
+
+unittest(timeSyncCommands)
+{
+  GodmodeState* nano = GODMODE();
+  nano->reset();
+  RssiNode::multiRssiNodeCount = 1;
+
+  Message msg;
+  uint32_t recvMs = 0;
+  for (int i = 0; i < 4; ++i)
+  {
+    nano->micros += 1000000;
+    msg.command = WRITE_TIME_SYNC;
+    msg.buffer.flipForWrite();
+    msg.buffer.write32(serverTime(millis() - 2));
+    msg.buffer.write32(recvMs);
+    assertEqual(msg.getPayloadSize(), msg.buffer.size);
+    msg.handleWriteCommand(false);
+
+    msg.command = READ_TIME_SYNC;
+    msg.handleReadCommand(false);
+    msg.buffer.flipForRead();
+    assertEqual(millis(), msg.buffer.read32());  // request receive time
+    assertEqual(millis(), msg.buffer.read32());  // response send time
+    recvMs = serverTime(millis() + 2);
+  }
+  assertTrue(timeSync.isSynced());
+
+  msg.command = READ_LAP_SYNC_TIME;
+  msg.handleReadCommand(false);
+  msg.buffer.flipForRead();
+  msg.buffer.read8();
+  utime_t sinceLapMicros = micros() - RssiNode::rssiNodeArray[0].getLastPass().timestamp;
+  mtime_t lapMs = millis() - sinceLapMicros / 1000;
+  int32_t err = (int32_t)(msg.buffer.read32() - serverTime(lapMs));
+  uint16_t bound = msg.buffer.read16();
+  assertLessOrEqual(err, (int32_t)bound);
+  assertMoreOrEqual(err, -(int32_t)bound);
+  assertEqual(sinceLapMicros % 1000, msg.buffer.read16());
+}
+
+unittest_main()
@@ -0,0 +1,60 @@
+#include <ArduinoUnitTests.h>
+#include "../util/zero-phase.h"
+
+#define BASE_MICROS 1000000UL
+
+// triangular peak centered half-way between samples 100 and 101, with
+//  optional noise; returns time of center
+static utime_t addPeak(ZeroPhaseWindow<256, 64>& w, int count, int noise)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    int d = (i < 101) ? (201 - 2 * i) : (2 * i - 201);  // 2 * distance from center
+    int v = 150 - d;
+    if (v < 50)
+      v = 50;
+    if (noise && (i % 3) == 0)
+      v += (i % 2) ? noise : -noise;
+    w.add(BASE_MICROS + i * 1000, (rssi_t)v);
+  }
+  return BASE_MICROS + 100500;
+}
+
+unittest(zeroPhaseSymmetricPeak)
+{
+  ZeroPhaseWindow<256, 64> w;
+  utime_t center = addPeak(w, 200, 0);
+  utime_t peak = 0;
+  // estimate from causal filter is off by a few samples
+  assertTrue(w.refinePeak(center + 3000, 1000, 3, peak));
+  assertLess(abs((int32_t)(peak - center)), 100);
+}
+
+unittest(zeroPhaseNoisyPeak)
+{
+  ZeroPhaseWindow<256, 64> w;
+  utime_t center = addPeak(w, 200, 6);
+  utime_t peak = 0;
+  assertTrue(w.refinePeak(center - 2000, 1000, 3, peak));
+  assertLess(abs((int32_t)(peak - center)), 400);
+}
+
+unittest(zeroPhaseWindowCoverage)
+{
+  ZeroPhaseWindow<256, 64> w;
+  utime_t center = addPeak(w, 150, 0);  // not enough samples after peak
+  utime_t peak = 0;
+  assertFalse(w.refinePeak(center, 1000, 3, peak));
+
+  // frozen window keeps samples around peak
+  w.clear();
+  center = addPeak(w, 170, 0);
+  w.freeze();
+  for (int i = 0; i < 100; ++i)
+    w.add(BASE_MICROS + (170 + i) * 1000, 50);
+  assertEqual(170, w.getCount());
+  assertTrue(w.refinePeak(center, 1000, 3, peak));
+  assertLess(abs((int32_t)(peak - center)), 100);
+}
+
+unittest_main()
@@ -6,24 +6,25 @@
 
 MedianFilter<rssi_t, SmoothingSamples, 0> testFilter;
 
-#define milliTick(nano) (nano->micros += 1000)
+#define TICK_MICROS 1000  // time between samples
+#define milliTick(nano) (nano->micros += TICK_MICROS)
 
 const static int N_2 = testFilter.getSampleCapacity()/2+1;
 const static int N_TS = testFilter.getTimestampCapacity();
 
 void sendSignal(RssiNode *rssiNodePtr, GodmodeState* nano, int rssi) {
   for(int t=0; t<N_2; t++) {
-    rssiNodePtr->rssiProcessValue(millis(), rssi);
+    rssiNodePtr->rssiProcessValue(micros(), rssi);
     milliTick(nano);
   }
 }
 
-mtime_t timestamp(int sendCount) {
-  return sendCount*N_2 - N_TS;
+utime_t timestamp(int sendCount) {
+  return (sendCount*N_2 - N_TS) * TICK_MICROS;
 }
 
-mtime_t time(int sendCount) {
-  return sendCount*N_2;
+utime_t time(int sendCount) {
+  return sendCount*N_2 * TICK_MICROS;
 }
 
 #endif  //TEST_UTIL_H
@@ -13,7 +13,7 @@ template <typename T> class CompositeFilter : public Filter<T>
             return f1.isFilled() && f2.isFilled();
         }
 
-        void addRawValue(mtime_t ts, T x)
+        void addRawValue(utime_t ts, T x)
         {
             f1.addRawValue(ts, x);
             if (f1.isFilled()) {
@@ -25,7 +25,7 @@ template <typename T> class CompositeFilter : public Filter<T>
             return f2.getFilteredValue();
         }
 
-        mtime_t getFilterTimestamp() {
+        utime_t getFilterTimestamp() {
           return f2.getFilterTimestamp();
         }
 };
@@ -0,0 +1,54 @@
+#ifndef crossingdetector_h
+#define crossingdetector_h
+
+#include "rhtypes.h"
+
+#define DETECT_NONE 0        // no change in crossing state
+#define DETECT_PASS_START 1  // crossing (lap pass) starts
+#define DETECT_PASS_END 2    // crossing ends
+
+/**
+ * Decides when crossings start and end from the filtered RSSI.
+ */
+class CrossingDetector
+{
+    public:
+        // Returns DETECT_... value for the next filtered sample ('crossing' is
+        //  true while a crossing is in progress)
+        virtual uint8_t update(rssi_t rssi, utime_t timeMicros, bool crossing) = 0;
+        // Gets time and peak RSSI of the pass that just ended, if the detector
+        //  determines them itself; returns false if the pass-peak plateau is used
+        virtual bool getPass(utime_t &timeMicros, rssi_t &rssiPeak, uint8_t &quality) = 0;
+        virtual void reset() = 0;
+};
+
+/**
+ * Crossing starts when RSSI reaches EnterAt and ends when it falls below ExitAt.
+ */
+class ThresholdDetector : public CrossingDetector
+{
+    private:
+        rssi_t enterAt = 96;
+        rssi_t exitAt = 80;
+
+    public:
+        void setLevels(rssi_t enterAtLevel, rssi_t exitAtLevel)
+        {
+            enterAt = enterAtLevel;
+            exitAt = exitAtLevel;
+        }
+
+        uint8_t update(rssi_t rssi, utime_t, bool crossing)
+        {
+            if (!crossing && rssi >= enterAt)
+                return DETECT_PASS_START;
+            if (crossing && rssi < exitAt)
+                return DETECT_PASS_END;
+            return DETECT_NONE;
+        }
+
+        bool getPass(utime_t &, rssi_t &, uint8_t &) { return false; }
+        void reset() {}
+};
+
+#endif
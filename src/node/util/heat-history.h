@@ -0,0 +1,298 @@
+#ifndef heathistory_h
+#define heathistory_h
+
+#include "rhtypes.h"
+
+// pass found by replaying history
+struct HistoryPass
+{
+    utime_t timestamp;  // micros (midpoint of pass-peak plateau)
+    rssi_t rssiPeak;
+};
+
+/**
+ * Retains the alternating peaks and nadirs of the filtered RSSI (reversals of
+ * at least 'hysteresis') so that crossings can be re-evaluated with other
+ * EnterAt/ExitAt levels.  Between extremums the RSSI is monotonic, so the
+ * extremums (with the first and last time at each value) are all that the
+ * crossing logic depends on.  Each extremum is stored as varint time since the
+ * previous one (ms), varint time at the value (ms) and the value, in a ring of
+ * 'Bytes' bytes; when full the oldest extremums are dropped.
+ */
+template <uint16_t Bytes> class HeatHistory
+{
+    private:
+        struct Extremum
+        {
+            rssi_t rssi;
+            uint32_t firstMs;  // ms since 'baseMicros'
+            uint32_t lastMs;
+        };
+
+        uint8_t data[Bytes];
+        uint16_t head = 0;         // next byte to write
+        uint16_t tail = 0;         // first byte of oldest entry
+        uint16_t used = 0;
+        uint32_t tailFirstMs = 0;  // time of oldest entry (its stored delta is not used)
+        bool tailIsPeak = false;
+        uint32_t lastFirstMs = 0;  // time of newest entry
+        uint16_t entryCount = 0;
+        bool truncatedFlag = false;
+
+        bool startedFlag = false;
+        utime_t baseMicros = 0;    // time of first sample
+        int8_t direction = 0;      // 1 = rising (candidate is peak), -1 = falling, 0 = unknown
+        Extremum candidate;        // extremum in progress
+        Extremum first;            // lowest and highest values before direction is known
+        Extremum firstHigh;
+
+        static uint8_t varintSize(uint32_t v)
+        {
+            uint8_t n = 1;
+            while (v >= 0x80)
+            {
+                v >>= 7;
+                ++n;
+            }
+            return n;
+        }
+
+        void putByte(uint8_t b)
+        {
+            data[head] = b;
+            head = (head + 1) % Bytes;
+            ++used;
+        }
+
+        void putVarint(uint32_t v)
+        {
+            while (v >= 0x80)
+            {
+                putByte((uint8_t)(v | 0x80));
+                v >>= 7;
+            }
+            putByte((uint8_t)v);
+        }
+
+        uint32_t getVarint(uint16_t &pos) const
+        {
+            uint32_t v = 0;
+            uint8_t shift = 0;
+            uint8_t b;
+            do
+            {
+                b = data[pos];
+                pos = (pos + 1) % Bytes;
+                v |= (uint32_t)(b & 0x7F) << shift;
+                shift += 7;
+            } while ((b & 0x80) && shift < 35);
+            return v;
+        }
+
+        // Decodes entry at 'pos' (advancing it); 'prevFirstMs' is time of previous entry
+        void getEntry(uint16_t &pos, uint32_t prevFirstMs, Extremum &e) const
+        {
+            e.firstMs = prevFirstMs + getVarint(pos);
+            e.lastMs = e.firstMs + getVarint(pos);
+            e.rssi = data[pos];
+            pos = (pos + 1) % Bytes;
+        }
+
+        void dropOldest()
+        {
+            uint16_t pos = tail;
+            Extremum e;
+            getEntry(pos, 0, e);
+            used -= (uint16_t)((pos + Bytes - tail) % Bytes);
+            tail = pos;
+            --entryCount;
+            tailIsPeak = !tailIsPeak;
+            if (entryCount > 0)
+            {  // time of new oldest entry is relative to the dropped one
+                uint16_t next = tail;
+                tailFirstMs += getVarint(next);
+            }
+            truncatedFlag = true;
+        }
+
+        void store(const Extremum &e, bool peakFlag)
+        {
+            const uint32_t dt = (entryCount > 0) ? e.firstMs - lastFirstMs : 0;
+            const uint32_t dur = e.lastMs - e.firstMs;
+            const uint16_t size = varintSize(dt) + varintSize(dur) + 1;
+            if (size > Bytes)
+                return;
+            while (Bytes - used < size)
+                dropOldest();
+            if (entryCount == 0)
+            {
+                tailFirstMs = e.firstMs;
+                tailIsPeak = peakFlag;
+            }
+            putVarint(dt);
+            putVarint(dur);
+            putByte(e.rssi);
+            lastFirstMs = e.firstMs;
+            ++entryCount;
+        }
+
+        static void setExtremum(Extremum &e, rssi_t rssi, uint32_t ms)
+        {
+            e.rssi = rssi;
+            e.firstMs = e.lastMs = ms;
+        }
+
+        // Applies crossing logic for one extremum (see 'RssiNode::rssiProcessValue()')
+        static void replayStep(const Extremum &e, bool peakFlag, rssi_t enterAt, rssi_t exitAt,
+                               bool &crossing, Extremum &passPeak, HistoryPass &pass, bool &passFlag)
+        {
+            passFlag = false;
+            if (peakFlag)
+            {
+                if (!crossing && e.rssi >= enterAt)
+                {
+                    crossing = true;
+                    passPeak.rssi = 0;
+                }
+                if (crossing)
+                {
+                    if (e.rssi > passPeak.rssi)
+                        passPeak = e;
+                    else if (e.rssi == passPeak.rssi)
+                        passPeak.lastMs = e.lastMs;  // plateau extends to latest time at peak value
+                }
+            }
+            else if (crossing && e.rssi < exitAt)
+            {
+                crossing = false;
+                pass.rssiPeak = passPeak.rssi;
+                pass.timestamp = (utime_t)passPeak.firstMs * 1000 +
+                                 (utime_t)(passPeak.lastMs - passPeak.firstMs) * 1000 / 2;
+                passFlag = true;
+            }
+        }
+
+    public:
+        void clear()
+        {
+            head = tail = used = 0;
+            entryCount = 0;
+            truncatedFlag = false;
+            startedFlag = false;
+            direction = 0;
+        }
+
+        // Adds filtered value; extremums are recorded once RSSI has reversed by 'hysteresis'
+        void add(rssi_t rssi, utime_t timeMicros, uint8_t hysteresis)
+        {
+            if (!startedFlag)
+            {
+                startedFlag = true;
+                baseMicros = timeMicros;
+                setExtremum(first, rssi, 0);
+                firstHigh = first;
+                return;
+            }
+            const uint32_t ms = (timeMicros - baseMicros) / 1000;
+            if (direction == 0)
+            {  // direction is known once values span 'hysteresis'
+                if (rssi < first.rssi)
+                    setExtremum(first, rssi, ms);
+                else if (rssi == first.rssi)
+                    first.lastMs = ms;
+                if (rssi > firstHigh.rssi)
+                    setExtremum(firstHigh, rssi, ms);
+                else if (rssi == firstHigh.rssi)
+                    firstHigh.lastMs = ms;
+                if ((int)firstHigh.rssi - (int)first.rssi < (int)hysteresis)
+                    return;
+                if (first.firstMs < firstHigh.firstMs)
+                {  // low came first, so it is a nadir and RSSI is rising
+                    store(first, false);
+                    candidate = firstHigh;
+                    direction = 1;
+                }
+                else
+                {
+                    store(firstHigh, true);
+                    candidate = first;
+                    direction = -1;
+                }
+                return;
+            }
+            if (rssi == candidate.rssi)
+                candidate.lastMs = ms;
+            else if ((direction > 0) ? (rssi > candidate.rssi) : (rssi < candidate.rssi))
+                setExtremum(candidate, rssi, ms);
+            else if (((direction > 0) ? (int)candidate.rssi - (int)rssi : (int)rssi - (int)candidate.rssi) >=
+                     (int)hysteresis)
+            {  // reversed, so candidate is complete
+                store(candidate, direction > 0);
+                setExtremum(candidate, rssi, ms);
+                direction = -direction;
+            }
+        }
+
+        uint16_t getEntryCount() { return entryCount; }
+        uint16_t getUsedBytes() { return used; }
+        bool isTruncated() { return truncatedFlag; }  // oldest extremums were dropped
+        bool isStarted() { return startedFlag; }
+
+        // Returns time of oldest retained extremum (or of first sample if none yet)
+        utime_t getStartMicros()
+        {
+            return baseMicros + (utime_t)((entryCount > 0) ? tailFirstMs : 0) * 1000;
+        }
+
+        // Replays history (including extremum in progress) through crossing logic with
+        //  given levels; passes from index 'skip' on are copied to 'passes' (up to
+        //  'maxPasses'); returns total number of passes found
+        uint16_t replay(rssi_t enterAt, rssi_t exitAt, uint16_t skip, HistoryPass *passes, uint8_t maxPasses)
+        {
+            uint16_t total = 0;
+            bool crossing = false;
+            Extremum passPeak;
+            passPeak.rssi = 0;
+            passPeak.firstMs = passPeak.lastMs = 0;
+            HistoryPass pass;
+            bool passFlag;
+            uint16_t pos = tail;
+            uint32_t prevFirstMs = 0;
+            bool peakFlag = tailIsPeak;
+            for (uint16_t i = 0; i <= entryCount; ++i)
+            {
+                Extremum e;
+                if (i < entryCount)
+                {
+                    getEntry(pos, prevFirstMs, e);
+                    if (i == 0)
+                    {
+                        e.lastMs = tailFirstMs + (e.lastMs - e.firstMs);
+                        e.firstMs = tailFirstMs;
+                    }
+                    prevFirstMs = e.firstMs;
+                }
+                else if (direction != 0)
+                {
+                    e = candidate;
+                    peakFlag = (direction > 0);
+                }
+                else
+                    break;
+                replayStep(e, peakFlag, enterAt, exitAt, crossing, passPeak, pass, passFlag);
+                if (passFlag)
+                {
+                    if (total >= skip && total - skip < maxPasses)
+                    {
+                        passes[total - skip].rssiPeak = pass.rssiPeak;
+                        passes[total - skip].timestamp = baseMicros + pass.timestamp;
+                    }
+                    ++total;
+                }
+                peakFlag = !peakFlag;
+            }
+            return total;
+        }
+};
+
+#endif
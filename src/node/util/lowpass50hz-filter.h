@@ -14,7 +14,7 @@ class LowPassFilter50Hz : public Filter<rssi_t>
     private:
         float v[3];
         rssi_t nextValue;
-        CircularBuffer<mtime_t,5> timestamps; // delay correct for pass-band
+        CircularBuffer<utime_t,5> timestamps; // delay correct for pass-band
     public:
         LowPassFilter50Hz()
         {
@@ -26,7 +26,7 @@ class LowPassFilter50Hz : public Filter<rssi_t>
             return timestamps.isFull();
         }
 
-        void addRawValue(mtime_t ts, rssi_t x)
+        void addRawValue(utime_t ts, rssi_t x)
         {
             v[0] = v[1];
             v[1] = v[2];
@@ -42,7 +42,7 @@ class LowPassFilter50Hz : public Filter<rssi_t>
             return nextValue;
         }
 
-        mtime_t getFilterTimestamp() {
+        utime_t getFilterTimestamp() {
             return timestamps.first();
         }
 };
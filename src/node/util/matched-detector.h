@@ -0,0 +1,275 @@
+#ifndef matcheddetector_h
+#define matcheddetector_h
+
+#include "rhtypes.h"
+#include "crossing-detector.h"
+
+#define MATCH_TEMPLATE_MAX 100  // template values are 0 (baseline) to this (pass peak)
+
+/**
+ * Crossing detector that correlates the filtered RSSI with a pass-shape
+ * template.  Samples are averaged into points of 'PointSamples' samples, and
+ * each time a point completes the last 'Taps' points are compared with the
+ * template using the normalized (zero-mean) correlation, in fixed point.  A
+ * crossing is in progress while the correlation (Q8) is at least 'minCorr'
+ * and the fitted amplitude (RSSI rise matching the full template range) is at
+ * least 'minRise'; the pass time is where the template peak fell at the
+ * correlation maximum.  The template may be written, or learned from the
+ * shape of detected passes.
+ */
+template <uint8_t Taps, uint8_t PointSamples> class MatchedFilterDetector : public CrossingDetector
+{
+    private:
+        uint8_t templ[Taps];
+        int32_t sumT = 0;            // sum of template values
+        int32_t stt = 0;             // Taps * sum(T^2) - sum(T)^2
+        uint8_t peakPos2 = 0;        // template position at pass time (half points)
+        uint8_t learnCount = 0;      // passes learned into template
+        uint8_t minCorr = 204;       // Q8 (0.8)
+        rssi_t minRise = 30;
+
+        rssi_t points[Taps];         // averaged samples (ring)
+        uint8_t head = 0;            // next point to write (oldest point when full)
+        uint8_t count = 0;
+        uint16_t pointSum = 0;       // samples in point in progress
+        uint8_t pointCount = 0;
+        utime_t pointStartMicros = 0;
+        utime_t lastPointMidMicros = 0;  // time of newest point
+        utime_t pointMicros = 0;         // time between points
+
+        uint8_t score = 0;           // correlation (Q8) for newest window
+        uint8_t prevScore = 0;       // correlation for window before newest
+        rssi_t amplitude = 0;        // fitted RSSI rise for newest window
+        rssi_t windowMax = 0;
+
+        bool bestValid = false;      // correlation maximum of crossing in progress
+        uint8_t bestScore = 0;
+        uint8_t bestBefore = 0;      // correlations of windows each side of maximum
+        int16_t bestAfter = -1;      //  (-1 until next window scored)
+        utime_t bestMicros = 0;
+        rssi_t bestPeak = 0;
+
+        static uint32_t isqrt(uint64_t v)
+        {
+            uint64_t res = 0;
+            uint64_t one = (uint64_t)1 << 62;
+            while (one > v)
+                one >>= 2;
+            while (one != 0)
+            {
+                if (v >= res + one)
+                {
+                    v -= res + one;
+                    res = (res >> 1) + one;
+                }
+                else
+                    res >>= 1;
+                one >>= 2;
+            }
+            return (uint32_t)res;
+        }
+
+        rssi_t getPoint(uint8_t i) { return points[(head + i) % Taps]; }  // oldest first (window full)
+
+        void updateTemplateSums()
+        {
+            int32_t sumTT = 0;
+            uint8_t first = 0, last = 0;
+            sumT = 0;
+            for (uint8_t i = 0; i < Taps; ++i)
+            {
+                sumT += templ[i];
+                sumTT += (int32_t)templ[i] * templ[i];
+                if (templ[i] > templ[first])
+                    first = last = i;
+                else if (templ[i] == templ[first] && last == i - 1)
+                    last = i;  // peak plateau
+            }
+            peakPos2 = first + last;
+            stt = (int32_t)Taps * sumTT - sumT * sumT;
+        }
+
+        void scoreWindow()
+        {
+            int32_t sumX = 0, sumXX = 0, sumXT = 0;
+            windowMax = 0;
+            for (uint8_t i = 0; i < Taps; ++i)
+            {
+                const rssi_t x = getPoint(i);
+                sumX += x;
+                sumXX += (int32_t)x * x;
+                sumXT += (int32_t)x * templ[i];
+                if (x > windowMax)
+                    windowMax = x;
+            }
+            const int32_t sxx = (int32_t)Taps * sumXX - sumX * sumX;
+            const int32_t num = (int32_t)Taps * sumXT - sumX * sumT;
+            if (num <= 0 || sxx <= 0 || stt <= 0)
+            {
+                score = 0;
+                amplitude = 0;
+                return;
+            }
+            const uint32_t root = isqrt((uint64_t)sxx * (uint64_t)stt);
+            const uint32_t corr = (uint32_t)(((uint64_t)num << 8) / root);
+            score = (corr < 0xFF) ? (uint8_t)corr : 0xFF;
+            const int32_t amp = (int32_t)((int64_t)num * MATCH_TEMPLATE_MAX / stt);
+            amplitude = (amp < MAX_RSSI) ? (rssi_t)amp : MAX_RSSI;
+        }
+
+        void setBest()
+        {
+            bestValid = true;
+            bestScore = score;
+            bestBefore = prevScore;
+            bestAfter = -1;
+            bestMicros = lastPointMidMicros - (utime_t)(2 * (Taps - 1) - peakPos2) * pointMicros / 2;
+            bestPeak = windowMax;
+        }
+
+    public:
+        MatchedFilterDetector()
+        {
+            setDefaultTemplate();
+        }
+
+        // Sets triangular template (peak in middle)
+        void setDefaultTemplate()
+        {
+            for (uint8_t i = 0; i < Taps; ++i)
+            {
+                const int d = 2 * (int)i - (Taps - 1);
+                templ[i] = (uint8_t)(MATCH_TEMPLATE_MAX - ((d < 0) ? -d : d) * MATCH_TEMPLATE_MAX / (Taps - 1));
+            }
+            learnCount = 0;
+            updateTemplateSums();
+        }
+
+        void setTemplatePoint(uint8_t idx, uint8_t val)
+        {
+            if (idx >= Taps)
+                return;
+            templ[idx] = (val < MATCH_TEMPLATE_MAX) ? val : MATCH_TEMPLATE_MAX;
+            updateTemplateSums();
+        }
+
+        void setLimits(uint8_t minCorrQ8, rssi_t minRiseRssi)
+        {
+            minCorr = minCorrQ8;
+            minRise = minRiseRssi;
+        }
+
+        uint8_t update(rssi_t rssi, utime_t timeMicros, bool crossing)
+        {
+            if (pointCount == 0)
+                pointStartMicros = timeMicros;
+            pointSum += rssi;
+            if (++pointCount < PointSamples)
+                return DETECT_NONE;
+            const utime_t midMicros = pointStartMicros + (timeMicros - pointStartMicros) / 2;
+            if (count > 0)
+                pointMicros = midMicros - lastPointMidMicros;
+            lastPointMidMicros = midMicros;
+            points[head] = (rssi_t)((pointSum + PointSamples / 2) / PointSamples);
+            head = (head + 1) % Taps;
+            pointSum = 0;
+            pointCount = 0;
+            if (count < Taps)
+            {
+                if (++count < Taps)
+                    return DETECT_NONE;
+            }
+
+            prevScore = score;
+            scoreWindow();
+            const bool matchFlag = (score >= minCorr && amplitude >= minRise);
+            if (!crossing)
+            {
+                if (!matchFlag)
+                    return DETECT_NONE;
+                setBest();
+                return DETECT_PASS_START;
+            }
+            if (!matchFlag)
+                return DETECT_PASS_END;
+            if (!bestValid || score > bestScore)
+                setBest();
+            else if (bestAfter < 0)
+                bestAfter = score;
+            return DETECT_NONE;
+        }
+
+        bool getPass(utime_t &timeMicros, rssi_t &rssiPeak, uint8_t &quality)
+        {
+            if (!bestValid)
+                return false;
+            bestValid = false;
+            timeMicros = bestMicros;
+            const int16_t after = (bestAfter >= 0) ? bestAfter : score;
+            const int16_t curve = (int16_t)bestBefore - 2 * (int16_t)bestScore + after;
+            if (curve < 0)
+            {  // vertex of parabola through correlations around maximum (within half a point)
+                timeMicros += (int32_t)((int16_t)bestBefore - after) * (int32_t)pointMicros / (2 * curve);
+            }
+            rssiPeak = bestPeak;
+            quality = (uint8_t)(((uint16_t)bestScore * 100 + 128) >> 8);
+            return true;
+        }
+
+        void reset()
+        {
+            count = 0;
+            head = 0;
+            pointSum = 0;
+            pointCount = 0;
+            score = 0;
+            prevScore = 0;
+            amplitude = 0;
+            bestValid = false;
+        }
+
+        // Blends shape of pass in current window (centered on its highest point)
+        //  into template; returns false if no pass (rise less than 'minRise')
+        bool learn()
+        {
+            if (count < Taps)
+                return false;
+            uint8_t m = 0;
+            for (uint8_t i = 1; i < Taps; ++i)
+                if (getPoint(i) > getPoint(m))
+                    m = i;
+            rssi_t shape[Taps];
+            rssi_t lo = MAX_RSSI, hi = 0;
+            for (uint8_t j = 0; j < Taps; ++j)
+            {
+                int k = (int)m - Taps / 2 + j;
+                k = (k < 0) ? 0 : (k >= Taps) ? Taps - 1 : k;
+                shape[j] = getPoint((uint8_t)k);
+                if (shape[j] < lo)
+                    lo = shape[j];
+                if (shape[j] > hi)
+                    hi = shape[j];
+            }
+            if ((int)hi - (int)lo < (int)minRise || hi == lo)
+                return false;
+            for (uint8_t j = 0; j < Taps; ++j)
+            {
+                const uint8_t v = (uint8_t)((uint16_t)(shape[j] - lo) * MATCH_TEMPLATE_MAX / (hi - lo));
+                templ[j] = (learnCount == 0) ? v : (uint8_t)((3 * (uint16_t)templ[j] + v + 2) / 4);
+            }
+            if (learnCount < 0xFF)
+                ++learnCount;
+            updateTemplateSums();
+            return true;
+        }
+
+        uint8_t getTemplatePoint(uint8_t idx) { return (idx < Taps) ? templ[idx] : 0; }
+        uint8_t getLearnCount() { return learnCount; }
+        uint8_t getScore() { return score; }
+        rssi_t getAmplitude() { return amplitude; }
+        uint8_t getMinCorr() { return minCorr; }
+        rssi_t getMinRise() { return minRise; }
+        static uint8_t getTaps() { return Taps; }
+};
+
+#endif
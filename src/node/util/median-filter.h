@@ -11,13 +11,13 @@ template <typename T, uint8_t N, T default_value> class MedianFilter : public Fi
 {
     private:
       FastRunningMedian<T,N,default_value> median;
-      CircularBuffer<mtime_t,(N+1)/2> timestamps; // size is half median window, rounded up
+      CircularBuffer<utime_t,(N+1)/2> timestamps; // size is half median window, rounded up
     public:
       bool isFilled() {
         return median.isFilled();
       }
 
-      void addRawValue(mtime_t ts, T value) {
+      void addRawValue(utime_t ts, T value) {
         median.addValue(value);
         timestamps.push(ts);
       }
@@ -26,7 +26,7 @@ template <typename T, uint8_t N, T default_value> class MedianFilter : public Fi
         return median.getMedian();
       }
 
-      mtime_t getFilterTimestamp() {
+      utime_t getFilterTimestamp() {
         return timestamps.first();
       }
 
@@ -4,13 +4,13 @@ template <typename T> class NoFilter : public Filter<T>
 {
     private:
         T v;
-        mtime_t timestamp;
+        utime_t timestamp;
     public:
         bool isFilled() {
             return v != 0;
         }
 
-        void addRawValue(mtime_t ts, T x)
+        void addRawValue(utime_t ts, T x)
         {
             timestamp = ts;
             v = x;
@@ -20,7 +20,7 @@ template <typename T> class NoFilter : public Filter<T>
             return v;
         }
 
-        mtime_t getFilterTimestamp() {
+        utime_t getFilterTimestamp() {
             return timestamp;
         }
 };
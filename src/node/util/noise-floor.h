@@ -0,0 +1,82 @@
+#ifndef noisefloor_h
+#define noisefloor_h
+
+#include "rhtypes.h"
+
+/**
+ * Tracks the RSSI noise floor as the median of the minimum values of the last
+ * 'Blocks' blocks of samples.  Taking the minimum of each block ignores
+ * fly-bys and other short rises, and the median of the block minima ignores
+ * short fades.  Blocks in which a crossing was in progress are not used, so a
+ * quad waiting at the gate does not raise the floor.
+ */
+template <uint8_t Blocks> class NoiseFloorTracker
+{
+    private:
+        rssi_t blockMins[Blocks];
+        uint8_t head = 0;    // next entry to write
+        uint8_t count = 0;
+        uint16_t blockSamples = 0;  // samples in current block
+        rssi_t blockMin = MAX_RSSI;
+        bool blockExcluded = false;
+        rssi_t floorRssi = 0;
+
+        void updateFloor()
+        {
+            rssi_t sorted[Blocks];
+            for (uint8_t i = 0; i < count; ++i)
+            {  // insertion sort (small number of blocks)
+                rssi_t v = blockMins[i];
+                uint8_t j = i;
+                for (; j > 0 && sorted[j - 1] > v; --j)
+                    sorted[j] = sorted[j - 1];
+                sorted[j] = v;
+            }
+            floorRssi = sorted[count / 2];
+        }
+
+    public:
+        void clear()
+        {
+            head = count = 0;
+            blockSamples = 0;
+            blockMin = MAX_RSSI;
+            blockExcluded = false;
+            floorRssi = 0;
+        }
+
+        // Adds filtered value to current block of 'samplesPerBlock' values ('excludeFlag'
+        //  marks block as not usable); returns true if floor estimate changed
+        bool add(rssi_t rssi, bool excludeFlag, uint16_t samplesPerBlock)
+        {
+            if (rssi < blockMin)
+                blockMin = rssi;
+            if (excludeFlag)
+                blockExcluded = true;
+            if (++blockSamples < samplesPerBlock)
+                return false;
+            const bool usedFlag = !blockExcluded;
+            if (usedFlag)
+            {
+                blockMins[head] = blockMin;
+                head = (head + 1) % Blocks;
+                if (count < Blocks)
+                    ++count;
+            }
+            blockSamples = 0;
+            blockMin = MAX_RSSI;
+            blockExcluded = false;
+            if (!usedFlag || !isValid())
+                return false;
+            const rssi_t prevFloor = floorRssi;
+            updateFloor();
+            return floorRssi != prevFloor;
+        }
+
+        // Returns true once half of the blocks have been filled
+        bool isValid() { return count > 0 && count >= Blocks / 2; }
+        rssi_t getFloor() { return floorRssi; }
+        uint8_t getBlockCount() { return count; }
+};
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef passenvelope_h
+#define passenvelope_h
+
+#include "rhtypes.h"
+
+// downsampled RSSI of one pass, from approach through exit
+template <uint8_t Points> struct PassEnvelope
+{
+    uint8_t lap;            // lap number of pass
+    uint8_t pointCount;     // zero if entry is empty
+    int16_t startOffsetMs;  // start of first point relative to lap timestamp
+    uint16_t pointMs;       // time covered by each point
+    rssi_t points[Points];  // max RSSI over each point
+};
+
+/**
+ * Captures the RSSI envelope of each pass and keeps those of the last 'Passes'
+ * passes.  The pass length is not known in advance, so samples are collected
+ * into 'Points' points of one sample each, and whenever the points fill up
+ * adjacent pairs are merged (keeping the max) and the samples per point are
+ * doubled.  The result is 'Points'/2 to 'Points' evenly spaced points however
+ * long the pass was.
+ */
+template <uint8_t Points, uint8_t Passes> class PassEnvelopeStore
+{
+    private:
+        PassEnvelope<Points> passes[Passes];
+        uint8_t next = 0;           // entry for next finished pass
+
+        bool capturing = false;
+        utime_t startMicros = 0;    // time of first sample in capture
+        uint16_t step = 1;          // samples per point
+        uint16_t stepCount = 0;     // samples in point in progress
+        rssi_t stepMax = 0;
+        uint8_t count = 0;          // completed points
+        rssi_t points[Points];
+
+        void addPoint(rssi_t rssi)
+        {
+            points[count++] = rssi;
+            if (count < Points)
+                return;
+            if (step >= 0x8000)
+            {  // far longer than any pass
+                capturing = false;
+                return;
+            }
+            for (uint8_t i = 0; i < Points / 2; ++i)
+                points[i] = (points[2 * i] > points[2 * i + 1]) ? points[2 * i] : points[2 * i + 1];
+            count = Points / 2;
+            step *= 2;
+        }
+
+    public:
+        PassEnvelopeStore()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            for (uint8_t i = 0; i < Passes; ++i)
+                passes[i].pointCount = 0;
+            next = 0;
+            capturing = false;
+        }
+
+        // Adds filtered sample; capture starts with first sample where 'activeFlag' is
+        //  set (pass approaching or in progress) and is dropped if it is cleared
+        //  before the pass is finished
+        void add(rssi_t rssi, utime_t timeMicros, bool activeFlag)
+        {
+            if (!activeFlag)
+            {
+                capturing = false;
+                return;
+            }
+            if (!capturing)
+            {
+                capturing = true;
+                startMicros = timeMicros;
+                step = 1;
+                stepCount = 0;
+                stepMax = 0;
+                count = 0;
+            }
+            if (rssi > stepMax)
+                stepMax = rssi;
+            if (++stepCount >= step)
+            {
+                addPoint(stepMax);
+                stepCount = 0;
+                stepMax = 0;
+            }
+        }
+
+        // Ends capture and stores envelope for the pass with the given lap number
+        //  and timestamp ('sampleMicros' is the time between samples)
+        void finish(uint8_t lap, utime_t lapMicros, utime_t sampleMicros)
+        {
+            if (!capturing)
+                return;
+            capturing = false;
+            if (stepCount > 0)
+                addPoint(stepMax);  // partial point
+            PassEnvelope<Points> &e = passes[next];
+            e.lap = lap;
+            e.pointCount = count;
+            int32_t offsetMs = (int32_t)(startMicros - lapMicros) / 1000;
+            e.startOffsetMs = (int16_t)((offsetMs < -0x7FFF) ? -0x7FFF : (offsetMs > 0x7FFF) ? 0x7FFF : offsetMs);
+            const uint32_t pointMicros = (uint32_t)step * sampleMicros;
+            e.pointMs = (pointMicros < 0xFFFFUL * 1000) ? (uint16_t)(pointMicros / 1000) : 0xFFFF;
+            for (uint8_t i = 0; i < count; ++i)
+                e.points[i] = points[i];
+            next = (next + 1) % Passes;
+        }
+
+        void cancel() { capturing = false; }
+        bool isCapturing() { return capturing; }
+
+        // Returns envelope for pass with given lap number, or NULL if not kept
+        const PassEnvelope<Points> * find(uint8_t lap)
+        {
+            for (uint8_t i = 0; i < Passes; ++i)
+            {
+                const PassEnvelope<Points> &e = passes[i];
+                if (e.pointCount > 0 && e.lap == lap)
+                    return &e;
+            }
+            return NULL;
+        }
+};
+
+#endif
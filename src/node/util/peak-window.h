@@ -0,0 +1,133 @@
+#ifndef peakwindow_h
+#define peakwindow_h
+
+#include "rhtypes.h"
+
+#define PEAK_FIT_QUALITY_NONE 0  // refinement not possible (peak region not fully in window)
+
+/**
+ * Keeps the most recent filtered samples so the lap timestamp can be refined
+ * to better than the sample period.  While a pass is being tracked, sampling
+ * into the window stops once the highest value seen is N/2 samples old, so the
+ * window holds the samples on both sides of the pass peak.  'refine()' returns
+ * the centroid (weighted by height above 'peak - span') of the contiguous run
+ * of samples around the peak, and a fit quality (1-100) based on how
+ * symmetric the run is about the peak plateau.
+ */
+template <uint8_t N> class PeakWindow
+{
+    private:
+        utime_t times[N];
+        rssi_t values[N];
+        uint8_t head = 0;    // next entry to write
+        uint8_t count = 0;
+        bool trackingFlag = false;
+        bool frozenFlag = false;
+        rssi_t peakRssi = 0;
+        uint8_t peakAge = 0;  // samples since end of peak plateau
+
+        uint8_t indexOf(uint8_t i) { return (uint8_t)((head + N - count + i) % N); }
+
+        void store(utime_t timeMicros, rssi_t rssi)
+        {
+            times[head] = timeMicros;
+            values[head] = rssi;
+            head = (head + 1) % N;
+            if (count < N)
+                ++count;
+        }
+
+    public:
+        void clear()
+        {
+            head = count = 0;
+            trackingFlag = frozenFlag = false;
+        }
+
+        // Starts tracking pass peak (samples already in window are kept)
+        void startPass()
+        {
+            trackingFlag = true;
+            frozenFlag = false;
+            peakRssi = (count > 0) ? values[(head + N - 1) % N] : 0;
+            peakAge = 0;
+        }
+
+        void endPass() { trackingFlag = false; }
+
+        void add(utime_t timeMicros, rssi_t rssi)
+        {
+            if (trackingFlag)
+            {
+                if (rssi > peakRssi)
+                {
+                    if (frozenFlag)
+                    {  // samples before new peak were not kept
+                        head = count = 0;
+                        frozenFlag = false;
+                    }
+                    peakRssi = rssi;
+                    peakAge = 0;
+                }
+                else if (frozenFlag)
+                    return;
+                else if (rssi == peakRssi)
+                    peakAge = 0;
+                else if (++peakAge >= N / 2)
+                    frozenFlag = true;
+            }
+            store(timeMicros, rssi);
+        }
+
+        uint8_t getCount() { return count; }
+
+        // Computes refined peak time; returns fit quality, or PEAK_FIT_QUALITY_NONE
+        //  if the run of samples above 'peak - span' reaches either end of the window
+        uint8_t refine(rssi_t span, utime_t &peakMicros)
+        {
+            if (count == 0)
+                return PEAK_FIT_QUALITY_NONE;
+            uint8_t pStart = 0;
+            rssi_t peak = values[indexOf(0)];
+            for (uint8_t i = 1; i < count; ++i)
+            {
+                if (values[indexOf(i)] > peak)
+                {
+                    peak = values[indexOf(i)];
+                    pStart = i;
+                }
+            }
+            uint8_t pEnd = pStart;
+            while (pEnd + 1 < count && values[indexOf(pEnd + 1)] == peak)
+                ++pEnd;
+
+            const int threshold = (int)peak - (int)span;
+            uint8_t left = pStart;
+            while (left > 0 && (int)values[indexOf(left - 1)] > threshold)
+                --left;
+            uint8_t right = pEnd;
+            while (right + 1 < count && (int)values[indexOf(right + 1)] > threshold)
+                ++right;
+            if (left == 0 || right == count - 1)
+                return PEAK_FIT_QUALITY_NONE;  // no sample below threshold on one side
+
+            const utime_t baseMicros = times[indexOf(left)];
+            uint32_t weightSum = 0;
+            uint64_t weightedSum = 0;
+            for (uint8_t i = left; i <= right; ++i)
+            {
+                uint32_t w = (uint32_t)((int)values[indexOf(i)] - threshold);
+                weightSum += w;
+                weightedSum += (uint64_t)(times[indexOf(i)] - baseMicros) * w;
+            }
+            peakMicros = baseMicros + (utime_t)((weightedSum + weightSum / 2) / weightSum);
+
+            const uint8_t leftLen = pStart - left + 1;
+            const uint8_t rightLen = right - pEnd + 1;
+            uint8_t quality = (leftLen < rightLen) ? (uint8_t)(100 * leftLen / rightLen) :
+                                                     (uint8_t)(100 * rightLen / leftLen);
+            return (quality > PEAK_FIT_QUALITY_NONE) ? quality : PEAK_FIT_QUALITY_NONE + 1;
+        }
+};
+
+#endif
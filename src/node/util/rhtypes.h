@@ -11,8 +11,8 @@ typedef uint8_t rssi_t;
 struct Extremum
 {
   rssi_t volatile rssi;
-  mtime_t volatile firstTime;
-  uint16_t volatile duration;
+  utime_t volatile firstTime;  // micros
+  utime_t volatile duration;   // micros
 };
 
 #define MAX_RSSI 0xFF
@@ -0,0 +1,173 @@
+#ifndef rssicalibration_h
+#define rssicalibration_h
+
+#include "rhtypes.h"
+
+#define CALIBRATION_IDLE 0
+#define CALIBRATION_CAPTURING 1
+#define CALIBRATION_DONE 2        // capture finished, suggested levels available
+#define CALIBRATION_NO_PASSES 3   // capture finished, but no fly-by stood out from the noise floor
+
+struct CalibrationResult
+{
+    rssi_t noiseP10 = 0;   // percentiles of all RSSI values captured
+    rssi_t noiseP50 = 0;
+    rssi_t noiseFloor = 0; // top of noise band (P50 + (P50 - P10))
+    rssi_t peakP25 = 0;    // percentiles of fly-by peaks above the noise floor
+    rssi_t peakP50 = 0;
+    rssi_t peakMax = 0;
+    uint16_t passCount = 0;  // fly-by peaks above the noise floor
+    rssi_t enterAtLevel = 0;
+    rssi_t exitAtLevel = 0;
+};
+
+/**
+ * Captures the distribution of filtered RSSI values and of fly-by peaks over
+ * a number of samples, then suggests EnterAt/ExitAt levels.  Values are
+ * counted in histograms with bins 2^BinShift RSSI units wide.  A local peak is
+ * counted as a fly-by if it rose at least 'minRise' above the lowest value
+ * since the previous fly-by; after capture, fly-bys less than 'minRise' above
+ * the noise floor are ignored.  The noise floor is estimated from the lower
+ * half of the distribution (which fly-bys do not reach), assuming the noise is
+ * roughly symmetric.  EnterAt and ExitAt are placed at the given percentages
+ * of the way from the noise floor to the (lower quartile) fly-by peak.
+ */
+template <uint8_t BinShift> class RssiCalibration
+{
+    private:
+        static const uint16_t BINS = (MAX_RSSI >> BinShift) + 1;
+
+        uint16_t sampleHist[BINS];
+        uint16_t peakHist[BINS];
+        uint32_t remainingSamples = 0;
+        uint32_t sampleCount = 0;
+        uint8_t status = CALIBRATION_IDLE;
+        rssi_t minRise = 0;
+        uint8_t enterPercent = 0;
+        uint8_t exitPercent = 0;
+        rssi_t lastRssi = 0;
+        rssi_t troughRssi = MAX_RSSI;  // lowest value since previous fly-by
+        bool risingFlag = false;
+        CalibrationResult result;
+
+        // Counts value in histogram (halving all counts when a bin is full, so
+        //  long captures keep the shape of the distribution)
+        static void countValue(uint16_t *hist, rssi_t rssi)
+        {
+            if (hist[rssi >> BinShift] == 0xFFFF)
+            {
+                for (uint16_t i = 0; i < BINS; ++i)
+                    hist[i] >>= 1;
+            }
+            ++hist[rssi >> BinShift];
+        }
+
+        static rssi_t binCenter(uint16_t bin)
+        {
+            const uint16_t center = (bin << BinShift) + ((1 << BinShift) >> 1);
+            return (center < MAX_RSSI) ? (rssi_t)center : MAX_RSSI;
+        }
+
+        // Returns center of bin at given percentile of counts in bins 'first' and above
+        static rssi_t percentile(const uint16_t *hist, uint16_t first, uint8_t pct)
+        {
+            uint32_t total = 0;
+            for (uint16_t i = first; i < BINS; ++i)
+                total += hist[i];
+            if (total == 0)
+                return 0;
+            const uint32_t target = (total * pct + 99) / 100;
+            uint32_t sum = 0;
+            uint16_t i = first;
+            for (; i < BINS - 1; ++i)
+            {
+                sum += hist[i];
+                if (sum >= target && sum > 0)
+                    break;
+            }
+            return binCenter(i);
+        }
+
+        void finish()
+        {
+            result.noiseP10 = percentile(sampleHist, 0, 10);
+            result.noiseP50 = percentile(sampleHist, 0, 50);
+            const uint16_t noiseTop = 2 * (uint16_t)result.noiseP50 - result.noiseP10;
+            result.noiseFloor = (noiseTop < MAX_RSSI) ? (rssi_t)noiseTop : MAX_RSSI;
+            const uint16_t firstPeakBin = ((uint16_t)result.noiseFloor + minRise) >> BinShift;
+            result.passCount = 0;
+            result.peakMax = 0;
+            for (uint16_t i = firstPeakBin; i < BINS; ++i)
+            {
+                if (peakHist[i] > 0)
+                {
+                    result.passCount += peakHist[i];
+                    result.peakMax = binCenter(i);
+                }
+            }
+            if (result.passCount == 0)
+            {
+                status = CALIBRATION_NO_PASSES;
+                return;
+            }
+            result.peakP25 = percentile(peakHist, firstPeakBin, 25);
+            result.peakP50 = percentile(peakHist, firstPeakBin, 50);
+            const int span = (int)result.peakP25 - (int)result.noiseFloor;
+            result.enterAtLevel = (rssi_t)(result.noiseFloor + span * enterPercent / 100);
+            result.exitAtLevel = (rssi_t)(result.noiseFloor + span * exitPercent / 100);
+            status = CALIBRATION_DONE;
+        }
+
+    public:
+        // Starts capture of given number of samples (zero cancels capture)
+        void start(uint32_t samples, rssi_t minPeakRise, uint8_t enterPct, uint8_t exitPct)
+        {
+            for (uint16_t i = 0; i < BINS; ++i)
+                sampleHist[i] = peakHist[i] = 0;
+            remainingSamples = samples;
+            sampleCount = 0;
+            minRise = minPeakRise;
+            enterPercent = enterPct;
+            exitPercent = exitPct;
+            troughRssi = MAX_RSSI;
+            risingFlag = false;
+            result = CalibrationResult();
+            status = (samples > 0) ? CALIBRATION_CAPTURING : CALIBRATION_IDLE;
+        }
+
+        // Adds filtered RSSI value; returns true when capture has just finished
+        bool addSample(rssi_t rssi)
+        {
+            if (status != CALIBRATION_CAPTURING)
+                return false;
+            countValue(sampleHist, rssi);
+            if (sampleCount > 0)
+            {
+                if (rssi > lastRssi)
+                    risingFlag = true;
+                else if (rssi < lastRssi && risingFlag)
+                {  // 'lastRssi' was a local peak
+                    risingFlag = false;
+                    if ((int)lastRssi - (int)troughRssi >= (int)minRise)
+                    {
+                        countValue(peakHist, lastRssi);
+                        troughRssi = lastRssi;
+                    }
+                }
+            }
+            if (rssi < troughRssi)
+                troughRssi = rssi;
+            lastRssi = rssi;
+            ++sampleCount;
+            if (--remainingSamples > 0)
+                return false;
+            finish();
+            return true;
+        }
+
+        uint8_t getStatus() { return status; }
+        uint32_t getSampleCount() { return sampleCount; }
+        const CalibrationResult & getResult() { return result; }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef rssipyramid_h
+#define rssipyramid_h
+
+#include "rhtypes.h"
+
+// max, min and mean RSSI over one pyramid entry
+struct PyramidEntry
+{
+    rssi_t maxRssi;
+    rssi_t minRssi;
+    rssi_t meanRssi;
+};
+
+/**
+ * Multi-resolution summary of recent RSSI: 'Tiers' rings of 'Size' entries,
+ * where each tier-0 entry covers a fixed number of samples and each entry of
+ * the next tier covers 'Factor' entries of the tier below (e.g. 1 ms, 10 ms,
+ * 100 ms and 1 s).  Entries are built incrementally, so adding a sample costs
+ * one accumulator update plus a cascade when an entry completes.
+ */
+template <uint8_t Tiers, uint8_t Size, uint8_t Factor> class RssiPyramid
+{
+    private:
+        struct Tier
+        {
+            PyramidEntry entries[Size];
+            uint8_t head;          // next entry to write
+            uint8_t count;
+            utime_t lastMicros;    // time newest entry was completed
+            rssi_t accMax;         // entry in progress
+            rssi_t accMin;
+            uint16_t accSum;
+            uint16_t accCount;
+
+            void clear()
+            {
+                head = count = 0;
+                lastMicros = 0;
+                accMax = 0;
+                accMin = MAX_RSSI;
+                accSum = accCount = 0;
+            }
+
+            void accumulate(rssi_t maxVal, rssi_t minVal, rssi_t meanVal)
+            {
+                if (maxVal > accMax)
+                    accMax = maxVal;
+                if (minVal < accMin)
+                    accMin = minVal;
+                accSum += meanVal;
+                ++accCount;
+            }
+
+            // Moves entry in progress into ring and returns it
+            PyramidEntry complete(utime_t timeMicros)
+            {
+                PyramidEntry &e = entries[head];
+                e.maxRssi = accMax;
+                e.minRssi = accMin;
+                e.meanRssi = (rssi_t)((accSum + accCount / 2) / accCount);
+                head = (head + 1) % Size;
+                if (count < Size)
+                    ++count;
+                lastMicros = timeMicros;
+                accMax = 0;
+                accMin = MAX_RSSI;
+                accSum = accCount = 0;
+                return e;
+            }
+        };
+
+        Tier tiers[Tiers];
+
+    public:
+        RssiPyramid()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            for (uint8_t t = 0; t < Tiers; ++t)
+                tiers[t].clear();
+        }
+
+        // Adds filtered value; a tier-0 entry is complete after 'samplesPerEntry' values
+        void add(rssi_t rssi, utime_t timeMicros, uint16_t samplesPerEntry)
+        {
+            tiers[0].accumulate(rssi, rssi, rssi);
+            if (tiers[0].accCount < samplesPerEntry)
+                return;
+            PyramidEntry e = tiers[0].complete(timeMicros);
+            for (uint8_t t = 1; t < Tiers; ++t)
+            {
+                tiers[t].accumulate(e.maxRssi, e.minRssi, e.meanRssi);
+                if (tiers[t].accCount < Factor)
+                    break;
+                e = tiers[t].complete(timeMicros);
+            }
+        }
+
+        // Returns number of completed entries available in tier
+        uint8_t getCount(uint8_t tier) { return tiers[tier].count; }
+
+        // Returns entry 'offset' places before the newest in tier (0 = newest)
+        const PyramidEntry & getEntry(uint8_t tier, uint8_t offset)
+        {
+            const Tier &t = tiers[tier];
+            return t.entries[(uint8_t)((t.head + Size - 1 - offset) % Size)];
+        }
+
+        // Returns time newest entry in tier was completed
+        utime_t getLastMicros(uint8_t tier) { return tiers[tier].lastMicros; }
+
+        // Returns number of tier-0 entries covered by one entry in tier
+        static uint16_t getScale(uint8_t tier)
+        {
+            uint16_t scale = 1;
+            while (tier-- > 0)
+                scale *= Factor;
+            return scale;
+        }
+};
+
+#endif
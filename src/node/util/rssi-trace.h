@@ -0,0 +1,115 @@
+#ifndef rssitrace_h
+#define rssitrace_h
+
+#include "rhtypes.h"
+
+// codes in encoded trace data (first byte of each packet is an absolute value)
+#define TRACE_DELTA_BIAS 64    // 0x00-0x7F:  delta from previous value (byte - 64), never zero
+#define TRACE_CODE_RUN 0x80    // 0x80-0xBF:  previous value repeated (1 + low 6 bits) times
+#define TRACE_CODE_ABS 0xC0    // 0xC0:  absolute value follows in next byte
+#define TRACE_RUN_MAX 64
+
+/**
+ * Queue of RSSI samples for trace streaming.  Samples are taken from the
+ * queue in packets that are delta/run-length encoded (about one byte per
+ * sample, less while the value is steady).  Each packet starts with an
+ * absolute value, so a lost packet does not affect the ones after it.  When
+ * the queue is full the oldest sample is dropped; the sequence number counts
+ * every sample added, so the reader can detect dropped samples.
+ */
+template <uint16_t N> class RssiTrace
+{
+    private:
+        rssi_t samples[N];
+        uint16_t tail = 0;      // index of oldest sample
+        uint16_t count = 0;
+        uint16_t seq = 0;       // sequence number of oldest sample (wraps around)
+        bool overflowFlag = false;
+
+    public:
+        void clear()
+        {
+            tail = count = 0;
+            seq = 0;
+            overflowFlag = false;
+        }
+
+        void add(rssi_t rssi)
+        {
+            if (count >= N)
+            {
+                tail = (tail + 1) % N;
+                --count;
+                ++seq;
+                overflowFlag = true;
+            }
+            samples[(tail + count) % N] = rssi;
+            ++count;
+        }
+
+        uint16_t getCount() { return count; }
+        uint16_t getSeq() { return seq; }
+
+        // Returns true if samples were dropped since the previous call
+        bool takeOverflow()
+        {
+            const bool flag = overflowFlag;
+            overflowFlag = false;
+            return flag;
+        }
+
+        // Removes samples from queue and encodes them into 'dest' (up to 'maxBytes'
+        //  and 255 samples); sets 'sampleCount' and returns number of bytes used
+        uint8_t encode(uint8_t *dest, uint8_t maxBytes, uint8_t &sampleCount)
+        {
+            sampleCount = 0;
+            if (count == 0 || maxBytes == 0)
+                return 0;
+            uint8_t len = 0;
+            rssi_t prev = samples[tail];
+            dest[len++] = prev;
+            int8_t runIdx = -1;  // position of run code being extended
+            uint8_t n = 1;
+            while (n < count && n < 0xFF)
+            {
+                const rssi_t v = samples[(tail + n) % N];
+                const int16_t delta = (int16_t)v - (int16_t)prev;
+                if (delta == 0)
+                {
+                    if (runIdx >= 0 && dest[runIdx] < TRACE_CODE_RUN + TRACE_RUN_MAX - 1)
+                        ++dest[runIdx];
+                    else
+                    {
+                        if (len >= maxBytes)
+                            break;
+                        runIdx = len;
+                        dest[len++] = TRACE_CODE_RUN;
+                    }
+                }
+                else if (delta >= -TRACE_DELTA_BIAS && delta < TRACE_DELTA_BIAS)
+                {
+                    if (len >= maxBytes)
+                        break;
+                    dest[len++] = (uint8_t)(delta + TRACE_DELTA_BIAS);
+                    runIdx = -1;
+                }
+                else
+                {
+                    if (len + 2 > maxBytes)
+                        break;
+                    dest[len++] = TRACE_CODE_ABS;
+                    dest[len++] = v;
+                    runIdx = -1;
+                }
+                prev = v;
+                ++n;
+            }
+            tail = (tail + n) % N;
+            count -= n;
+            seq += n;
+            sampleCount = n;
+            return len;
+        }
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef samplefifo_h
+#define samplefifo_h
+
+#include "rhtypes.h"
+
+#define SAMPLE_FLAG_RESYNC 0x01  // sampling was paused before this sample (gap is expected)
+
+struct RssiSample
+{
+    utime_t timeMicros;
+    rssi_t rssi;
+    uint8_t flags;
+};
+
+/**
+ * Single-producer/single-consumer queue of timestamped RSSI samples; samples
+ * are pushed by the sampling interrupt and popped by the main loop.  Tracks the
+ * high-water mark and the number of samples dropped because the queue was full.
+ * Holds up to N-1 samples.
+ */
+template <uint8_t N> class SampleFifo
+{
+    private:
+        RssiSample samples[N];
+        volatile uint8_t head = 0;  // next entry to write (updated by producer)
+        volatile uint8_t tail = 0;  // next entry to read (updated by consumer)
+        volatile uint8_t highWater = 0;
+        volatile uint16_t overflowCount = 0;
+
+    public:
+        // Adds sample (called from interrupt); returns false if queue is full
+        bool push(utime_t timeMicros, rssi_t rssi, uint8_t flags = 0)
+        {
+            uint8_t next = (head + 1) % N;
+            if (next == tail)
+            {
+                if (overflowCount < 0xFFFF)
+                    overflowCount = overflowCount + 1;
+                return false;
+            }
+            samples[head].timeMicros = timeMicros;
+            samples[head].rssi = rssi;
+            samples[head].flags = flags;
+            head = next;
+            uint8_t count = getCount();
+            if (count > highWater)
+                highWater = count;
+            return true;
+        }
+
+        bool pop(RssiSample& s)
+        {
+            uint8_t idx = tail;
+            if (idx == head)
+                return false;
+            s.timeMicros = samples[idx].timeMicros;
+            s.rssi = samples[idx].rssi;
+            s.flags = samples[idx].flags;
+            tail = (idx + 1) % N;
+            return true;
+        }
+
+        void clear() { tail = head; }
+        uint8_t getCount() { return (uint8_t)((head + N - tail) % N); }
+        uint8_t getHighWater() { return highWater; }
+        void clearHighWater() { highWater = getCount(); }
+        uint16_t getOverflowCount() { return overflowCount; }
+};
+
+#endif
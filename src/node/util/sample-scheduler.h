@@ -0,0 +1,200 @@
+#ifndef samplescheduler_h
+#define samplescheduler_h
+
+#include "rhtypes.h"
+
+#define SAMPLE_SLOT_NONE 0xFF  // returned by 'timerTick()' when no slots are active
+
+struct SampleSlotStats
+{
+    uint16_t jitterMax = 0;        // largest deviation of sample interval from expected (micros)
+    uint16_t jitterAvg = 0;        // running average of deviation (micros)
+    uint16_t processMax = 0;       // longest time to process one sample (micros)
+    uint16_t overBudgetCount = 0;  // processing batches that took longer than slot spacing per sample
+};
+
+/**
+ * Schedules sampling of multiple nodes at fixed phases within the sample period.
+ * A hardware timer calls 'timerTick()' once per tick, and the interrupt samples
+ * the node for the returned slot.  Only active slots are in the rotation, and
+ * each active slot is always sampled at the same phase regardless of main-loop
+ * activity.  The tick spacing is never less than 'period / slotCount' (the ADC
+ * budget with all slots active), so when slots are inactive the active ones are
+ * sampled up to 'MaxOversample' times per period.  Only slots in burst mode use
+ * the extra readings; idle slots are sampled once per period.
+ * The main loop reports how long it takes to process the samples.
+ */
+template <uint8_t MaxSlots, uint8_t MaxOversample = 1> class SampleScheduler
+{
+    private:
+        SampleSlotStats stats[MaxSlots];
+        uint32_t jitterAvgScaled[MaxSlots];  // average jitter << SAMPLE_JITTER_AVG_SHIFT
+        utime_t prevSampleMicros[MaxSlots];
+        bool slotActive[MaxSlots];
+        volatile bool slotBurst[MaxSlots];   // sampled on every round (else only on first round)
+        bool jitterSkip[MaxSlots];           // slot's expected interval just changed
+        uint8_t rotation[MaxSlots];   // active slots in sampling order
+        uint8_t slotCount = 1;
+        uint8_t activeCount = 1;
+        uint8_t oversampleCount = 1;  // samples taken for each slot per period
+        uint8_t nextIdx = 0;          // index into 'rotation'
+        uint8_t roundIdx = 0;         // pass through rotation within period (< oversampleCount)
+        bool firstPeriodFlag = true;  // no previous sample times yet
+        utime_t periodMicros = 1000;
+        utime_t tickMicros = 1000;    // spacing between timer ticks
+        utime_t slotMicros = 1000;    // processing budget for each sample (period / active slots)
+
+    public:
+        static const uint8_t SAMPLE_JITTER_AVG_SHIFT = 4;
+
+        SampleScheduler()
+        {
+            init(1, periodMicros);
+        }
+
+        // Sets number of slots (all active) and sample period for each slot;
+        //  returns timer interval (micros)
+        utime_t init(uint8_t count, utime_t period)
+        {
+            slotCount = (count > 0 && count <= MaxSlots) ? count : 1;
+            periodMicros = period;
+            for (uint8_t i = 0; i < MaxSlots; ++i)
+            {
+                stats[i] = SampleSlotStats();
+                jitterAvgScaled[i] = 0;
+                prevSampleMicros[i] = 0;
+                slotActive[i] = (i < slotCount);
+                slotBurst[i] = true;
+                jitterSkip[i] = false;
+            }
+            return updateRotation();
+        }
+
+        // Marks slot as in or out of the rotation (takes effect on 'updateRotation()');
+        //  returns true if changed
+        bool setSlotActive(uint8_t slot, bool active)
+        {
+            if (slot >= slotCount || slotActive[slot] == active)
+                return false;
+            slotActive[slot] = active;
+            return true;
+        }
+
+        // Rebuilds rotation from active slots (timer must not tick meanwhile);
+        //  returns new timer interval (micros), or zero if no slots are active
+        utime_t updateRotation()
+        {
+            activeCount = 0;
+            for (uint8_t i = 0; i < slotCount; ++i)
+            {
+                if (slotActive[i])
+                    rotation[activeCount++] = i;
+            }
+            nextIdx = 0;
+            roundIdx = 0;
+            firstPeriodFlag = true;
+            if (activeCount == 0)
+            {
+                oversampleCount = 1;
+                tickMicros = slotMicros = periodMicros;
+                return 0;
+            }
+            oversampleCount = slotCount / activeCount;
+            if (oversampleCount > MaxOversample)
+                oversampleCount = MaxOversample;
+            slotMicros = periodMicros / activeCount;
+            tickMicros = slotMicros / oversampleCount;
+            return tickMicros;
+        }
+
+        // Sets whether slot uses all readings available to it (called by main loop)
+        void setSlotBurst(uint8_t slot, bool burst)
+        {
+            if (slot < MaxSlots && slotBurst[slot] != burst)
+            {
+                jitterSkip[slot] = true;
+                slotBurst[slot] = burst;
+            }
+        }
+
+        // Called from timer interrupt at each tick; returns slot to be sampled
+        //  (or SAMPLE_SLOT_NONE)
+        uint8_t timerTick(utime_t nowMicros)
+        {
+            if (activeCount == 0)
+                return SAMPLE_SLOT_NONE;
+            const uint8_t slot = rotation[nextIdx];
+            const uint8_t round = roundIdx;
+            const bool firstFlag = firstPeriodFlag;
+            if (++nextIdx >= activeCount)
+            {
+                nextIdx = 0;
+                if (++roundIdx >= oversampleCount)
+                {
+                    roundIdx = 0;
+                    firstPeriodFlag = false;
+                }
+            }
+            const bool burst = slotBurst[slot];
+            if (!burst && round != 0)
+                return SAMPLE_SLOT_NONE;  // idle slot only sampled on first round
+            if (jitterSkip[slot])
+                jitterSkip[slot] = false;
+            else if (!firstFlag)
+            {
+                utime_t expected = tickMicros * activeCount * (burst ? 1 : oversampleCount);
+                utime_t interval = nowMicros - prevSampleMicros[slot];
+                utime_t jitter = (interval > expected) ? interval - expected : expected - interval;
+                uint16_t jitter16 = (jitter < 0xFFFF) ? (uint16_t)jitter : 0xFFFF;
+                SampleSlotStats &s = stats[slot];
+                if (jitter16 > s.jitterMax)
+                    s.jitterMax = jitter16;
+                jitterAvgScaled[slot] += jitter16 - (jitterAvgScaled[slot] >> SAMPLE_JITTER_AVG_SHIFT);
+                s.jitterAvg = (uint16_t)(jitterAvgScaled[slot] >> SAMPLE_JITTER_AVG_SHIFT);
+            }
+            prevSampleMicros[slot] = nowMicros;
+            return slot;
+        }
+
+        // Called by main loop after processing 'count' samples for slot
+        void recordProcessing(uint8_t slot, utime_t procMicros, uint8_t count)
+        {
+            SampleSlotStats &s = stats[slot];
+            utime_t perSample = procMicros / count;
+            if (perSample > s.processMax)
+                s.processMax = (perSample < 0xFFFF) ? (uint16_t)perSample : 0xFFFF;
+            if (procMicros > slotMicros * count && s.overBudgetCount < 0xFFFF)
+                ++s.overBudgetCount;
+        }
+
+        uint8_t getSlotCount() { return slotCount; }
+        uint8_t getActiveCount() { return activeCount; }
+        bool isSlotActive(uint8_t slot) { return slot < slotCount && slotActive[slot]; }
+        uint8_t getOversampleCount() { return oversampleCount; }
+        bool isSlotBurst(uint8_t slot) { return slotBurst[slot]; }
+
+        // Returns number of readings to be averaged into each sample for slot
+        uint8_t getSlotOversample(uint8_t slot) { return slotBurst[slot] ? oversampleCount : 1; }
+        utime_t getSlotMicros() { return slotMicros; }
+        utime_t getTickMicros() { return tickMicros; }
+        uint8_t getNextSlot() { return (activeCount > 0) ? rotation[nextIdx] : SAMPLE_SLOT_NONE; }
+
+        // Returns number of times per second that slot is sampled (zero if not in rotation)
+        uint16_t getSlotRateHz(uint8_t slot)
+        {
+            if (!isSlotActive(slot) || activeCount == 0)
+                return 0;
+            return (uint16_t)(1000000UL * getSlotOversample(slot) / (tickMicros * activeCount * oversampleCount));
+        }
+
+        // Returns stats for slot and clears the max values
+        SampleSlotStats readStats(uint8_t slot)
+        {
+            SampleSlotStats s = stats[slot];
+            stats[slot].jitterMax = 0;
+            stats[slot].processMax = 0;
+            return s;
+        }
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef slidingminmax_h
+#define slidingminmax_h
+
+#include "rhtypes.h"
+
+/**
+ * Maximum and minimum RSSI over a sliding window of the last N blocks of
+ * samples (plus the block in progress), updated in constant amortized time.
+ * Each block's max and min are kept in monotonic deques: the max deque holds
+ * decreasing values and the min deque increasing values, so the front of each
+ * is the extremum of the window.  A value is dropped when a newer block has a
+ * larger (or smaller) value, or when it leaves the window.
+ */
+template <uint8_t N> class SlidingMinMax
+{
+    private:
+        struct Deque
+        {
+            rssi_t values[N];
+            uint8_t seqs[N];   // block sequence numbers (wrap around)
+            uint8_t head;      // index of front entry
+            uint8_t count;
+
+            uint8_t indexOf(uint8_t i) { return (uint8_t)((head + i) % N); }
+
+            // Drops entries from blocks no longer in window ending at block 'seq'
+            //  (N - 1 complete blocks before the block in progress)
+            void expire(uint8_t seq)
+            {
+                while (count > 0 && (uint8_t)(seq - seqs[head]) >= N)
+                {
+                    head = (head + 1) % N;
+                    --count;
+                }
+            }
+
+            // Adds value, first dropping entries it supersedes ('maxFlag' selects
+            //  whether larger or smaller values are kept)
+            void push(uint8_t seq, rssi_t value, bool maxFlag)
+            {
+                while (count > 0)
+                {
+                    const rssi_t back = values[indexOf(count - 1)];
+                    if (maxFlag ? (back > value) : (back < value))
+                        break;
+                    --count;
+                }
+                values[indexOf(count)] = value;
+                seqs[indexOf(count)] = seq;
+                ++count;
+            }
+        };
+
+        Deque maxDeque;
+        Deque minDeque;
+        uint8_t seq = 0;             // sequence number of block in progress
+        uint16_t blockSamples = 0;   // samples in block in progress
+        rssi_t blockMax = 0;
+        rssi_t blockMin = MAX_RSSI;
+
+    public:
+        SlidingMinMax()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            maxDeque.head = maxDeque.count = 0;
+            minDeque.head = minDeque.count = 0;
+            seq = 0;
+            blockSamples = 0;
+            blockMax = 0;
+            blockMin = MAX_RSSI;
+        }
+
+        // Adds value to block in progress; a block is complete after 'samplesPerBlock' values
+        void add(rssi_t rssi, uint16_t samplesPerBlock)
+        {
+            if (rssi > blockMax)
+                blockMax = rssi;
+            if (rssi < blockMin)
+                blockMin = rssi;
+            if (++blockSamples < samplesPerBlock)
+                return;
+            maxDeque.push(seq, blockMax, true);
+            minDeque.push(seq, blockMin, false);
+            ++seq;
+            maxDeque.expire(seq);
+            minDeque.expire(seq);
+            blockSamples = 0;
+            blockMax = 0;
+            blockMin = MAX_RSSI;
+        }
+
+        // Returns largest value in window (zero if no values)
+        rssi_t getMax()
+        {
+            const rssi_t m = (maxDeque.count > 0) ? maxDeque.values[maxDeque.head] : 0;
+            return (blockMax > m) ? blockMax : m;
+        }
+
+        // Returns smallest value in window (MAX_RSSI if no values)
+        rssi_t getMin()
+        {
+            const rssi_t m = (minDeque.count > 0) ? minDeque.values[minDeque.head] : MAX_RSSI;
+            return (blockMin < m) ? blockMin : m;
+        }
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef taskscheduler_h
+#define taskscheduler_h
+
+#include "rhtypes.h"
+
+typedef void (*TaskFunction)(mtime_t dueMs);
+
+struct TaskStats
+{
+    uint32_t totalMicros = 0;  // run time since stats were last read
+    uint16_t maxMicros = 0;    // longest single run since stats were last read
+    uint16_t runCount = 0;     // runs since stats were last read
+};
+
+/**
+ * Cooperative scheduler for housekeeping tasks.  Each task has a period and a
+ * priority (lower value runs first when several are due); due times are kept at
+ * multiples of the period, and the task is passed its scheduled time so checks like
+ * '(dueMs % 1000) == 0' work as expected.  Run time is accounted per task so
+ * CPU share can be reported.  Tasks with a period of zero are run directly by
+ * the caller each pass and are only accounted here (via 'addRunTime()').
+ * When the caller is overloaded, low-priority tasks can be shed (skipped for
+ * their current period) via 'shedDueTasks()'.
+ */
+template <uint8_t MaxTasks> class TaskScheduler
+{
+    private:
+        struct Task
+        {
+            uint8_t id;
+            TaskFunction function;
+            uint16_t periodMs;
+            uint8_t priority;
+            mtime_t dueMs;
+            TaskStats stats;
+        };
+        Task tasks[MaxTasks];
+        uint8_t taskCount = 0;
+        utime_t statsStartMicros = 0;
+        uint16_t shedCount = 0;  // task runs skipped by 'shedDueTasks()'
+
+    public:
+        // Adds task with given ID (reported with stats); returns task index
+        uint8_t addTask(uint8_t id, TaskFunction function, uint16_t periodMs, uint8_t priority)
+        {
+            if (taskCount >= MaxTasks)
+                return MaxTasks;
+            Task &t = tasks[taskCount];
+            t.id = id;
+            t.function = function;
+            t.periodMs = periodMs;
+            t.priority = priority;
+            t.dueMs = 0;
+            t.stats = TaskStats();
+            return taskCount++;
+        }
+
+        // Returns index of highest-priority task that is due, or -1 if none
+        int8_t getDueTask(mtime_t nowMs)
+        {
+            int8_t best = -1;
+            for (uint8_t i = 0; i < taskCount; ++i)
+            {
+                if (tasks[i].periodMs > 0 && (int32_t)(nowMs - tasks[i].dueMs) >= 0 &&
+                        (best < 0 || tasks[i].priority < tasks[best].priority))
+                    best = i;
+            }
+            return best;
+        }
+
+        // Calls task function with its scheduled time and schedules next run
+        //  (runs that were missed are skipped)
+        void runTask(uint8_t idx, mtime_t nowMs)
+        {
+            Task &t = tasks[idx];
+            mtime_t slotMs = nowMs - nowMs % t.periodMs;
+            t.dueMs = slotMs + t.periodMs;
+            t.function(slotMs);
+        }
+
+        // Skips current run of due tasks with priority value above 'maxPriority';
+        //  returns number of runs skipped
+        uint8_t shedDueTasks(mtime_t nowMs, uint8_t maxPriority)
+        {
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < taskCount; ++i)
+            {
+                Task &t = tasks[i];
+                if (t.periodMs > 0 && t.priority > maxPriority && (int32_t)(nowMs - t.dueMs) >= 0)
+                {
+                    t.dueMs = nowMs - nowMs % t.periodMs + t.periodMs;
+                    ++count;
+                }
+            }
+            if (count > 0xFFFF - shedCount)
+                shedCount = 0xFFFF;
+            else
+                shedCount += count;
+            return count;
+        }
+
+        uint16_t getShedCount() { return shedCount; }
+
+        void addRunTime(uint8_t idx, utime_t runMicros)
+        {
+            TaskStats &s = tasks[idx].stats;
+            s.totalMicros += runMicros;
+            if (runMicros > s.maxMicros)
+                s.maxMicros = (runMicros < 0xFFFF) ? (uint16_t)runMicros : 0xFFFF;
+            if (s.runCount < 0xFFFF)
+                ++s.runCount;
+        }
+
+        uint8_t getTaskCount() { return taskCount; }
+        uint8_t getTaskId(uint8_t idx) { return tasks[idx].id; }
+
+        // Returns task share of CPU time (in 1/1000) since stats were last cleared
+        uint16_t getSharePermille(uint8_t idx, utime_t nowMicros)
+        {
+            utime_t elapsed = nowMicros - statsStartMicros;
+            if (elapsed == 0)
+                return 0;
+            uint32_t share = (uint32_t)((uint64_t)tasks[idx].stats.totalMicros * 1000 / elapsed);
+            return (share < 1000) ? (uint16_t)share : 1000;
+        }
+
+        TaskStats getStats(uint8_t idx) { return tasks[idx].stats; }
+
+        void clearStats(utime_t nowMicros)
+        {
+            for (uint8_t i = 0; i < taskCount; ++i)
+                tasks[i].stats = TaskStats();
+            statsStartMicros = nowMicros;
+        }
+};
+
+#endif
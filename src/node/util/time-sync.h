@@ -0,0 +1,171 @@
+#ifndef timesync_h
+#define timesync_h
+
+#include "rhtypes.h"
+
+#define TIME_SYNC_SAMPLES 8               // number of exchanges used by estimator
+#define TIME_SYNC_MIN_SKEW_SPAN_MS 4000   // node-time span needed before skew is estimated
+#define TIME_SYNC_MAX_SKEW_PPM 10000      // limit for skew (ceramic resonators can be off by 0.5%)
+#define TIME_SYNC_SKEW_ERR_PPM 50         // assumed skew error when computing confidence bound
+#define TIME_SYNC_BOUND_UNKNOWN 0xFFFF    // confidence bound value when not synchronized
+
+/**
+ * Estimates the offset and skew between node time (millis) and server time (ms)
+ * from timestamped request/response exchanges:
+ *   server sends request at t1, node receives it at n2,
+ *   node sends response at n3, server receives it at t4,
+ * where t4 is sent with the next request.  The offset is taken from the exchange
+ * with the smallest round trip (least affected by bus/USB delays) and the skew
+ * is the least-squares slope of the offsets across the recent exchanges.
+ */
+class TimeSync
+{
+    private:
+        struct Sample
+        {
+            mtime_t nodeTime;  // node time at middle of exchange
+            int32_t offset;    // server time minus node time
+            uint16_t roundTrip;
+        };
+        Sample samples[TIME_SYNC_SAMPLES];
+        uint8_t sampleCount = 0;
+        uint8_t nextSampleIdx = 0;  // oldest sample is replaced when full
+
+        uint32_t pendServerSendMs = 0;
+        mtime_t pendNodeRecvMs = 0;
+        mtime_t pendNodeSendMs = 0;
+        bool pendRespSentFlag = false;
+
+        mtime_t anchorNodeTime = 0;
+        int32_t anchorOffset = 0;
+        uint16_t anchorRoundTrip = 0;
+        int32_t skewPpm = 0;
+        bool syncedFlag = false;
+
+        void addSample(const Sample& s)
+        {
+            samples[nextSampleIdx] = s;
+            nextSampleIdx = (nextSampleIdx + 1) % TIME_SYNC_SAMPLES;
+            if (sampleCount < TIME_SYNC_SAMPLES)
+                ++sampleCount;
+            Sample best = samples[0];
+            for (uint8_t i = 1; i < sampleCount; ++i)
+            {
+                if (samples[i].roundTrip < best.roundTrip)
+                    best = samples[i];
+            }
+            anchorNodeTime = best.nodeTime;
+            anchorOffset = best.offset;
+            anchorRoundTrip = best.roundTrip;
+            syncedFlag = true;
+            updateSkew(best.roundTrip * 2 + 2);
+        }
+
+        // least-squares slope of offset vs node time, using exchanges with usable round trips
+        void updateSkew(uint16_t maxRoundTrip)
+        {
+            int64_t sumX = 0, sumY = 0;
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < sampleCount; ++i)
+            {
+                if (samples[i].roundTrip <= maxRoundTrip)
+                {
+                    sumX += (int32_t)(samples[i].nodeTime - anchorNodeTime);
+                    sumY += samples[i].offset - anchorOffset;
+                    ++count;
+                }
+            }
+            if (count < 3)
+                return;
+            int64_t meanX = sumX / count, meanY = sumY / count;
+            int64_t sxx = 0, sxy = 0;
+            int32_t minX = 0, maxX = 0;
+            for (uint8_t i = 0; i < sampleCount; ++i)
+            {
+                if (samples[i].roundTrip <= maxRoundTrip)
+                {
+                    int32_t x = (int32_t)(samples[i].nodeTime - anchorNodeTime);
+                    int64_t dx = x - meanX;
+                    sxx += dx * dx;
+                    sxy += dx * (samples[i].offset - anchorOffset - meanY);
+                    if (x < minX) minX = x;
+                    if (x > maxX) maxX = x;
+                }
+            }
+            if (maxX - minX < TIME_SYNC_MIN_SKEW_SPAN_MS || sxx == 0)
+                return;
+            int64_t ppm = sxy * 1000000 / sxx;
+            if (ppm > TIME_SYNC_MAX_SKEW_PPM)
+                ppm = TIME_SYNC_MAX_SKEW_PPM;
+            else if (ppm < -TIME_SYNC_MAX_SKEW_PPM)
+                ppm = -TIME_SYNC_MAX_SKEW_PPM;
+            skewPpm = (int32_t)ppm;
+        }
+
+    public:
+        // Called when sync request is received; 'prevServerRecvMs' is the server
+        //  time when the response to the previous request arrived (0 if it did not)
+        void requestReceived(uint32_t serverSendMs, uint32_t prevServerRecvMs, mtime_t nodeNowMs)
+        {
+            if (pendRespSentFlag && prevServerRecvMs != 0)
+            {
+                int32_t serverElapsed = (int32_t)(prevServerRecvMs - pendServerSendMs);
+                int32_t nodeElapsed = (int32_t)(pendNodeSendMs - pendNodeRecvMs);
+                if (serverElapsed >= nodeElapsed && serverElapsed - nodeElapsed <= 0xFFFF)
+                {
+                    Sample s;
+                    s.nodeTime = pendNodeRecvMs + nodeElapsed / 2;
+                    s.offset = ((int32_t)(pendServerSendMs - pendNodeRecvMs) +
+                                (int32_t)(prevServerRecvMs - pendNodeSendMs)) / 2;
+                    s.roundTrip = (uint16_t)(serverElapsed - nodeElapsed);
+                    addSample(s);
+                }
+            }
+            pendServerSendMs = serverSendMs;
+            pendNodeRecvMs = nodeNowMs;
+            pendRespSentFlag = false;
+        }
+
+        // Called when response to sync request is sent
+        void responseSent(mtime_t nodeNowMs)
+        {
+            pendNodeSendMs = nodeNowMs;
+            pendRespSentFlag = true;
+        }
+
+        bool isSynced() { return syncedFlag; }
+        mtime_t getRequestRecvTime() { return pendNodeRecvMs; }
+        int32_t getOffset() { return anchorOffset; }
+        int32_t getSkewPpm() { return skewPpm; }
+        uint8_t getSampleCount() { return sampleCount; }
+
+        // Converts node time to server time
+        uint32_t toServerTime(mtime_t nodeMs)
+        {
+            int32_t sinceAnchor = (int32_t)(nodeMs - anchorNodeTime);
+            return nodeMs + anchorOffset + (int32_t)((int64_t)sinceAnchor * skewPpm / 1000000);
+        }
+
+        // Converts server time to node time (inverse of 'toServerTime()')
+        mtime_t toNodeTime(uint32_t serverMs)
+        {
+            mtime_t nodeMs = serverMs - anchorOffset;
+            int32_t sinceAnchor = (int32_t)(nodeMs - anchorNodeTime);
+            return nodeMs - (int32_t)((int64_t)sinceAnchor * skewPpm / 1000000);
+        }
+
+        // Returns bound (in ms) on error of server time converted from given node time
+        uint16_t getBoundMs(mtime_t nodeMs)
+        {
+            if (!syncedFlag)
+                return TIME_SYNC_BOUND_UNKNOWN;
+            int32_t sinceAnchor = (int32_t)(nodeMs - anchorNodeTime);
+            if (sinceAnchor < 0)
+                sinceAnchor = -sinceAnchor;
+            uint32_t bound = (anchorRoundTrip + 1) / 2 + 1 +
+                    (uint32_t)((int64_t)sinceAnchor * TIME_SYNC_SKEW_ERR_PPM / 1000000);
+            return (bound < TIME_SYNC_BOUND_UNKNOWN) ? (uint16_t)bound : (uint16_t)(TIME_SYNC_BOUND_UNKNOWN - 1);
+        }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef zerophase_h
+#define zerophase_h
+
+#include "rhtypes.h"
+
+/**
+ * Keeps the most recent raw (unfiltered) samples so the pass peak can be
+ * located after the crossing with a zero-phase filter: a single-pole low-pass
+ * filter is run forward and then backward over the samples around the peak,
+ * which smooths without shifting the peak in time.  Samples are assumed to be
+ * evenly spaced (gaps are interpolated before samples are added, and the
+ * window is cleared after a resync).  Adding can be suspended ('freeze()')
+ * so the samples around the peak are not overwritten before the crossing ends.
+ * N is the window size and H is the number of samples filtered on each side
+ * of the peak.
+ */
+template <uint16_t N, uint8_t H> class ZeroPhaseWindow
+{
+    private:
+        rssi_t values[N];
+        uint16_t head = 0;  // next entry to write
+        uint16_t count = 0;
+        utime_t newestMicros = 0;
+        bool frozenFlag = false;
+
+        rssi_t valueAt(uint16_t i) { return values[(head + N - count + i) % N]; }
+
+    public:
+        static const uint8_t SCALE_SHIFT = 6;  // fixed-point scaling of filtered values
+
+        void clear()
+        {
+            head = count = 0;
+            frozenFlag = false;
+        }
+
+        void add(utime_t timeMicros, rssi_t rssi)
+        {
+            if (frozenFlag)
+                return;
+            values[head] = rssi;
+            head = (head + 1) % N;
+            if (count < N)
+                ++count;
+            newestMicros = timeMicros;
+        }
+
+        void freeze() { frozenFlag = true; }
+        void unfreeze() { frozenFlag = false; }
+        bool isFrozen() { return frozenFlag; }
+        uint16_t getCount() { return count; }
+
+        // Finds peak of zero-phase filtered samples within H samples of 'centerMicros'
+        //  ('alphaShift' sets filter time constant as 2^alphaShift samples); returns
+        //  false if the window does not hold H samples on both sides of center
+        bool refinePeak(utime_t centerMicros, utime_t periodMicros, uint8_t alphaShift,
+                        utime_t &peakMicros)
+        {
+            if (count == 0 || (int32_t)(newestMicros - centerMicros) < 0)
+                return false;
+            const utime_t ageSamples = (newestMicros - centerMicros + periodMicros / 2) / periodMicros;
+            if (ageSamples + H >= count || ageSamples < H)
+                return false;
+            const uint16_t first = count - 1 - ageSamples - H;
+
+            int16_t y[2 * H + 1];
+            int16_t acc = (int16_t)valueAt(first) << SCALE_SHIFT;
+            for (uint16_t i = 0; i <= 2 * H; ++i)
+            {
+                acc += (((int16_t)valueAt(first + i) << SCALE_SHIFT) - acc) >> alphaShift;
+                y[i] = acc;
+            }
+            for (int16_t i = 2 * H; i >= 0; --i)
+            {
+                acc += (y[i] - acc) >> alphaShift;
+                y[i] = acc;
+            }
+
+            uint16_t m = 1;
+            for (uint16_t i = 2; i < 2 * H; ++i)
+            {
+                if (y[i] > y[m])
+                    m = i;
+            }
+            uint16_t mEnd = m;  // handle flat top
+            while (mEnd + 1 < 2 * H && y[mEnd + 1] == y[m])
+                ++mEnd;
+            if (m == 1 || mEnd == 2 * H - 1)
+                return false;  // peak not within filtered samples
+
+            // parabolic interpolation through the max and its neighbors
+            const utime_t mMicros = newestMicros - (utime_t)(count - 1 - first - m) * periodMicros;
+            int32_t offsetMicros = 0;
+            if (mEnd == m)
+            {
+                const int32_t den = 2 * ((int32_t)y[m - 1] - 2 * (int32_t)y[m] + (int32_t)y[m + 1]);
+                if (den != 0)
+                    offsetMicros = ((int32_t)y[m - 1] - (int32_t)y[m + 1]) * (int32_t)periodMicros / den;
+            }
+            else
+                offsetMicros = (int32_t)((mEnd - m) * periodMicros / 2);
+            peakMicros = mMicros + offsetMicros;
+            return true;
+        }
+};
+
+#endif
@@ -36,6 +36,7 @@ class Crossing(dict):
     late_lap: bool = False
     invalid: bool = False
     peak_rssi: int|None = None
+    node_lap_id: int|None = None  # lap ID on node (for retrieving pass envelope)
     def __bool__(self):
         return True  # always evaluate object as 'True', even if underlying dict is empty
     def asdict(self):
@@ -404,12 +405,16 @@ class RHRace():
             if self._racecontext.cluster and self._racecontext.cluster.hasSecondaries():
                 self._racecontext.cluster.doClusterRaceStart()
 
+            # send race start time so nodes can report laps relative to it
+            self._racecontext.interface.set_race_epoch(self.start_time_monotonic)
+
             # set lower EnterAt/ExitAt values if configured
             if self._racecontext.serverconfig.get_item_int('TIMING', 'startThreshLowerAmount') > 0 and self._racecontext.serverconfig.get_item_int('TIMING', 'startThreshLowerDuration') > 0:
                 lower_amount = self._racecontext.serverconfig.get_item_int('TIMING', 'startThreshLowerAmount')
                 logger.info("Lowering EnterAt/ExitAt values at start of race, amount={0}%, duration={1} secs".\
                             format(lower_amount, self._racecontext.serverconfig.get_item_int('TIMING', 'startThreshLowerDuration')))
                 lower_end_time = self.start_time_monotonic + self._racecontext.serverconfig.get_item_int('TIMING', 'startThreshLowerDuration')
+                lowered_levels = []
                 for node in self._racecontext.interface.nodes:
                     if node.frequency > 0 and (self.format is self._racecontext.serverstate.secondary_race_format or node.current_pilot_id != RHUtils.PILOT_ID_NONE):
                         if node.current_rssi < node.enter_at_level:
@@ -423,14 +428,16 @@ class RHRace():
                                     node.start_thresh_lower_time = lower_end_time  # set time when values will be restored
                                     node.start_thresh_lower_flag = True
                                     # use 'transmit_' instead of 'set_' so values are not saved in node object
-                                    self._racecontext.interface.transmit_enter_at_level(node, new_enter_at)
-                                    self._racecontext.interface.transmit_exit_at_level(node, new_exit_at)
+                                    lowered_levels.append((node, new_enter_at, new_exit_at))
                             else:
                                 logger.info("Not lowering EnterAt/ExitAt values for node {0} because EnterAt value ({1}) unchanged"\
                                         .format(node.index+1, node.enter_at_level))
                         else:
                             logger.info("Not lowering EnterAt/ExitAt values for node {0} because current RSSI ({1}) >= EnterAt ({2})"\
                                     .format(node.index+1, node.current_rssi, node.enter_at_level))
+                # send all lowered values together (single broadcast per bus where supported)
+                if lowered_levels:
+                    self._racecontext.interface.transmit_enter_exit_levels(lowered_levels)
 
             # do non-blocking delay before time-critical code
             while (monotonic() < self.start_time_monotonic - 0.5):
@@ -949,6 +956,7 @@ class RHRace():
                                 lap_data.deleted = lap_late_flag  # delete if lap pass is after race winner declared
                                 lap_data.late_lap = lap_late_flag
                                 lap_data.peak_rssi = kwargs.get('peak', None)
+                                lap_data.node_lap_id = kwargs.get('node_lap_id', None)
 
                                 self.node_laps[node.index].append(lap_data)
 
@@ -1057,6 +1065,7 @@ class RHRace():
                                 lap_data.deleted = True
                                 lap_data.invalid = True
                                 lap_data.peak_rssi = kwargs.get('peak', None)
+                                lap_data.node_lap_id = kwargs.get('node_lap_id', None)
 
                                 self.node_laps[node.index].append(lap_data)
                         else:
@@ -168,6 +168,7 @@ class Evt:
     RACE_PILOT_DONE = 'racePilotDone'
     CROSSING_ENTER = 'crossingEnter'
     CROSSING_EXIT = 'crossingExit'
+    LAP_PROVISIONAL = 'lapProvisional' # pass reported before crossing ended (later confirmed or retracted)
     RACE_INITIAL_PASS = 'raceInitialPass'
     # Race management
     RACE_LAPS_REPLACE = 'raceLapsReplace'
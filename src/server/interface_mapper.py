@@ -56,6 +56,7 @@ class InterfaceMapper:
             ifmeta.interface.pass_record_callback = self.pass_record_callback
             ifmeta.interface.new_enter_or_exit_at_callback = self.new_enter_or_exit_at_callback
             ifmeta.interface.node_crossing_callback = self.node_crossing_callback
+            ifmeta.interface.provisional_pass_callback = self.provisional_pass_callback
 
     def reindex_nodes(self):
         for idx, node_map in enumerate(self._node_map):
@@ -94,6 +95,9 @@ class InterfaceMapper:
     def node_crossing_callback(self):
         pass
 
+    def provisional_pass_callback(self):
+        pass
+
     def start(self):
         for iface in self._interface_map:
             iface.interface.start()
@@ -117,6 +121,14 @@ class InterfaceMapper:
     def set_all_frequencies(self, freqs):
         '''do hardware update for frequencies'''
         logger.debug("Sending frequency values to all nodes: " + str(freqs["f"]))
+        # send values via broadcast where supported; 'set_frequency' below confirms them
+        bcast_freqs = {}
+        for idx, mapped_node in enumerate(self._node_map):
+            if hasattr(mapped_node.interface, 'broadcast_frequencies'):
+                bcast_freqs.setdefault(mapped_node.interface, []).append((mapped_node.index, freqs["f"][idx]))
+        for interface, node_freqs in bcast_freqs.items():
+            interface.broadcast_frequencies(node_freqs)
+
         for idx, node in enumerate(self.nodes):
             self.set_frequency(idx, freqs["f"][idx], freqs["b"][idx], freqs["c"][idx])
 
@@ -148,6 +160,27 @@ class InterfaceMapper:
                 return mapped_node.interface.transmit_enter_at_level(node, level)
         return None
 
+    def transmit_enter_exit_levels(self, node_levels):
+        '''Sends (node, enter_at, exit_at) values, batched per interface where supported.'''
+        intf_levels = {}
+        for node, enter_at, exit_at in node_levels:
+            for mapped_node in self._node_map:
+                if mapped_node.object is node:
+                    if hasattr(mapped_node.interface, 'transmit_enter_exit_levels'):
+                        intf_levels.setdefault(mapped_node.interface, []).append((node, enter_at, exit_at))
+                    else:
+                        mapped_node.interface.transmit_enter_at_level(node, enter_at)
+                        mapped_node.interface.transmit_exit_at_level(node, exit_at)
+                    break
+        for interface, levels in intf_levels.items():
+            interface.transmit_enter_exit_levels(levels)
+
+    def set_race_epoch(self, start_time_monotonic):
+        '''send race start time to interfaces that report laps relative to it'''
+        for iface in self._interface_map:
+            if hasattr(iface.interface, 'set_race_epoch'):
+                iface.interface.set_race_epoch(start_time_monotonic)
+
     def set_enter_at_level(self, node_index, level):
         mapped_node = self._node_map[node_index]
         local_index = mapped_node.index
@@ -164,6 +197,77 @@ class InterfaceMapper:
         local_index = mapped_node.index
         return mapped_node.interface.set_exit_at_level(local_index, level)
 
+    def start_node_calibration(self, node_index, seconds, apply_flag=True):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'start_node_calibration'):
+            return mapped_node.interface.start_node_calibration(mapped_node.index, seconds, apply_flag)
+        return False
+
+    def get_rssi_windows(self, node_index):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'get_rssi_windows'):
+            return mapped_node.interface.get_rssi_windows(mapped_node.index)
+        return None
+
+    def get_rssi_pyramid(self, node_index, tier, start_secs_ago=0, span_secs=None):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'get_rssi_pyramid'):
+            return mapped_node.interface.get_rssi_pyramid(mapped_node.index, tier, start_secs_ago, span_secs)
+        return None
+
+    def set_rssi_trace_mode(self, node_index, mode):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_rssi_trace_mode'):
+            return mapped_node.interface.set_rssi_trace_mode(mapped_node.index, mode)
+        return False
+
+    def get_pass_envelopes(self, node_index, lap_ids=None):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'get_pass_envelopes'):
+            return mapped_node.interface.get_pass_envelopes(mapped_node.index, lap_ids)
+        return None
+
+    def recompute_laps(self, node_index, enter_at, exit_at):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'recompute_laps'):
+            return mapped_node.interface.recompute_laps(mapped_node.index, enter_at, exit_at)
+        return None
+
+    def set_threshold_float(self, node_index, max_drift):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_threshold_float'):
+            return mapped_node.interface.set_threshold_float(mapped_node.index, max_drift)
+        return False
+
+    def set_history_prominence(self, node_index, level):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_history_prominence'):
+            return mapped_node.interface.set_history_prominence(mapped_node.index, level)
+        return False
+
+    def set_crossing_detector(self, node_index, engine, learn=False, **kwargs):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_crossing_detector'):
+            return mapped_node.interface.set_crossing_detector(mapped_node.index, engine, learn, **kwargs)
+        return False
+
+    def set_detector_template(self, node_index, points=None):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_detector_template'):
+            return mapped_node.interface.set_detector_template(mapped_node.index, points)
+        return False
+
+    def get_crossing_detector(self, node_index):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'get_crossing_detector'):
+            return mapped_node.interface.get_crossing_detector(mapped_node.index)
+        return None
+
+    def set_provisional_drop(self, node_index, level):
+        mapped_node = self._node_map[node_index]
+        if hasattr(mapped_node.interface, 'set_provisional_drop'):
+            mapped_node.interface.set_provisional_drop(mapped_node.index, level)
+
     def force_end_crossing(self, node_index):
         mapped_node = self._node_map[node_index]
         local_index = mapped_node.index
@@ -198,6 +198,7 @@ sys.path.append('/home/pi/RotorHazard/src/interface')  # Needed to run on startu
 
 from Plugins import search_modules  #pylint: disable=import-error
 from Sensors import Sensors  #pylint: disable=import-error
+from BaseHardwareInterface import BaseHardwareInterface  #pylint: disable=import-error
 import RHRace
 from RHRace import WinCondition, RaceStatus
 from data_export import DataExportManager
@@ -1166,6 +1167,88 @@ def on_cap_exit_at_btn(data):
     if RaceContext.interface.start_capture_exit_at_level(node_index):
         logger.info('Starting capture of exit-at level for node {0}'.format(node_index+1))
 
+@SOCKET_IO.on('node_calibrate')
+@catchLogExcWithDBWrapper
+def on_node_calibrate(data):
+    '''Capture RSSI statistics on node and apply suggested enter-at and exit-at levels.'''
+    node_index = data['node_index']
+    if not RaceContext.interface.start_node_calibration(node_index, data.get('seconds', 30), \
+                                                        data.get('apply', True)):
+        logger.info('Node calibration not supported for node {0}'.format(node_index+1))
+
+@SOCKET_IO.on('get_pass_envelopes')
+@catchLogExcWithDBWrapper
+def on_get_pass_envelopes(data):
+    '''Send RSSI envelopes of recent passes kept by node (optionally for given node lap IDs).'''
+    node_index = data['node_index']
+    envelopes = RaceContext.interface.get_pass_envelopes(node_index, data.get('lap_ids'))
+    emit('pass_envelopes', {
+        'node_index': node_index,
+        'envelopes': envelopes if envelopes is not None else []
+    })
+
+@SOCKET_IO.on('recompute_laps')
+@catchLogExcWithDBWrapper
+def on_recompute_laps(data):
+    '''Send passes found by replaying node heat history with given enter-at and exit-at levels.'''
+    node_index = data['node_index']
+    enter_at = int(data['enter_at'])
+    exit_at = int(data['exit_at'])
+    result = RaceContext.interface.recompute_laps(node_index, enter_at, exit_at)
+    payload = {
+        'node_index': node_index,
+        'enter_at': enter_at,
+        'exit_at': exit_at,
+        'supported': result is not None,
+        'laps': [],
+    }
+    if result is not None:
+        start_time = RaceContext.race.start_time_monotonic
+        payload['laps'] = [{
+                'lap_time_stamp': (p['timestamp'] - start_time) * 1000.0,
+                'peak_rssi': p['peak_rssi']
+            } for p in result['passes']]
+        payload['history_start'] = (result['history_start'] - start_time) * 1000.0
+        payload['truncated'] = result['truncated']
+    emit('recomputed_laps', payload)
+
+@SOCKET_IO.on('set_threshold_float')
+@catchLogExcWithDBWrapper
+def on_set_threshold_float(data):
+    '''Let node move enter-at and exit-at levels with its noise floor (0 = fixed levels).'''
+    node_index = data['node_index']
+    max_drift = int(data['max_drift'])
+    if RaceContext.interface.set_threshold_float(node_index, max_drift):
+        logger.info('Threshold float for node {0} set to {1}'.format(node_index+1, max_drift))
+
+@SOCKET_IO.on('set_history_prominence')
+@catchLogExcWithDBWrapper
+def on_set_history_prominence(data):
+    '''Set RSSI reversal that declares a node history peak/nadir (1 = every reversal).'''
+    node_index = data['node_index']
+    level = int(data['level'])
+    if RaceContext.interface.set_history_prominence(node_index, level):
+        logger.info('History prominence for node {0} set to {1}'.format(node_index+1, level))
+
+@SOCKET_IO.on('set_crossing_detector')
+@catchLogExcWithDBWrapper
+def on_set_crossing_detector(data):
+    '''Select node crossing detector (0 = enter-at/exit-at, 1 = matched filter) and send its state.'''
+    node_index = data['node_index']
+    engine = int(data['engine'])
+    kwargs = {}
+    for key in ('min_corr', 'min_rise'):
+        if key in data:
+            kwargs[key] = int(data[key])
+    if 'template' in data:
+        RaceContext.interface.set_detector_template(node_index, data['template'])
+    if RaceContext.interface.set_crossing_detector(node_index, engine, bool(data.get('learn', False)), **kwargs):
+        logger.info('Crossing detector for node {0} set to {1}'.format(node_index+1, engine))
+    emit('crossing_detector', {
+        'node_index': node_index,
+        'detector': RaceContext.interface.get_crossing_detector(node_index)
+    })
+
 @SOCKET_IO.on('set_scan')
 @catchLogExcWithDBWrapper
 def on_set_scan(data):
@@ -3094,6 +3177,19 @@ def node_crossing_callback(node):
                 else:
                     node.show_crossing_flag = True
 
+@catchLogExcWithDBWrapper
+def provisional_pass_callback(node):
+    # pass raised by node at peak detection; amended, confirmed or retracted before lap is recorded
+    if RaceContext.race.race_status == RaceStatus.RACING:
+        labels = BaseHardwareInterface.PROVISIONAL_STATUS_LABEL_STRS
+        Events.trigger(Evt.LAP_PROVISIONAL, {
+            'nodeIndex': node.index,
+            'status': labels[node.provisional_status] if node.provisional_status < len(labels) else 'unknown',
+            'lapTime': (node.provisional_timestamp - RaceContext.race.start_time_monotonic) * 1000.0,
+            'peakRssi': node.provisional_peak_rssi,
+            'color': RaceContext.race.seat_colors[node.index]
+            })
+
 def default_frequencies():
     '''Set node frequencies, R1367 for 4, IMD6C+ for 5+.'''
     if RaceContext.race.num_nodes < 5:
@@ -3407,6 +3503,7 @@ def initialize_rh_interface():
     RaceContext.interface.pass_record_callback = pass_record_callback
     RaceContext.interface.new_enter_or_exit_at_callback = new_enter_or_exit_at_callback
     RaceContext.interface.node_crossing_callback = node_crossing_callback
+    RaceContext.interface.provisional_pass_callback = provisional_pass_callback
     RaceContext.interface.add_callbacks()
     RaceContext.interface.reindex_nodes()
     return True